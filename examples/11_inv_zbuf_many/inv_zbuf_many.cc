@@ -24,6 +24,7 @@
 #include "lib/render/gl_object.h"
 #include "lib/render/cameras/gl_camera.h"
 #include "lib/render/gl_draw.h"
+#include "lib/render/gl_occlusion_queries.h"
 
 #include "../helpers.h"
 
@@ -120,6 +121,10 @@ int main(int argc, const char** argv)
   ZBuffer   zbuf (kWidth, kHeight);
   GlText    text {win};
 
+  // Cubes hidden in the previous frame are skipped
+
+  OcclusionQueries queries {};
+
   auto tris_base = triangles::MakeBaseContainer(1);
   auto tris_ptrs = triangles::MakePtrsContainer(1);
 
@@ -141,6 +146,7 @@ int main(int argc, const char** argv)
       object::Translate(cube, cube.world_pos_);
 
     objects::ResetAttributes(cubes);
+    occlusion_queries::Skip(queries, cubes);
     auto hidden = objects::RemoveHiddenSurfaces(cubes, cam);
     
     objects::ComputeFaceNormals(cubes);
@@ -162,6 +168,7 @@ int main(int argc, const char** argv)
     buf.Clear();
     zbuf.Clear();
     draw_triangles::Solid(tris_ptrs, zbuf, buf);
+    occlusion_queries::Query(queries, zbuf, cam, cubes);
     buf.SendDataToFB();
     fps.Count();
 
@@ -172,7 +179,10 @@ int main(int argc, const char** argv)
     {
       std::cerr << "Frames per second: " << fps.ReadPrev() << '\n';
       std::cerr << "Objects culled: " << culled << '\n';
-      std::cerr << "Hidden surface: " << hidden << "\n\n";
+      std::cerr << "Hidden surface: " << hidden << '\n';
+      std::cerr << "Occlusion queries: " << queries.queries_ << '\n';
+      std::cerr << "Objects occluded: " << queries.culled_ << '\n';
+      std::cerr << "False occluded rate: " << queries.FalseRate() << "\n\n";
     }
 
   } while (!win.Closed());
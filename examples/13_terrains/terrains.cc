@@ -305,6 +305,7 @@ int main(int argc, const char** argv)
       obj_culled += object::CullX(chunk, cam, trig);
       obj_culled += object::CullY(chunk, cam, trig);
     }
+    obj_culled += terrain.CullByHorizon(cam.vrp_);
 
     terrain.ProcessDetalization(cam.vrp_);
     
@@ -22,7 +22,7 @@
 
 #include "lib/render/gl_render_ctx.h"
 #include "lib/render/gl_draw.h"
-#include "lib/render/gl_text.h"
+#include "lib/render/fx_text.h"
 #include "lib/render/gl_lights.cc"
 #include "lib/render/gl_coords.h"
 #include "lib/render/gl_object.h"
@@ -37,7 +37,7 @@ using namespace anshub;
 using namespace helpers;
 
 void PrintInfo(
-  GlText& text, FpsCounter& fps, 
+  SoftText& text, FpsCounter& fps, 
   const Vector& obj_pos, const Vector& obj_rot, 
   const Vector& cam_pos, const Vector& cam_rot,
   int nfo_culled, int nfo_hidden, const RenderContext& ctx)
@@ -157,7 +157,8 @@ int main(int argc, const char** argv)
   render_ctx.mipmap_dist_ = 200.0f;
   render_ctx.clarity_  = camman.GetCurrentCamera().z_far_;
 
-  GlText  text {win};
+  SoftText text {};
+  render_ctx.text_ = &text;
   Vector  obj_rot {0.0f, 0.0f, 0.0f};
 
   auto tris_base = triangles::MakeBaseContainer(0);
@@ -212,12 +213,11 @@ int main(int argc, const char** argv)
     triangles::Camera2Persp(tris_base, cam);
     triangles::Persp2Screen(tris_base, cam);
 
-    render::Context(tris_ptrs, render_ctx);
-    
     PrintInfo(
       text, fps, obj.world_pos_, obj_rot,
       cam.vrp_, cam.dir_, culled, hidden, render_ctx
     );
+    render::Context(tris_ptrs, render_ctx);
     fps.Count();
 
     win.Render();
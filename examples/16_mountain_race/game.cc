@@ -33,9 +33,11 @@ void PrintDebug(FpsCounter& fps, const Level&, const Scene& scene)
 {
   std::cerr << "Frames per second: " << fps.ReadPrev() << '\n';
   std::cerr << "Chunks culled: " << scene.GetObjectsCulled() << '\n';
+  std::cerr << "Objects occluded: " << scene.GetObjectsOccluded() << '\n';
   std::cerr << "Hidden surfaces: " << scene.GetSurfacesHidden() << '\n';
   std::cerr << "Triangles total: " << scene.GetTrianglesCount() << '\n';
   std::cerr << "Triangles culled: " << scene.GetTrianglesCulled() << '\n';   
+  std::cerr << "Triangles split: " << scene.GetTrianglesSplit() << '\n';
   std::cerr << '\n';
 }
 
@@ -44,6 +44,9 @@ Level::Level(const Config& cfg)
       cfg.Get<std::string>("ter_sky").c_str(),
       cfg.Get<Vector>("cam_pos")
   }
+  , sky_cube_{
+      cfg.Get<int>("ter_sky_cube")
+  }
   , terrain_{
       cfg.Get<std::string>("ter_hm").c_str(),
       cfg.Get<std::string>("ter_tx").c_str(),
@@ -57,6 +60,13 @@ Level::Level(const Config& cfg)
       color::fOceanBlue,
       Shading::GOURAUD
   }
+  , water_refl_{
+      cfg.Get<int>("win_w"),
+      cfg.Get<int>("win_h"),
+      cfg.Get<int>("ter_water_div"),
+      cfg.Get<float>("ter_water_lvl"),
+      cfg.Get<float>("ter_water_refl")
+  }
   , trees_{
       cfg.Get<std::string>("ter_objs"),
       0.5f,                         //  todo: magic (scale)
@@ -78,6 +88,7 @@ Level::Level(const Config& cfg)
   
   , lights_all_{}
   , lights_sky_{}
+  , post_{}
   , render_ctx_{
       cfg.Get<int>("win_w"),
       cfg.Get<int>("win_h"),
@@ -87,6 +98,7 @@ Level::Level(const Config& cfg)
       cfg.Get<int>("ter_bvh_depth"),
       cfg.Get<float>("ter_world_size"),    
   }
+  , trees_bounds_{}
 {
   InitAudio(cfg);
   InitCamera(cfg);
@@ -98,9 +110,12 @@ Level::Level(const Config& cfg)
   SetupNature(cfg);
   
   SetupLights(cfg);
+  SetupSkyCube(cfg);
   SetupRenderContext(cfg);
+  SetupReflection(cfg);
+  SetupPostprocess(cfg);
 
-  for (auto& tree : trees_.GetObjects())
+  for (auto& tree : trees_bounds_)
     bvh_tree_.Insert(tree);
 
   for (auto& blob : rain_.GetObjects())
@@ -209,9 +224,21 @@ void Level::SetupSkybox(const Config&)
   object::Rotate(skybox_, {90.0f, 0.0f, 0.0f}, trig_);   // todo: magic
 }
 
+// Bakes lighted skybox to cube map, which is drawn by per pixel pass instead
+// of skybox triangles
+
+void Level::SetupSkyCube(const Config&)
+{
+  light::Object(skybox_, lights_sky_);
+  sky_cube_ = SkyCube{skybox_, sky_cube_.size_};
+  render_ctx_.sky_ = &sky_cube_;
+}
+
 void Level::SetupTerrain(const Config& cfg)
 {
   terrain_.SetDetalization(cfg.Get<Config::V_Float>("ter_detaliz"));
+  for (auto& chunk : terrain_.GetChunks())
+    object::MakeStreams(chunk);
 }
 
 void Level::SetupTrees(const Config&)
@@ -221,8 +248,15 @@ void Level::SetupTrees(const Config&)
   trees_.SetObjects<NatureTypes>(nature_list);
   trees_.RecognizeObjects();
 
+  // Trees are instances of shared meshes, thus collisions are checked with
+  // bounds objects without geometry
+
   for (auto& tree : trees_.GetObjects())
-    tree.sphere_rad_ = 2.0f;  // todo: magic
+  {
+    trees_bounds_.emplace_back();
+    trees_bounds_.back().world_pos_ = tree.world_pos_;
+    trees_bounds_.back().sphere_rad_ = 2.0f;  // todo: magic
+  }
 
   // Note - we make small radius to prevent unnecessary collisions, since
   // trees are tall hence bounding sphere in very big, and we will get
@@ -247,6 +281,38 @@ void Level::SetupRenderContext(const Config& cfg)
   render_ctx_.is_mipmapping_ = true;
   render_ctx_.mipmap_dist_ = 240.0f;    // todo: magic
   render_ctx_.clarity_  = cfg.Get<float>("cam_clarity");
+  render_ctx_.affine_ratio_ = cfg.Get<float>("cam_affine_ratio");
+}
+
+// Turns on low resolution reflection of the scene in the water if its far
+// plane is not zero
+
+void Level::SetupReflection(const Config&)
+{
+  if (water_refl_.far_z_ <= 0.0f)
+    return;
+
+  auto& ctx = water_refl_.ctx_;
+  ctx.is_zbuf_ = true;
+  ctx.is_mipmapping_ = render_ctx_.is_mipmapping_;
+  ctx.mipmap_dist_ = render_ctx_.mipmap_dist_;
+  ctx.clarity_ = render_ctx_.clarity_;
+  ctx.sky_ = render_ctx_.sky_;
+  water_.reflection_ = &ctx.sbuf_;
+}
+
+// Turns on post processing chain, which is processed by all cores
+
+void Level::SetupPostprocess(const Config& cfg)
+{
+  post_.is_bloom_ = cfg.Get<bool>("fx_bloom");
+  post_.is_grading_ = cfg.Get<bool>("fx_grading");
+  post_.is_vignette_ = cfg.Get<bool>("fx_vignette");
+  post_.is_fxaa_ = cfg.Get<bool>("fx_fxaa");
+  post_.threads_ = Workers::Shared().Count();
+  if (post_.is_bloom_ || post_.is_grading_ ||
+      post_.is_vignette_ || post_.is_fxaa_)
+    render_ctx_.post_ = &post_;
 }
 
 void Level::SetupLights(const Config& cfg)
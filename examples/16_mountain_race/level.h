@@ -15,6 +15,8 @@
 
 #include "lib/render/gl_bvh.h"
 #include "lib/render/fx_colors.h"
+#include "lib/render/fx_sky.h"
+#include "lib/render/fx_reflection.h"
 #include "lib/render/gl_lights.h"
 #include "lib/render/gl_render_ctx.h"
 #include "lib/render/cameras/gl_camera.h"
@@ -48,16 +50,20 @@ struct Level
   Player player_;
   CameraFol& follow_cam_;
   Skybox skybox_;
+  SkyCube sky_cube_;
   Terrain terrain_;
   Water water_;
+  Reflection water_refl_;
   Nature trees_;
   Nature nature_;
   Rain rain_;
 
   Lights lights_all_;
   Lights lights_sky_;
+  PostContext post_;
   RenderContext render_ctx_;
   Bvh bvh_tree_;
+  V_GlObject trees_bounds_;     // collision bounds of trees
 
 private:
 
@@ -66,11 +72,14 @@ private:
   void InitPlayer(const Config&);
   void InitFollowing(const Config&);
   void SetupSkybox(const Config&);
+  void SetupSkyCube(const Config&);
   void SetupTerrain(const Config&);
   void SetupTrees(const Config&);
   void SetupNature(const Config&);
   void SetupLights(const Config&);
   void SetupRenderContext(const Config&);
+  void SetupReflection(const Config&);
+  void SetupPostprocess(const Config&);
 
 }; // struct Level 
 
@@ -58,6 +58,9 @@ void Logic::ProcessSystemInput(Btn kbtn)
 
 void Logic::ProcessTreesCollisions()
 {
+  for (auto& tree : level_.trees_bounds_)
+    object::ResetAttributes(tree);
+
   auto collisions = level_.bvh_tree_.FindCollision(level_.player_);
   
   if (!collisions.empty())
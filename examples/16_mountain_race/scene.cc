@@ -12,49 +12,88 @@ namespace anshub {
 Scene::Scene(const Config&, GlWindow& win, Level& level)
   : win_{win}
   , level_{level}
-  , tris_base_{triangles::MakeBaseContainer(0)}
-  , tris_sky_{triangles::MakeBaseContainer(0)}
-  , tris_ptrs_{triangles::MakePtrsContainer(0)}
+  , tris_base_{triangles::MakeBaseContainer(kBaseCapacity)}
+  , tris_sky_{triangles::MakeBaseContainer(kSkyCapacity)}
+  , tris_near_{triangles::MakeBaseContainer(kNearCapacity)}
+  , tris_ptrs_{triangles::MakePtrsContainer(kBaseCapacity)}
+  , wired_objs_{}
+  , wired_nature_{}
+  , sorter_{0}
+  , vxs_marks_{}
+  , wired_index_{}
+  , wired_faces_{}
+  , main_lods_{}
+  , main_active_{}
+  , occluders_{}
+  , spheres_trees_{}
+  , spheres_nature_{}
+  , spheres_chunks_{}
+  , spheres_rain_{}
   , hidden_surfaces_{0}
   , objects_culled_{0}
+  , objects_occluded_{0}
   , triangles_culled_{0}
-{ }
+  , triangles_split_{0}
+{
+  spheres::Gather(level_.trees_.GetObjects(), spheres_trees_);
+  spheres::Gather(level_.nature_.GetObjects(), spheres_nature_);
+  spheres::Gather(level_.terrain_.GetChunks(), spheres_chunks_);
+}
 
 // Builds scenes for further rendering
 
 void Scene::Build(float factor)
 {
+  auto& cam_curr  = level_.camman_.GetCurrentCamera();
+  auto  cam_state = level_.camman_.GetState(CamState::WIRED_MODE);
+  cam_curr.UpdateFrustum();
+
+  if (level_.water_.reflection_ && !cam_state &&
+      reflection::NeedsUpdate(level_.water_refl_, cam_curr))
+    BuildReflection(cam_curr);
+
   hidden_surfaces_ = 0;
   objects_culled_ = 0;
+  objects_occluded_ = 0;
   triangles_culled_ = 0;
-  
-  auto& cam_curr  = level_.camman_.GetCurrentCamera();
-  auto  cam_state = level_.camman_.GetState(CamState::WIRED_MODE);
+  triangles_split_ = 0;
 
   BuildPlayer(cam_curr);
-  BuildSkybox(cam_curr);
+  if (!level_.render_ctx_.sky_)
+    BuildSkybox(cam_curr);
   BuildWater(cam_curr);
   BuildNature(cam_curr);
   BuildRain(cam_curr);
-  BuildTerrain(cam_curr);
-
-  MakeTriangles();
-  ProcessTriangles(cam_curr);
+  BuildTerrain(cam_curr, true);
+  CullOccluded(cam_curr);
 
   level_.render_ctx_.is_wired_ = cam_state;
+  level_.render_ctx_.cam_ = &cam_curr;
+  if (cam_state)
+  {
+    MakeWiredObjects(cam_curr);
+    render::Wired(wired_objs_, level_.render_ctx_);
+    return;
+  }
+
+  MakeTriangles(cam_curr);
+  ProcessTriangles(cam_curr, level_.render_ctx_);
   render::Context(tris_ptrs_, level_.render_ctx_);
 }
 
-// Builds player
+// Builds player. Player is rotated every frame, thus faces normals are
+// rotated from local coords by the orientation vectors
 
 void Scene::BuildPlayer(const GlCamera& cam)
 {
-  level_.player_.ProcessView();
-
-  object::Translate(level_.player_, level_.player_.world_pos_);
-  object::ResetAttributes(level_.player_);
-  object::ComputeFaceNormals(level_.player_, true);
-  hidden_surfaces_ += object::RemoveHiddenSurfaces(level_.player_, cam);
+  auto& player = level_.player_;
+  player.ProcessView();
+
+  object::Translate(player, player.world_pos_);
+  object::ResetAttributes(player);
+  object::RefreshFaceNormals(
+    player, player.v_orient_x_, player.v_orient_y_, player.v_orient_z_);
+  hidden_surfaces_ += object::RemoveHiddenSurfaces(player, cam);
 }
 
 // Builds skybox
@@ -79,7 +118,7 @@ void Scene::BuildWater(const GlCamera& cam)
   level_.water_.CopyCoords(Coords::LOCAL, Coords::TRANS);
   object::Translate(level_.water_, level_.water_.world_pos_);
   object::ResetAttributes(level_.water_);
-  object::ComputeFaceNormals(level_.water_, true);
+  object::RefreshFaceNormals(level_.water_);
   object::RemoveHiddenSurfaces(level_.water_, cam);
   object::CullZ(level_.water_, cam, level_.trig_);
   object::CullX(level_.water_, cam, level_.trig_);
@@ -87,36 +126,39 @@ void Scene::BuildWater(const GlCamera& cam)
   object::VerticesNormals2Camera(level_.water_, cam, level_.trig_);
 }
 
-// Builds nature
+// Builds nature. Instances are culled by bounding spheres all at once, and
+// then only visible instances are processed by AddNature()
 
 void Scene::BuildNature(const GlCamera& cam)
 {
   auto& trees = level_.trees_.GetObjects();
-  
-  for (auto& obj : trees) {
-    obj.SetCoords(Coords::TRANS);
-    obj.CopyCoords(Coords::LOCAL, Coords::TRANS);
-    object::Translate(obj, obj.world_pos_);
-    object::ResetAttributes(obj);
-    object::ComputeFaceNormals(obj, true);
-    object::RemoveHiddenSurfaces(obj, cam);
-    objects_culled_ += object::CullZ(obj, cam, level_.trig_);
-    objects_culled_ += object::CullX(obj, cam, level_.trig_);
-    objects_culled_ += object::CullY(obj, cam, level_.trig_);
-  }
-  
   auto& nature = level_.nature_.GetObjects();
 
-  for (auto& obj : nature) {
-    obj.SetCoords(Coords::TRANS);
-    obj.CopyCoords(Coords::LOCAL, Coords::TRANS);
-    object::Translate(obj, obj.world_pos_);
-    object::ResetAttributes(obj);
-    object::ComputeFaceNormals(obj, true);
-    object::RemoveHiddenSurfaces(obj, cam);
-    objects_culled_ += object::CullZ(obj, cam, level_.trig_);
-    objects_culled_ += object::CullX(obj, cam, level_.trig_);
-    objects_culled_ += object::CullY(obj, cam, level_.trig_);
+  spheres::Cull(spheres_trees_, cam);
+  spheres::Cull(spheres_nature_, cam);
+  objects_culled_ += spheres::Apply(spheres_trees_, trees);
+  objects_culled_ += spheres::Apply(spheres_nature_, nature);
+}
+
+// Makes triangles from visible nature instances. Since instances share mesh,
+// each one is built in the mesh and converted to triangles before the next
+// one. Level of detail of mesh is chosen by projected size of instance, then
+// faces are culled by clusters and back faces are removed in local coords,
+// thus only vertices of remaining faces are moved to the world
+
+void Scene::AddNature(const GlCamera& cam)
+{
+  for (auto* arr : {&level_.trees_.GetObjects(), &level_.nature_.GetObjects()})
+  {
+    for (auto& obj : *arr)
+    {
+      if (!obj.active_)
+        continue;
+      obj.lod_ = lods::Select(cam, obj.world_pos_, obj.sphere_rad_, obj.lod_,
+                              obj.mesh_->lods_.size());
+      instance::Build(obj, cam, level_.trig_, vxs_marks_);
+      instance::AddTriangles(obj, tris_base_);
+    }
   }
 }
 
@@ -125,61 +167,179 @@ void Scene::BuildNature(const GlCamera& cam)
 void Scene::BuildRain(const GlCamera& cam)
 {
   auto& blobs = level_.rain_.GetObjects();
+  spheres::Gather(blobs, spheres_rain_);
+  spheres::Cull(spheres_rain_, cam);
+  spheres::Apply(spheres_rain_, blobs);
+
   for (auto& blob : blobs)
   {
-    blob.SetCoords(Coords::TRANS);      
-    blob.CopyCoords(Coords::LOCAL, Coords::TRANS);
+    if (!blob.active_)
+      continue;
     object::ResetAttributes(blob);
-    object::ComputeFaceNormals(blob, true);
-    object::RemoveHiddenSurfaces(blob, cam);
-    object::Translate(blob, blob.world_pos_);
-    object::CullZ(blob, cam, level_.trig_);
-    object::CullX(blob, cam, level_.trig_);
-    object::CullY(blob, cam, level_.trig_);
-  } 
+    object::RemoveHiddenSurfacesLocal(blob, cam);
+    object::TranslateVisible(blob, vxs_marks_);
+    object::RefreshFaceNormals(blob);
+  }
 }
 
-// Builds terrain
+// Builds terrain. Chunks hidden by nearer chunks may be culled by horizon
+// before their faces are processed
 
-void Scene::BuildTerrain(const GlCamera& cam)
-{ 
+void Scene::BuildTerrain(const GlCamera& cam, bool by_horizon)
+{
   auto& chunks = level_.terrain_.GetChunks();
-  for (auto& chunk : chunks)
+  spheres::Cull(spheres_chunks_, cam);
+  objects_culled_ += spheres::Apply(spheres_chunks_, chunks);
+
+  if (by_horizon)
   {
-    object::ResetAttributes(chunk);
-    objects_culled_ += object::CullZ(chunk, cam, level_.trig_);
-    objects_culled_ += object::CullX(chunk, cam, level_.trig_);
-    objects_culled_ += object::CullY(chunk, cam, level_.trig_);
+    objects_occluded_ += level_.terrain_.CullByHorizon(cam.vrp_);
+    for (std::size_t i = 0; i < chunks.size(); ++i)
+      spheres_chunks_.visible_[i] = chunks[i].active_;
   }
-  
+
   for (auto& chunk : chunks)
   {
     if (!chunk.active_)
       continue;
 
+    // Positions of chunks are transformed in streams, thus faces are
+    // processed in local coords (which are world coords for terrain)
+
+    object::ResetAttributes(chunk);
+    chunk.SetCoords(Coords::LOCAL);
+    triangles_culled_ += clusters::Cull(
+      chunk.clusters_, chunk.faces_, cam, Vector{0.0f, 0.0f, 0.0f});
+    object::RefreshFaceNormals(chunk);
+    hidden_surfaces_ += object::RemoveHiddenSurfaces(chunk, cam);
+
     chunk.CopyCoords(Coords::LOCAL, Coords::TRANS);
     chunk.SetCoords(Coords::TRANS);
+  }
+}
 
-    object::ComputeFaceNormals(chunk, true);
-    hidden_surfaces_ += object::RemoveHiddenSurfaces(chunk, cam);
-    object::VerticesNormals2Camera(chunk, cam, level_.trig_);
+// Culls terrain chunks and nature instances hidden by terrain. Visible faces
+// of chunks are rasterized into low resolution buffer, then bounding spheres
+// of objects which are passed frustum culling are tested against it (chunk
+// can`t hide itself, since its faces are behind the nearest point of its
+// bounding sphere). Should be called after BuildNature() and BuildTerrain()
+
+void Scene::CullOccluded(const GlCamera& cam)
+{
+  auto& chunks = level_.terrain_.GetChunks();
+  auto& trees = level_.trees_.GetObjects();
+  auto& nature = level_.nature_.GetObjects();
+
+  occlusion::Clear(occluders_, cam);
+  for (auto& chunk : chunks)
+  {
+    if (chunk.active_)
+      occlusion::AddOccluder(
+        occluders_, chunk.vxs_local_, chunk.faces_, chunk.edges_);
   }
+
+  objects_occluded_ += occlusion::Cull(occluders_, spheres_chunks_);
+  objects_occluded_ += occlusion::Cull(occluders_, spheres_trees_);
+  objects_occluded_ += occlusion::Cull(occluders_, spheres_nature_);
+  spheres::Apply(spheres_chunks_, chunks);
+  spheres::Apply(spheres_trees_, trees);
+  spheres::Apply(spheres_nature_, nature);
 }
 
-// Makes triangles from objects
+// Renders the scene seen by the camera mirrored about the water plane to
+// the reflection buffer. Player and rain are too small to be visible in
+// the low resolution image and are skipped. State of objects used by the
+// main pass is restored after
 
-void Scene::MakeTriangles()
+void Scene::BuildReflection(const GlCamera& cam)
 {
+  auto& refl = level_.water_refl_;
+  auto  mirror = reflection::MirrorCamera(refl, cam);
+  SaveMainState();
+
+  // Horizon isn`t used, since terrain under the water isn`t reflected, but
+  // may hide chunks
+
+  BuildNature(mirror);
+  BuildTerrain(mirror, false);
+  if (!refl.ctx_.sky_)
+    BuildSkybox(mirror);
+
   tris_base_.resize(0);
   tris_ptrs_.resize(0);
   tris_sky_.resize(0);
-  
-  auto& chunks = level_.terrain_.GetChunks();
-  for (auto& chunk : chunks)
+
+  AddNature(mirror);
+  reflection::CullBelow(refl, tris_base_);
+  for (auto& chunk : level_.terrain_.GetChunks())
   {
-    if (chunk.active_)
-      triangles::AddFromObject(chunk, tris_base_);
+    chunk.SetCoords(Coords::LOCAL);
+    reflection::CullBelow(refl, chunk);
+    chunk.SetCoords(Coords::TRANS);
+  }
+
+  ProcessTriangles(mirror, refl.ctx_);
+  reflection::Render(refl, tris_ptrs_, cam, mirror);
+  RestoreMainState();
+}
+
+// Saves state of objects which is changed by the reflection pass, but is
+// read by the main pass (levels of detail are chosen with hysteresis by the
+// previous level, and visibility of instances and chunks)
+
+void Scene::SaveMainState()
+{
+  main_lods_.resize(0);
+  main_active_.resize(0);
+  for (auto* arr : {&level_.trees_.GetObjects(), &level_.nature_.GetObjects()})
+  {
+    for (auto& obj : *arr)
+    {
+      main_lods_.push_back(obj.lod_);
+      main_active_.push_back(obj.active_);
+    }
+  }
+  for (auto& chunk : level_.terrain_.GetChunks())
+    main_active_.push_back(chunk.active_);
+}
+
+// Restores state saved by SaveMainState(), and visibility of bounding
+// spheres by restored objects
+
+void Scene::RestoreMainState()
+{
+  std::size_t k {0};
+  for (auto* arr : {&level_.trees_.GetObjects(), &level_.nature_.GetObjects()})
+  {
+    for (auto& obj : *arr)
+    {
+      obj.lod_ = main_lods_[k];
+      obj.active_ = main_active_[k++];
+    }
   }
+  auto& chunks = level_.terrain_.GetChunks();
+  for (auto& chunk : chunks)
+    chunk.active_ = main_active_[k++];
+
+  auto& trees = level_.trees_.GetObjects();
+  auto& nature = level_.nature_.GetObjects();
+  for (std::size_t i = 0; i < trees.size(); ++i)
+    spheres_trees_.visible_[i] = trees[i].active_;
+  for (std::size_t i = 0; i < nature.size(); ++i)
+    spheres_nature_.visible_[i] = nature[i].active_;
+  for (std::size_t i = 0; i < chunks.size(); ++i)
+    spheres_chunks_.visible_[i] = chunks[i].active_;
+}
+
+// Makes triangles from objects
+
+void Scene::MakeTriangles(const GlCamera& cam)
+{
+  tris_base_.resize(0);
+  tris_ptrs_.resize(0);
+  tris_sky_.resize(0);
+
+  // Terrain chunks are added in ProcessTriangles() by post-transform path
 
   auto& blobs = level_.rain_.GetObjects();
   for (auto& blob : blobs)
@@ -187,43 +347,201 @@ void Scene::MakeTriangles()
     if (blob.active_)
       triangles::AddFromObject(blob, tris_base_);
   }
-  triangles::AddFromObjects(level_.trees_.GetObjects(), tris_base_);
-  triangles::AddFromObjects(level_.nature_.GetObjects(), tris_base_);
+  AddNature(cam);
 
   triangles::AddFromObject(level_.water_, tris_base_);
   triangles::AddFromObject(level_.player_, tris_base_);
 }
 
-// Processes triangles throught render pipeline
+// Makes list of objects to draw in wired mode (skybox is skipped). Nature
+// instances are built in shared meshes, thus only vertices, faces and edges
+// of visible part of each instance are copied. Copies are kept between
+// frames to reuse their memory, and extra ones are released when count of
+// visible instances falls down
 
-void Scene::ProcessTriangles(const GlCamera& cam)
+void Scene::MakeWiredObjects(const GlCamera& cam)
 {
-  triangles::World2Camera(tris_base_, cam, level_.trig_);
+  wired_objs_.resize(0);
+
+  for (auto& chunk : level_.terrain_.GetChunks())
+  {
+    object::SyncStreams(chunk);       // wired mode uses world coords
+    wired_objs_.push_back(&chunk);
+  }
+  for (auto& blob : level_.rain_.GetObjects())
+    wired_objs_.push_back(&blob);
+
+  std::size_t count {0};
+  for (auto* arr : {&level_.trees_.GetObjects(), &level_.nature_.GetObjects()})
+  {
+    for (auto& obj : *arr)
+    {
+      if (!obj.active_)
+        continue;
+      obj.lod_ = lods::Select(cam, obj.world_pos_, obj.sphere_rad_, obj.lod_,
+                              obj.mesh_->lods_.size());
+      instance::Build(obj, cam, level_.trig_, vxs_marks_);
+
+      if (count == wired_nature_.size())
+        wired_nature_.emplace_back();
+      CopyWired(*obj.mesh_, wired_nature_[count++]);
+    }
+  }
+  if (wired_nature_.size() > 2 * count)
+    wired_nature_.resize(count);
+  for (std::size_t i = 0; i < count; ++i)
+    wired_objs_.push_back(&wired_nature_[i]);
+
+  wired_objs_.push_back(&level_.water_);
+  wired_objs_.push_back(&level_.player_);
+}
+
+// Copies active faces of mesh built by instance::Build(), their vertices
+// (marked in vxs_marks_) and edges into the object for render::Wired().
+// Indices are renumbered, and active face of edge is made the first one
+
+void Scene::CopyWired(const GlObject& mesh, GlObject& copy)
+{
+  auto& index = wired_index_;
+  index.assign(mesh.vxs_trans_.size(), -1);
+  copy.vxs_trans_.clear();
+  for (std::size_t i = 0; i < mesh.vxs_trans_.size(); ++i)
+  {
+    if (!vxs_marks_[i])
+      continue;
+    index[i] = copy.vxs_trans_.size();
+    copy.vxs_trans_.push_back(mesh.vxs_trans_[i]);
+  }
+
+  auto& faces = wired_faces_;
+  faces.assign(mesh.faces_.size(), -1);
+  copy.faces_.clear();
+  for (std::size_t i = 0; i < mesh.faces_.size(); ++i)
+  {
+    const auto& face = mesh.faces_[i];
+    if (!face.active_)
+      continue;
+    faces[i] = copy.faces_.size();
+    copy.faces_.push_back(face);
+    auto& dst = copy.faces_.back();
+    dst[0] = index[face[0]];
+    dst[1] = index[face[1]];
+    dst[2] = index[face[2]];
+  }
+
+  copy.edges_.clear();
+  for (const auto& edge : mesh.edges_)
+  {
+    int f1 = faces[edge.face_1_];
+    int f2 = edge.face_2_ < 0 ? -1 : faces[edge.face_2_];
+    if (f1 < 0)
+      std::swap(f1, f2);
+    if (f1 < 0)
+      continue;
+    copy.edges_.push_back(
+      MeshEdge{index[edge.v1_], index[edge.v2_], f1, f2});
+  }
+  copy.SetCoords(Coords::TRANS);
+  copy.active_ = true;
+}
+
+// Processes triangles throught render pipeline. Terrain chunks vertices are
+// lighted once in world coordinates, then are projected by one matrix and
+// converted to triangles (see note #2 in gl_triangle.cc). Normals of other
+// triangles are taken from faces and are normalized already
+
+void Scene::ProcessTriangles(const GlCamera& cam, const RenderContext& ctx)
+{
+  triangles::World2Camera(tris_base_, cam, level_.trig_, true);
   triangles_culled_ += triangles::CullAndClip(tris_base_, cam);
-  triangles::ComputeNormals(tris_base_);
-  
+  triangles::ComputeNormalsAbsent(tris_base_);
+
+  // Light terrain in world coordinates (point light is car`s, thus it is
+  // given in camera coordinates)
+
+  auto& chunks = level_.terrain_.GetChunks();
+  auto& lights = level_.lights_all_;
+
+  if (!lights.point_.empty())
+    lights.point_.front().Camera2World(cam, level_.trig_);
+  for (auto& chunk : chunks)
+  {
+    if (!chunk.active_)
+      continue;
+    object::SyncStreams(chunk);
+    light::Object(chunk, lights);
+  }
+  light::Reset(lights);
+
   // Convert all lights but point to camera coordinates (since point is car`s)
 
-  light::World2Camera(level_.lights_all_, cam, level_.trig_);
-  if (!level_.lights_all_.point_.empty())
-    level_.lights_all_.point_.front().Reset();
+  light::World2Camera(lights, cam, level_.trig_);
+  if (!lights.point_.empty())
+    lights.point_.front().Reset();
 
-  light::Triangles(tris_base_, level_.lights_all_);
-  light::Reset(level_.lights_all_);
+  light::Triangles(tris_base_, lights, false);
+  light::Reset(lights);
 
-  // Make triangles for skybox (we want light it sepearately)
+  // Split near triangles to draw them by affine texturing if the context
+  // allows it (see note #1 in gl_triangle.cc)
 
-  triangles::AddFromObject(level_.skybox_, tris_sky_);
-  triangles_culled_ += triangles::CullAndClip(tris_sky_, cam);
-  triangles::AddFromTriangles(tris_sky_, tris_base_);
+  auto ratio = ctx.affine_ratio_;
+  if (ratio > 0.0f)
+    triangles_split_ += triangles::Subdivide(
+      tris_base_, cam, ratio, kSplitLength);
 
-    // Triangles merging
+  // Make triangles for skybox (we want light it sepearately) if it isn`t
+  // drawn by the sky pass
 
-  triangles::MakePointers(tris_base_, tris_ptrs_);
-  triangles::SortZAvgCounting(tris_ptrs_, cam.z_far_);
+  if (!level_.render_ctx_.sky_)
+  {
+    triangles::AddFromObject(level_.skybox_, tris_sky_);
+    triangles_culled_ += triangles::CullAndClip(tris_sky_, cam);
+    triangles::AddFromTriangles(tris_sky_, tris_base_);
+  }
 
   triangles::Camera2Persp(tris_base_, cam);
   triangles::Persp2Screen(tris_base_, cam);
+
+  // Add terrain triangles. Chunks in front of near_z plane are projected
+  // by one matrix (terrain local coords are world coords), the rest are
+  // converted to camera coords and then clipped and projected
+
+  auto mvp = object::MakeMvpMatrix(
+    Matrix<4,4>(Matrix<4,4>::IDENTITY), cam, level_.trig_);
+
+  tris_near_.resize(0);
+  for (auto& chunk : chunks)
+  {
+    if (!chunk.active_)
+      continue;
+
+    if (object::CrossesNearZ(chunk, cam, level_.trig_))
+    {
+      object::World2Camera(chunk, cam, level_.trig_);
+      object::SyncStreams(chunk);
+      triangles_culled_ += triangles::AddFromObjectIndexed(
+        chunk, cam, tris_near_, tris_base_);
+    }
+    else
+    {
+      object::Project(chunk, mvp);
+      triangles_culled_ += triangles::AddFromObjectProjected(
+        chunk, cam, tris_base_);
+    }
+  }
+  triangles_culled_ += triangles::CullAndClip(tris_near_, cam);
+  if (ratio > 0.0f)
+    triangles_split_ += triangles::Subdivide(
+      tris_near_, cam, ratio, kSplitLength);
+  triangles::Camera2Persp(tris_near_, cam);
+  triangles::Persp2Screen(tris_near_, cam);
+  triangles::AddFromTriangles(tris_near_, tris_base_);
+
+  // Triangles merging
+
+  triangles::MakePointers(tris_base_, tris_ptrs_);
+  depth_sort::SortZAvg(tris_ptrs_, sorter_, cam.z_far_);
 }
 
-} // namespace anshub
\ No newline at end of file
+} // namespace anshub
@@ -12,7 +12,11 @@
 
 #include "lib/data/cfg_loader.h"
 #include "lib/render/gl_draw.h"
+#include "lib/render/gl_depth_sort.h"
 #include "lib/render/gl_render_ctx.h"
+#include "lib/render/gl_spheres.h"
+#include "lib/render/gl_instances.h"
+#include "lib/render/gl_occlusion.h"
 #include "lib/render/cameras/gl_camera.h"
 #include "lib/window/gl_window.h"
 
@@ -24,31 +28,62 @@ struct Scene
   void Build(float factor);
 
   auto GetObjectsCulled() const { return objects_culled_; }
+  auto GetObjectsOccluded() const { return objects_occluded_; }
   auto GetTrianglesCulled() const { return triangles_culled_; }
+  auto GetTrianglesSplit() const { return triangles_split_; }
   auto GetSurfacesHidden() const { return hidden_surfaces_; }
   auto GetTrianglesCount() const { return tris_base_.size(); }
 
 private:
+  static constexpr float kSplitLength {128.0f}; // max near tri edge (px)
+  static constexpr int kBaseCapacity {65536};   // triangles of frame
+  static constexpr int kNearCapacity {16384};   // incl. clipped and split
+  static constexpr int kSkyCapacity {256};
+
   GlWindow& win_;
   Level& level_;
 
   V_Triangle tris_base_;
   V_Triangle tris_sky_;
+  V_Triangle tris_near_;        // terrain triangles crossed by near_z plane
   V_TrianglePtr tris_ptrs_;
+  V_GlObjectP wired_objs_;
+  V_GlObject wired_nature_;     // visible parts of instances
+  DepthSorter sorter_;          // buffers are kept between frames
+  V_Uchar vxs_marks_;           // scratch for object::TranslateVisible()
+  std::vector<int> wired_index_;  // new numbers of vertices and faces
+  std::vector<int> wired_faces_;  // copied by CopyWired()
+  std::vector<int> main_lods_;  // state of the main pass kept while the
+  V_Uchar main_active_;         // reflection is built
+  OcclusionBuffer occluders_;   // terrain depth in low resolution
+
+  BoundingSpheres spheres_trees_;   // gathered once since objects are static
+  BoundingSpheres spheres_nature_;
+  BoundingSpheres spheres_chunks_;
+  BoundingSpheres spheres_rain_;    // gathered every frame
 
   int hidden_surfaces_;
   int objects_culled_;
+  int objects_occluded_;
   int triangles_culled_;
+  int triangles_split_;
 
   void BuildPlayer(const GlCamera&);
   void BuildSkybox(const GlCamera&);
   void BuildWater(const GlCamera&);
   void BuildNature(const GlCamera&);
+  void AddNature(const GlCamera&);
   void BuildRain(const GlCamera&);
-  void BuildTerrain(const GlCamera&);
+  void BuildTerrain(const GlCamera&, bool by_horizon);
+  void BuildReflection(const GlCamera&);
+  void SaveMainState();
+  void RestoreMainState();
+  void CullOccluded(const GlCamera&);
   
-  void MakeTriangles();
-  void ProcessTriangles(const GlCamera&);
+  void MakeTriangles(const GlCamera&);
+  void MakeWiredObjects(const GlCamera&);
+  void CopyWired(const GlObject& mesh, GlObject& copy);
+  void ProcessTriangles(const GlCamera&, const RenderContext&);
 
 }; // struct Scene 
 
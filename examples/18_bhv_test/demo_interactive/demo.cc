@@ -150,7 +150,7 @@ auto MakeObjects(const TrigTable& trig, const char* fname, int cnt,
     float sfactor  = rand_toolkit::get_rand(1.0f, max_scale);
     obj.SetCoords(Coords::LOCAL);
     object::Scale(obj, {sfactor, sfactor, sfactor});
-    obj.sphere_rad_ = object::FindFarthestCoordinate(obj);
+    obj.sphere_rad_ = object::ComputeBoundingRadius(obj.GetCoords());
     obj.SetCoords(Coords::TRANS);
   }
   return objs;
@@ -93,7 +93,7 @@ auto MakeObjects(const char* fname, int cnt, float world_rad, float max_scale)
 
     float sfactor  = rand_toolkit::get_rand(1.0f, max_scale);
     object::Scale(obj, {sfactor, sfactor, sfactor});
-    obj.sphere_rad_ = object::FindFarthestCoordinate(obj);
+    obj.sphere_rad_ = object::ComputeBoundingRadius(obj.GetCoords());
   }
   return objs;
 }
@@ -0,0 +1,119 @@
+// *************************************************************
+// File:    horizon.cc
+// Descr:   horizon culling of heightmap terrain
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#include "horizon.h"
+
+namespace anshub {
+
+// Lowers horizon in all bins and takes camera position of the current frame
+
+void horizon::Clear(Horizon& h, cVector& cam_pos)
+{
+  h.cam_pos_ = cam_pos;
+  std::fill(h.slopes_.begin(), h.slopes_.end(),
+            -std::numeric_limits<float>::max());
+  std::fill(h.dists_.begin(), h.dists_.end(), 0.0f);
+}
+
+// Returns true if bounding box (in world coordinates) is below the horizon
+// (see note #1 in header)
+
+bool horizon::IsHidden(const Horizon& h, cVector& min, cVector& max)
+{
+  float first, last, dnear, dfar;
+  if (!horizon_helpers::GetFootprint(h, min, max, first, last, dnear, dfar))
+    return false;
+
+  // The greatest elevation of points of the box
+
+  float top = max.y - h.cam_pos_.y;
+  float elev = top >= 0.0f ? top / dnear : top / dfar;
+
+  int b2 = static_cast<int>(std::floor(last));
+  for (int b = static_cast<int>(std::floor(first)); b <= b2; ++b)
+  {
+    int i = horizon_helpers::WrapBin(b);
+    if (elev >= h.slopes_[i] || dnear < h.dists_[i])
+      return false;
+  }
+  return true;
+}
+
+// Raises horizon by the bottom of bounding box (in world coordinates)
+
+void horizon::AddOccluder(Horizon& h, cVector& min, cVector& max)
+{
+  float first, last, dnear, dfar;
+  if (!horizon_helpers::GetFootprint(h, min, max, first, last, dnear, dfar))
+    return;
+
+  // The least elevation of rays which are sure to go under the bottom of
+  // the box somewhere over it
+
+  float bottom = min.y - h.cam_pos_.y;
+  float elev = bottom < 0.0f ? bottom / dnear : bottom / dfar;
+
+  int b2 = static_cast<int>(std::floor(last));
+  for (int b = static_cast<int>(std::ceil(first)); b < b2; ++b)
+  {
+    int i = horizon_helpers::WrapBin(b);
+    if (elev > h.slopes_[i])
+    {
+      h.slopes_[i] = elev;
+      h.dists_[i] = std::max(h.dists_[i], dfar);
+    }
+  }
+}
+
+// Computes range of azimuths of box seen from the camera (in bins, range
+// may be out of [0, kBins) and should be wrapped) and the least and the
+// greatest horizontal distances to the box. Returns false if camera is
+// over the box
+
+bool horizon_helpers::GetFootprint(
+  const Horizon& h, cVector& min, cVector& max,
+  float& first, float& last, float& dnear, float& dfar)
+{
+  float x1 = min.x - h.cam_pos_.x;
+  float x2 = max.x - h.cam_pos_.x;
+  float z1 = min.z - h.cam_pos_.z;
+  float z2 = max.z - h.cam_pos_.z;
+
+  float dx = std::max({x1, -x2, 0.0f});
+  float dz = std::max({z1, -z2, 0.0f});
+  if (dx == 0.0f && dz == 0.0f)
+    return false;
+  dnear = std::sqrt(dx * dx + dz * dz);
+
+  // Since camera is out of the box, all corners are seen within half turn
+  // from the center of the box
+
+  float center = std::atan2(z1 + z2, x1 + x2);
+  float from {0.0f};
+  float to {0.0f};
+  dfar = 0.0f;
+  for (int i = 0; i < 4; ++i)
+  {
+    float x = i & 1 ? x2 : x1;
+    float z = i & 2 ? z2 : z1;
+    float angle = std::atan2(z, x) - center;
+    if (angle > math::kPI)
+      angle -= math::kPI_mul2;
+    else if (angle < -math::kPI)
+      angle += math::kPI_mul2;
+    from = std::min(from, angle);
+    to = std::max(to, angle);
+    dfar = std::max(dfar, x * x + z * z);
+  }
+  dfar = std::sqrt(dfar);
+
+  float k = Horizon::kBins / math::kPI_mul2;
+  first = (center + from + math::kPI) * k;
+  last = (center + to + math::kPI) * k;
+  return true;
+}
+
+} // namespace anshub
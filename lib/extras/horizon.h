@@ -0,0 +1,89 @@
+// *************************************************************
+// File:    horizon.h
+// Descr:   horizon culling of heightmap terrain
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef GL_EXTRAS_HORIZON_H
+#define GL_EXTRAS_HORIZON_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "lib/render/gl_aliases.h"
+
+#include "lib/math/vector.h"
+#include "lib/math/constants.h"
+
+namespace anshub {
+
+//****************************************************************************
+// Horizon of terrain seen from the camera. Directions around the camera are
+// split into bins by azimuth, and each bin holds the greatest elevation
+// (dy / horizontal distance) of terrain added before (see note #1)
+//****************************************************************************
+
+struct Horizon
+{
+  static constexpr int kBins {1024};
+
+  Horizon();
+
+  Vector    cam_pos_;
+  V_Float   slopes_;            // elevation of horizon in each bin
+  V_Float   dists_;             // farthest distance of terrain which is
+                                // taken into account in the elevation
+
+}; // struct Horizon
+
+namespace horizon {
+
+  void  Clear(Horizon&, cVector& cam_pos);
+  bool  IsHidden(const Horizon&, cVector& min, cVector& max);
+  void  AddOccluder(Horizon&, cVector& min, cVector& max);
+
+} // namespace horizon
+
+namespace horizon_helpers {
+
+  bool  GetFootprint(const Horizon&, cVector& min, cVector& max,
+                     float& first, float& last, float& dnear, float& dfar);
+  int   WrapBin(int);
+
+} // namespace horizon_helpers
+
+//****************************************************************************
+// Inline implementation
+//****************************************************************************
+
+inline Horizon::Horizon()
+  : cam_pos_{}
+  , slopes_(kBins, -std::numeric_limits<float>::max())
+  , dists_(kBins, 0.0f)
+{ }
+
+// Returns index of bin given by number which may be out of range (since
+// range of azimuths is wrapped)
+
+inline int horizon_helpers::WrapBin(int bin)
+{
+  return (bin % Horizon::kBins + Horizon::kBins) % Horizon::kBins;
+}
+
+}  // namespace anshub
+
+#endif  // GL_EXTRAS_HORIZON_H
+
+// Note #1 : each piece of terrain is given by its bounding box, and terrain
+//  surface is not lower than min.y of the box. Since camera is above the
+//  terrain, each ray which goes below min.y over the box is crossed by the
+//  terrain not farther than the box. Thus AddOccluder() raises horizon up
+//  to min.y over the box in bins covered by the box entirely, and IsHidden()
+//  returns true if max.y of the box is below the horizon in all bins touched
+//  by the box, and the box is farther than terrain which raised it. No
+//  rasterization is needed, and pieces should be processed from near to far
+//  to get the most of culling. Camera should be above the terrain and inside
+//  its bounds, and the terrain shouldn`t be removed partially later (i.e. in
+//  mirror images)
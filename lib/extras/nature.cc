@@ -15,6 +15,7 @@ Nature::Nature(
   : map_{map_fname.c_str()}
   , terrain_{terrain}
   , objects_{}
+  , meshes_{lods::kLevels}
   , fnames_{}
   , scale_{scale}
   , trig_{trig}
@@ -51,21 +52,21 @@ void Nature::RecognizeObjects()
         wpos.z = -((int)y - half_hw);
         wpos.y = terrain_.FindGroundPosition(wpos);
         
-        GlObject obj {obj_fname, wpos};
-        obj.SetCoords(Coords::LOCAL);
+        MeshInstance obj {meshes_.Get(obj_fname), wpos};
         
         // Initial scale
 
         float scale {
           rand_toolkit::get_rand(scale-(scale/2.0f), scale+(scale/2.0f))};
-        object::Scale(obj, {scale_, scale_, scale_});
+        obj.scale_ = scale_;
+        obj.sphere_rad_ *= scale_;
 
         // Initial rotate
 
         const float k_max_roll = 15.0f;
 
         float roll {rand_toolkit::get_rand(0.0f, k_max_roll)};
-        object::Rotate(obj, {0.0f, roll, 0.0f}, trig_);
+        obj.dir_ = {0.0f, roll, 0.0f};
         
         objects_.push_back(obj);
       }
@@ -15,6 +15,7 @@
 #include "lib/render/exceptions.h"
 #include "lib/render/gl_aliases.h"
 #include "lib/render/gl_object.h" 
+#include "lib/render/gl_instances.h"
 #include "lib/render/fx_colors.h"
 #include "lib/render/gl_vertex.h"
 
@@ -56,11 +57,13 @@ struct Nature
   
   void  RecognizeObjects();
   auto& GetObjects() { return objects_; }
+  auto& GetMeshes() { return meshes_; }
 
 private:
   Bitmap      map_;
   cTerrain&   terrain_;  
-  V_GlObject  objects_;
+  V_MeshInstance objects_;    // instances of meshes below
+  MeshCache   meshes_;        // each mesh file is loaded once
   MapString   fnames_;
   float       scale_;
   TrigTable&  trig_;
@@ -34,6 +34,7 @@ Blob::Blob(float w)
 
   for (auto& face : faces_)
     face.color_ = color::fWhite;
+  edges_ = object::ComputeEdges(faces_);
  
   // Create local pos
 
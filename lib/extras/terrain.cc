@@ -27,6 +27,8 @@ Terrain::Terrain(
   , chunks_{}
   , shading_{shading}
   , distances_{}
+  , horizon_{}
+  , order_{}
 {   
   LoadTexture(tex_fname);
   LoadHeightmap(map_fname);
@@ -63,6 +65,8 @@ void Terrain::SetDetalization(const V_Float& dists)
 
 void Terrain::ProcessDetalization(const Vector& cam_vrp)
 {
+  bool changed {false};
+
   for (auto& chunk : chunks_)
   {
     // Find distance length between curr cam pos and pos of chunk
@@ -92,9 +96,74 @@ void Terrain::ProcessDetalization(const Vector& cam_vrp)
     if (det_level >= chunk.DetLevels())
       det_level = chunk.DetLevels() - 1;
 
-    if (chunk.SetFace(det_level))
+    if (chunk.SetFace(det_level)) {
       chunk.AlignNeighboringChunks(chunks_);
+      need_align = true;
+    }
+    changed |= need_align;
+  }
+
+  // Local vertices are changed, thus normals and streams should be refreshed
+
+  if (changed)
+  {
+    for (auto& chunk : chunks_)
+    {
+      chunk.RefreshNormals();
+      if (chunk.IsStreamed())
+        object::MakeStreams(chunk);
+    }
+  }
+}
+
+// Deactivates active chunks hidden by nearer chunks and returns count of
+// them. Chunks are processed from near to far, each visible one raises the
+// horizon (see note #1 in horizon.h). Does nothing if camera is out of
+// terrain or under the ground
+
+int Terrain::CullByHorizon(const Vector& cam_pos)
+{
+  cVector& first = vxs_.front().pos_;
+  cVector& last = vxs_.back().pos_;
+  if (cam_pos.x <= std::min(first.x, last.x) ||
+      cam_pos.x >= std::max(first.x, last.x) ||
+      cam_pos.z <= std::min(first.z, last.z) ||
+      cam_pos.z >= std::max(first.z, last.z) ||
+      cam_pos.y <= FindGroundPosition(cam_pos))
+    return 0;
+
+  order_.clear();
+  for (uint i = 0; i < chunks_.size(); ++i)
+  {
+    if (chunks_[i].active_)
+      order_.push_back(i);
   }
+  auto dist = [&](uint i)
+  {
+    float dx = chunks_[i].world_pos_.x - cam_pos.x;
+    float dz = chunks_[i].world_pos_.z - cam_pos.z;
+    return dx * dx + dz * dz;
+  };
+  std::sort(order_.begin(), order_.end(), [&](uint l, uint r) {
+    return dist(l) < dist(r);
+  });
+
+  int total {0};
+  horizon::Clear(horizon_, cam_pos);
+  for (auto i : order_)
+  {
+    auto& chunk = chunks_[i];
+    Vector min = chunk.BoxMin();
+    Vector max = chunk.BoxMax();
+    if (horizon::IsHidden(horizon_, min, max))
+    {
+      chunk.active_ = false;
+      ++total;
+    }
+    else
+      horizon::AddOccluder(horizon_, min, max);
+  }
+  return total;
 }
 
 // Searches Y ground position of given point. Note the following:
@@ -348,6 +417,10 @@ void Terrain::ComputeVerticesNormals()
 Terrain::Chunk::Chunk(const V_Vertex& cvxs, int ln, int rn, int tn, int bn)
   : GlObject()
   , det_faces_{}
+  , det_edges_{}
+  , det_clusters_{}
+  , det_normals_{}
+  , moved_(cvxs.size(), 0)
   , vxs_step_{}
   , vxs_in_row_(std::sqrt(cvxs.size()))  
   , left_chunk_{ln}
@@ -396,6 +469,26 @@ Terrain::Chunk::Chunk(const V_Vertex& cvxs, int ln, int rn, int tn, int bn)
   // each object. May be this is not so correct, but I increase sphere_rad to 1.5f 
 }
 
+// Returns the least corner of bounding box of chunk (in world coordinates)
+
+Vector Terrain::Chunk::BoxMin() const
+{
+  cVector& first = vxs_backup_.front().pos_;
+  cVector& last = vxs_backup_.back().pos_;
+  return Vector{
+    std::min(first.x, last.x), min_y_, std::min(first.z, last.z)};
+}
+
+// Returns the greatest corner of bounding box of chunk
+
+Vector Terrain::Chunk::BoxMax() const
+{
+  cVector& first = vxs_backup_.front().pos_;
+  cVector& last = vxs_backup_.back().pos_;
+  return Vector{
+    std::max(first.x, last.x), max_y_, std::max(first.z, last.z)};
+}
+
 // Set current face by given face_num and returns true if success
  
 bool Terrain::Chunk::SetFace(int face_num)
@@ -403,6 +496,9 @@ bool Terrain::Chunk::SetFace(int face_num)
   if (faces_.size() != det_faces_[face_num].size())
   {
     faces_ = det_faces_[face_num];
+    edges_ = det_edges_[face_num];
+    clusters_ = det_clusters_[face_num];
+    normals_local_ = det_normals_[face_num];
     vxs_local_ = vxs_backup_;
     vxs_step_ = std::pow(2, face_num); // 2 << face_num;
     return true;
@@ -414,7 +510,19 @@ bool Terrain::Chunk::SetFace(int face_num)
 
 void Terrain::Chunk::CopyCoords(Coords src, Coords dest)
 {
-  if (src == Coords::LOCAL && dest == Coords::TRANS)
+  if (src == Coords::LOCAL && dest == Coords::TRANS && IsStreamed())
+  {
+    streams_trans_ = streams_local_;
+    for (auto& f : faces_)
+    {
+      for (auto i : f.vxs_)
+      {
+        vxs_trans_[i].color_ = vxs_local_[i].color_;
+        vxs_trans_[i].texture_ = vxs_local_[i].texture_;
+      }
+    }
+  }
+  else if (src == Coords::LOCAL && dest == Coords::TRANS)
   {
     for (auto& f : faces_)
     {
@@ -425,6 +533,11 @@ void Terrain::Chunk::CopyCoords(Coords src, Coords dest)
   }
   else if (src == Coords::TRANS && dest == Coords::LOCAL)  
   {
+    if (IsStreamed())
+    {
+      streams::Scatter(streams_trans_, vxs_trans_);
+      streams_local_ = streams_trans_;
+    }
     for (auto& f : faces_)
     {
       vxs_local_[f[0]] = vxs_trans_[f[0]];
@@ -439,40 +552,100 @@ void Terrain::Chunk::CopyCoords(Coords src, Coords dest)
 void Terrain::Chunk::ComputeAllFaces()
 {
   det_faces_.resize(0);
+  det_edges_.resize(0);
+  det_clusters_.resize(0);
+  det_normals_.resize(0);
   int w = vxs_in_row_;
-  
+
+  // Faces are made by tiles of quads, and each tile is a cluster (see note
+  // #4 in gl_object.h)
+
+  constexpr int kTileW {8};
+  constexpr int kTileH {clusters::kSize / kTileW / 2};
+
   // Here we simple use variable `det` as step
 
   for (int det = 1; det <= w; det *= 2){
 
     V_Face curr_faces {};
+    V_MeshCluster curr_clusters {};
+
+    for (int ty = 0; ty < w-det; ty += det*kTileH) {
+      for (int tx = 0; tx < w-det; tx += det*kTileW) {
+
+        int first = curr_faces.size();
+        int y_end = std::min(w-det, ty + det*kTileH);
+        int x_end = std::min(w-det, tx + det*kTileW);
+
+        for (int y = ty; y < y_end; y+=det) {   // -det since we take y+det
+          for (int x = tx; x < x_end; x+=det) { // and x+det inside loop
+
+            // Create faces
+
+            int lt = y*w+x;
+            int rt = y*w+x+det;
+            int lb = (y+det)*w+x;
+            int rb = (y+det)*w+x+det;
 
-    for (int y = 0; y < w-det; y+=det) {    // -det since we take y+det
-      for (int x = 0; x < w-det; x+=det) {  // and x+det inside loop
-        
-        // Create faces
-          
-        int lt = y*w+x;
-        int rt = y*w+x+det;
-        int lb = (y+det)*w+x;
-        int rb = (y+det)*w+x+det;
-        
-        Face f1 {vxs_local_, lt, rt, lb};
-        Face f2 {vxs_local_, rt, rb, lb};
-        
-        // Fill face color (by convient this is the white)
-
-        f1.color_ = FColor{color::White};
-        f2.color_ = FColor{color::White};
-
-        curr_faces.push_back(f1);
-        curr_faces.push_back(f2);
+            Face f1 {vxs_local_, lt, rt, lb};
+            Face f2 {vxs_local_, rt, rb, lb};
+
+            // Fill face color (by convient this is the white)
+
+            f1.color_ = FColor{color::White};
+            f2.color_ = FColor{color::White};
+
+            // Mark faces as halves of one quad to draw them at once
+
+            f1.quad_ = Quad::FIRST;
+            f2.quad_ = Quad::SECOND;
+
+            curr_faces.push_back(f1);
+            curr_faces.push_back(f2);
+          }
+        }
+
+        // Normals cones are not used since border vertices are moved while
+        // aligning neighboring chunks
+
+        auto cl = clusters::Make(
+          vxs_local_, curr_faces, first, curr_faces.size() - first);
+        cl.cos_ = 0.0f;
+        curr_clusters.push_back(cl);
       }
     }
+    // Local normals are computed once, then are refreshed only near sides
+    // moved while aligning (see RefreshNormals())
+
+    V_Vector curr_normals (curr_faces.size());
+    for (std::size_t i = 0; i < curr_faces.size(); ++i)
+    {
+      auto& f = curr_faces[i];
+      Vector u {vxs_local_[f[0]].pos_, vxs_local_[f[1]].pos_};
+      Vector v {vxs_local_[f[0]].pos_, vxs_local_[f[2]].pos_};
+      curr_normals[i] = vector::CrossProduct(u, v);
+      if (!curr_normals[i].IsZero())
+        curr_normals[i].Normalize();
+    }
+
+    det_edges_.push_back(object::ComputeEdges(curr_faces));
     det_faces_.push_back(curr_faces);
+    det_clusters_.push_back(curr_clusters);
+    det_normals_.push_back(curr_normals);
   }
 }
 
+// Recomputes local normals of faces which use vertices moved by aligning
+// or recovering of sides since the last call
+
+void Terrain::Chunk::RefreshNormals()
+{
+  if (std::find(moved_.begin(), moved_.end(), 1) == moved_.end())
+    return;
+  object::ComputeLocalNormals(*this, moved_);
+  std::fill(moved_.begin(), moved_.end(), 0);
+}
+
 // Try to align neighboring chunks after changing current chunk face
 
 void Terrain::Chunk::AlignNeighboringChunks(std::vector<Terrain::Chunk>& chunks)
@@ -548,6 +721,7 @@ void Terrain::Chunk::AlignLeftSide(float neigh_step)
   for (int i = 0; i < vxs_total; i += vxs_in_row_)
   {
     vxs_local_[i] = vxs_local_[k];
+    moved_[i] = 1;
     if (k == i)
       k += neigh_step * vxs_in_row_;
   }
@@ -563,6 +737,7 @@ void Terrain::Chunk::AlignRightSide(float neigh_step)
   for (int i = k; i < vxs_total; i += vxs_in_row_)
   {
     vxs_local_[i] = vxs_local_[k];
+    moved_[i] = 1;
     if (k == i)
       k += neigh_step * vxs_in_row_;
   }
@@ -577,6 +752,7 @@ void Terrain::Chunk::AlignTopSide(float neigh_step)
   for (int i = k; i < vxs_in_row_; ++i)
   {
     vxs_local_[i] = vxs_local_[k];
+    moved_[i] = 1;
     if (k == i)
       k += neigh_step;
   }
@@ -592,6 +768,7 @@ void Terrain::Chunk::AlignBottomSide(float neigh_step)
   for (int i = k; i < vxs_total; ++i)
   {
     vxs_local_[i] = vxs_local_[k];
+    moved_[i] = 1;
     if (k == i)
       k += neigh_step;
   }
@@ -606,6 +783,7 @@ void Terrain::Chunk::RecoverLeftSide()
   for (int i = 0; i < vxs_total; i += vxs_in_row_)
   {
     vxs_local_[i] = vxs_backup_[k];
+    moved_[i] = 1;
     if (k == i)
       k += vxs_step_ * vxs_in_row_;
   }
@@ -620,6 +798,7 @@ void Terrain::Chunk::RecoverRightSide()
   for (int i = k; i < vxs_total; i += vxs_in_row_)
   {
     vxs_local_[i] = vxs_backup_[k];
+    moved_[i] = 1;
     if (k == i)
       k += vxs_step_ * vxs_in_row_;
   }
@@ -633,6 +812,7 @@ void Terrain::Chunk::RecoverTopSide()
   for (int i = k; i < vxs_in_row_; ++i)
   {
     vxs_local_[i] = vxs_backup_[k];
+    moved_[i] = 1;
     if (k == i)
       k += vxs_step_;
   }
@@ -647,6 +827,7 @@ void Terrain::Chunk::RecoverBottomSide()
   for (int i = k; i < vxs_total; ++i)
   {
     vxs_local_[i] = vxs_backup_[k];
+    moved_[i] = 1;
     if (k == i)
       k += vxs_step_;
   }
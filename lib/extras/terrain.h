@@ -16,6 +16,8 @@
 
 #include "lib/math/math.h"
 
+#include "lib/extras/horizon.h"
+
 namespace anshub {
 
 //****************************************************************************
@@ -40,6 +42,7 @@ struct Terrain
   void  SetShading(Shading);
   void  SetDetalization(const V_Float&);
   void  ProcessDetalization(const Vector&);
+  int   CullByHorizon(const Vector&);
   float FindGroundPosition(const Vector&) const;
   Vector FindGroundNormal(const Vector&) const;
 
@@ -65,6 +68,8 @@ private:
   V_Chunk   chunks_;                // chunks of terrain
   Shading   shading_;
   V_Float   distances_;             // distances to determine detalization level
+  Horizon   horizon_;               // horizon of chunks seen from the camera
+  V_Uint    order_;                 // scratch for order of chunks by distance
 
 }; // struct Terrain
 
@@ -83,9 +88,12 @@ struct Terrain::Chunk : GlObject
 
   bool SetFace(int face_num);
   int  DetLevels() const { return det_faces_.size(); }
+  Vector BoxMin() const;
+  Vector BoxMax() const;
   void CopyCoords(Coords src, Coords dest) override;
   void ComputeAllFaces();
   void AlignNeighboringChunks(std::vector<Chunk>&);
+  void RefreshNormals();
 
 private:
   void AlignLeftSide(float step);
@@ -99,6 +107,10 @@ private:
 
   V_Vertex  vxs_backup_;    // backup of local vertices
   VV_Face   det_faces_;     // faces for different detalization levels
+  VV_MeshEdge det_edges_;   // edges of faces above
+  VV_MeshCluster det_clusters_; // clusters of faces above
+  VV_Vector det_normals_;   // local normals of faces above
+  V_Uchar   moved_;         // marks of vertices moved by aligning
   int       vxs_step_;      // step between vertices
   int       vxs_in_row_;    // how many vertices contains chunk in max det
   int       left_chunk_;    // index of left neighboring chunk
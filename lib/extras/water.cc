@@ -22,6 +22,7 @@ Water::Water(int width, float height, cFColor& c, Shading s)
   this->vxs_local_.emplace_back(Vector{0.5f, 0.0f, -0.5f});
   this->faces_.emplace_back(this->vxs_local_, 0, 1, 2);
   this->faces_.emplace_back(this->vxs_local_, 2, 3, 0);
+  this->edges_ = object::ComputeEdges(this->faces_);
   
   // Colorize faces and vertices
 
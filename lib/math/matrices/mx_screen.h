@@ -0,0 +1,44 @@
+// *************************************************************
+// File:    matrix_screen.h
+// Descr:   row-based screen matrix for homogeneous coordinates
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef GM_MATRIX_SCREEN_H
+#define GM_MATRIX_SCREEN_H
+
+#include "../matrix.h"
+#include "../vector.h"
+
+namespace anshub {
+
+// Unlike MatrixViewport, this matrix is applied before perspective divide,
+// thus it may be multiplied with model, camera and perspective matrices.
+// After divide x and y are screen coordinates, and z and w are both equal
+// to w of perspective coordinates (i.e. camera z)
+
+struct MatrixScreen : public Matrix<4,4>
+{
+  MatrixScreen(float, int, int);
+
+}; // struct MatrixScreen
+
+inline MatrixScreen::MatrixScreen(float wov, int scr_w, int scr_h)
+  : Matrix<4,4>{}
+{
+  float kx = scr_w / wov;
+  float ky = scr_h / wov;
+  float half_wov = wov / 2;
+  Matrix::Container tmp =
+  {
+      kx,           0.0f,         0.0f,   0.0f,
+      0.0f,         ky,           0.0f,   0.0f,
+      0.0f,         0.0f,         0.0f,   0.0f,
+      half_wov*kx,  half_wov*ky,  1.0f,   1.0f
+  };
+  data_ = tmp;
+}
+
+}  // namespace anshub
+
+#endif  // GM_MATRIX_SCREEN_H
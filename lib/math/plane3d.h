@@ -15,6 +15,11 @@ namespace anshub {
 
 struct Plane3d
 {
+  Plane3d()
+  : a_{}
+  , b_{}
+  , c_{}
+  , d_{} { }
   Plane3d(float ka, float kb, float kc, float kd)
   : a_{ka}
   , b_{kb}
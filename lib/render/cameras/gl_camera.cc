@@ -5,6 +5,7 @@
 // *************************************************************
 
 #include "gl_camera.h"
+#include "lib/render/gl_coords.h"
 
 namespace anshub {
 
@@ -25,6 +26,7 @@ GlCamera::GlCamera
   , wov_{2 * trig::CalcOppositeCatet(dov_, fov_/2, trig)}
   , z_near_{z_near}
   , z_far_{z_far}
+  , guard_band_{2.0f}
   , scr_w_{scr_w}
   , scr_h_{scr_h}
   , ar_{static_cast<float>(scr_w_) / static_cast<float>(scr_h_)}
@@ -32,11 +34,46 @@ GlCamera::GlCamera
   , dir_{dir}
   , type_{CamType::EULER}
   , trig_{trig}
+  , frustum_{}
   , pitch_{}
   , yaw_{}
   , roll_{}
 { }
 
+// Computes planes of frustum in world coordinates. Planes are computed in
+// camera coordinates and rotated back by transposed camera matrix, since
+// n_cam * (R * (p - vrp)) == (R^t * n_cam) * p - (R^t * n_cam) * vrp
+
+void GlCamera::UpdateFrustum()
+{
+  float px = wov_ * 0.5f / dov_;      // side planes x and y when z == 1
+  float py = px / ar_;
+  float kx = 1.0f / std::sqrt(1.0f + px * px);
+  float ky = 1.0f / std::sqrt(1.0f + py * py);
+
+  std::array<Plane3d, 6> cam_planes {{
+    {0.0f,  0.0f,  1.0f,  -z_near_},
+    {0.0f,  0.0f,  -1.0f, z_far_},
+    {kx,    0.0f,  px * kx, 0.0f},
+    {-kx,   0.0f,  px * kx, 0.0f},
+    {0.0f,  ky,    py * ky, 0.0f},
+    {0.0f,  -ky,   py * ky, 0.0f}
+  }};
+
+  float m[9];
+  coords::World2CameraMatrix(dir_, trig_, m);
+
+  for (std::size_t i = 0; i < cam_planes.size(); ++i)
+  {
+    const Plane3d& cp = cam_planes[i];
+    Plane3d& wp = frustum_[i];
+    wp.a_ = m[0] * cp.a_ + m[3] * cp.b_ + m[6] * cp.c_;
+    wp.b_ = m[1] * cp.a_ + m[4] * cp.b_ + m[7] * cp.c_;
+    wp.c_ = m[2] * cp.a_ + m[5] * cp.b_ + m[8] * cp.c_;
+    wp.d_ = cp.d_ - (wp.a_ * vrp_.x + wp.b_ * vrp_.y + wp.c_ * vrp_.z);
+  }
+}
+
 // Computes camera`s view vector (by convient we rotate vertices by YXZ
 // sequence, but to compute camera view vector we should multiplie it
 // by reverse order ZXY)
@@ -14,6 +14,7 @@
 #define GC_GL_CAMERA_H
 
 #include <cmath>
+#include <array>
 
 #include "lib/render/gl_aliases.h"
 #include "lib/render/gl_enums.h"
@@ -23,6 +24,7 @@
 #include "lib/math/vector.h"
 #include "lib/math/matrix.h"
 #include "lib/math/matrices/mx_rotate_eul.h"
+#include "lib/math/plane3d.h"
 
 namespace anshub {
 
@@ -46,6 +48,7 @@ struct GlCamera
   virtual void Preprocess() { }
 
   void ChangeFov(int new_fov);
+  void UpdateFrustum();
   
   template<class ... Args>
   void SetDirection(DirectionType, Args&&...);
@@ -57,6 +60,7 @@ struct GlCamera
   float   wov_;       // width of view plane
   float   z_near_;    // near z plane
   float   z_far_;     // far z plane
+  float   guard_band_;// side planes scale to clip triangles by
   int     scr_w_;     // screen width
   int     scr_h_;     // screen height
   float   ar_;        // aspect ratio
@@ -66,6 +70,11 @@ struct GlCamera
   CamTypes    type_;  // camera type
   cTrigTable& trig_;
 
+  // Planes of frustum in world coordinates (near, far, left, right, down,
+  // up) with normals directed inside. Are valid after UpdateFrustum() call
+
+  std::array<Plane3d, 6> frustum_;
+
   CamDir  pitch_;
   CamDir  yaw_;
   CamDir  roll_;
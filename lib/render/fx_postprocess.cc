@@ -0,0 +1,666 @@
+// *************************************************************
+// File:    fx_postprocess.cc
+// Descr:   post processing effects applied to screen buffer
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+
+#include "fx_postprocess.h"
+
+namespace anshub {
+
+PostContext::PostContext()
+  : is_bloom_{false}
+  , is_grading_{false}
+  , is_vignette_{false}
+  , is_fxaa_{false}
+  , threads_{1}
+  , bloom_scale_{2}
+  , bloom_threshold_{192}
+  , bloom_strength_{0.5f}
+  , vignette_strength_{0.5f}
+  , fxaa_threshold_{16}
+  , lut_{}
+  , bloom_ms_{}
+  , grading_ms_{}
+  , vignette_ms_{}
+  , fxaa_ms_{}
+  , w_{}
+  , h_{}
+  , vignette_built_{-1.0f}
+  , bloom_{}
+  , bloom_tmp_{}
+  , copy_{}
+  , luma_{}
+  , vignette_col_{}
+  , vignette_row_{}
+{
+  postproc::MakeLut(lut_, 1.0f, 1.0f, FColor{255.0f, 255.0f, 255.0f});
+}
+
+// Applies all enabled effects to the screen buffer and collects timings
+
+void postproc::Apply(PostContext& ctx, ScrBuffer& buf)
+{
+  postproc_helpers::Resize(ctx, buf.Width(), buf.Height());
+
+  auto start = postproc_helpers::Now();
+  if (ctx.is_bloom_)
+    postproc::Bloom(ctx, buf);
+  ctx.bloom_ms_ = postproc_helpers::MsSince(start);
+
+  start = postproc_helpers::Now();
+  if (ctx.is_grading_)
+    postproc::Grading(ctx, buf);
+  ctx.grading_ms_ = postproc_helpers::MsSince(start);
+
+  start = postproc_helpers::Now();
+  if (ctx.is_vignette_)
+    postproc::Vignette(ctx, buf);
+  ctx.vignette_ms_ = postproc_helpers::MsSince(start);
+
+  start = postproc_helpers::Now();
+  if (ctx.is_fxaa_)
+    postproc::Fxaa(ctx, buf);
+  ctx.fxaa_ms_ = postproc_helpers::MsSince(start);
+}
+
+// Adds blurred bright parts of the image to itself. Bright pass is made at
+// half or quarter resolution, blurred by separable [1 4 6 4 1] filter and
+// upsampled by nearest pixel while adding
+
+void postproc::Bloom(PostContext& ctx, ScrBuffer& buf)
+{
+  int scale = ctx.bloom_scale_ == 4 ? 4 : 2;
+  int w = buf.Width();
+  int h = buf.Height();
+  int hw = w / 2;               // half resolution
+  int hh = h / 2;
+  int lw = w / scale;           // bloom resolution
+  int lh = h / scale;
+  if (lw < 1 || lh < 1)
+    return;
+
+  const auto& lay = buf.Layout();
+  uint* scr = buf.GetPointer();
+  uint* low = ctx.bloom_.data();
+  uint* tmp = ctx.bloom_tmp_.data();
+
+  // Downsample screen to half resolution
+
+  uint* half = scale == 2 ? low : tmp;
+  postproc::ForRows(ctx.threads_, hh, [&](int y0, int y1)
+  {
+    for (int y = y0; y < y1; ++y)
+    {
+      int r0 = lay.Row(y * 2);
+      int r1 = lay.Row(y * 2 + 1);
+      uint* dst = half + y * hw;
+      int x = 0;
+      for (; x + 2 <= hw; x += 2)
+      {
+        int c = lay.Col(x * 2);
+        auto v = postproc_helpers::Halve4(scr + r0 + c, scr + r1 + c);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), v);
+      }
+      for (; x < hw; ++x)
+        dst[x] = postproc_helpers::Avg4(
+          scr[r0 + lay.Col(x*2)], scr[r0 + lay.Col(x*2 + 1)],
+          scr[r1 + lay.Col(x*2)], scr[r1 + lay.Col(x*2 + 1)]);
+    }
+  });
+
+  // Downsample half resolution to quarter if needed
+
+  if (scale == 4)
+  {
+    postproc::ForRows(ctx.threads_, lh, [&](int y0, int y1)
+    {
+      for (int y = y0; y < y1; ++y)
+      {
+        const uint* r0 = tmp + (y * 2) * hw;
+        const uint* r1 = r0 + hw;
+        uint* dst = low + y * lw;
+        int x = 0;
+        for (; x + 2 <= lw; x += 2)
+        {
+          auto v = postproc_helpers::Halve4(r0 + x*2, r1 + x*2);
+          _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), v);
+        }
+        for (; x < lw; ++x)
+          dst[x] = postproc_helpers::Avg4(
+            r0[x*2], r0[x*2 + 1], r1[x*2], r1[x*2 + 1]);
+      }
+    });
+  }
+
+  // Bright pass and horizontal blur (low -> tmp). Bright pass is made on the
+  // fly, since it`s cheap (alpha byte becomes 0 here, thus it is not
+  // changed by bloom adding below)
+
+  uint th = ctx.bloom_threshold_ & 0xff;
+  uint th_color = (th << 24) | (th << 16) | (th << 8) | 0xff;
+  __m128i thr = _mm_set1_epi32(th_color);
+
+  postproc::ForRows(ctx.threads_, lh, [&](int y0, int y1)
+  {
+    for (int y = y0; y < y1; ++y)
+    {
+      uint* row = low + y * lw;
+      int x = 0;
+      for (; x + 4 <= lw; x += 4)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row + x), _mm_subs_epu8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)), thr));
+      for (; x < lw; ++x)
+        row[x] = _mm_cvtsi128_si32(
+          _mm_subs_epu8(_mm_cvtsi32_si128(row[x]), thr));
+
+      uint* dst = tmp + y * lw;
+      for (x = 0; x < std::min(2, lw); ++x)
+        dst[x] = postproc_helpers::BlurPixel(row, x, 1, lw);
+      for (; x + 6 <= lw; x += 4)
+      {
+        auto v = postproc_helpers::Blur4(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x - 2)),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x - 1)),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x)),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x + 1)),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x + 2)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), v);
+      }
+      for (; x < lw; ++x)
+        dst[x] = postproc_helpers::BlurPixel(row, x, 1, lw);
+    }
+  });
+
+  // Vertical blur and strength (tmp -> low)
+
+  int k = std::min(std::max(ctx.bloom_strength_, 0.0f), 1.0f) * 256.0f;
+  __m128i strength = _mm_set1_epi16(k);
+
+  postproc::ForRows(ctx.threads_, lh, [&](int y0, int y1)
+  {
+    __m128i zero = _mm_setzero_si128();
+    for (int y = y0; y < y1; ++y)
+    {
+      const uint* rows[5];
+      for (int i = 0; i < 5; ++i)
+        rows[i] = tmp + std::min(std::max(y + i - 2, 0), lh - 1) * lw;
+      uint* dst = low + y * lw;
+      int x = 0;
+      for (; x + 4 <= lw; x += 4)
+      {
+        __m128i v = postproc_helpers::Blur4(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[0] + x)),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[1] + x)),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[2] + x)),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[3] + x)),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[4] + x)));
+        __m128i lo = _mm_srli_epi16(
+          _mm_mullo_epi16(_mm_unpacklo_epi8(v, zero), strength), 8);
+        __m128i hi = _mm_srli_epi16(
+          _mm_mullo_epi16(_mm_unpackhi_epi8(v, zero), strength), 8);
+        _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(lo, hi));
+      }
+      for (; x < lw; ++x)
+      {
+        uint c = postproc_helpers::BlurPixel(tmp + x, y, lw, lh);
+        uint res {0};
+        for (int sh = 0; sh < 32; sh += 8)
+          res |= ((((c >> sh) & 0xff) * k) >> 8) << sh;
+        dst[x] = res;
+      }
+    }
+  });
+
+  // Upsample and add bloom to the screen
+
+  postproc::ForRows(ctx.threads_, h, [&](int y0, int y1)
+  {
+    for (int y = y0; y < y1; ++y)
+    {
+      int row = lay.Row(y);
+      const uint* src = low + std::min(y / scale, lh - 1) * lw;
+      int x = 0;
+      for (; x + 4 <= w; x += 4)
+      {
+        __m128i b {};
+        if (scale == 2) {
+          b = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + x / 2));
+          b = _mm_unpacklo_epi32(b, b);
+        }
+        else
+          b = _mm_set1_epi32(src[x / 4]);
+        auto* p = reinterpret_cast<__m128i*>(scr + row + lay.Col(x));
+        _mm_storeu_si128(p, _mm_adds_epu8(_mm_loadu_si128(p), b));
+      }
+      for (; x < w; ++x)
+      {
+        uint& c = scr[row + lay.Col(x)];
+        c = postproc_helpers::AddSat(c, src[std::min(x / scale, lw - 1)]);
+      }
+    }
+  });
+}
+
+// Color grading using 3d lut (see note #1 in header)
+
+void postproc::Grading(PostContext& ctx, ScrBuffer& buf)
+{
+  int w = buf.Width();
+  const auto& lay = buf.Layout();
+  uint* scr = buf.GetPointer();
+  const uint* lut = ctx.lut_.data();
+
+  postproc::ForRows(ctx.threads_, buf.Height(), [&](int y0, int y1)
+  {
+    __m128i cell_mask = _mm_set1_epi32(static_cast<int>(0xf8f8f800));
+    __m128i cell_half = _mm_set1_epi32(0x04040400);
+
+    for (int y = y0; y < y1; ++y)
+    {
+      int row = lay.Row(y);
+      int x = 0;
+      for (; x + 4 <= w; x += 4)
+      {
+        uint* px = scr + row + lay.Col(x);
+        auto* p = reinterpret_cast<__m128i*>(px);
+        __m128i c = _mm_loadu_si128(p);
+        __m128i graded = _mm_set_epi32(
+          lut[postproc_helpers::LutIndex(px[3])],
+          lut[postproc_helpers::LutIndex(px[2])],
+          lut[postproc_helpers::LutIndex(px[1])],
+          lut[postproc_helpers::LutIndex(px[0])]);
+        __m128i center = _mm_or_si128(_mm_and_si128(c, cell_mask), cell_half);
+        __m128i pos = _mm_subs_epu8(graded, center);
+        __m128i neg = _mm_subs_epu8(center, graded);
+        _mm_storeu_si128(p, _mm_subs_epu8(_mm_adds_epu8(c, pos), neg));
+      }
+      for (; x < w; ++x)
+      {
+        uint& c = scr[row + lay.Col(x)];
+        uint graded = lut[postproc_helpers::LutIndex(c)];
+        uint res {c & 0xff};
+        for (int sh = 8; sh < 32; sh += 8)
+        {
+          int ch = (c >> sh) & 0xff;
+          int d = static_cast<int>((graded >> sh) & 0xff) - ((ch & 0xf8) | 4);
+          res |= static_cast<uint>(std::min(std::max(ch + d, 0), 255)) << sh;
+        }
+        c = res;
+      }
+    }
+  });
+}
+
+// Darkens image to the corners. Weight of the pixel is the product of
+// weights of its column and row
+
+void postproc::Vignette(PostContext& ctx, ScrBuffer& buf)
+{
+  if (ctx.vignette_built_ != ctx.vignette_strength_)
+    postproc_helpers::MakeVignette(ctx);
+
+  int w = buf.Width();
+  const auto& lay = buf.Layout();
+  uint* scr = buf.GetPointer();
+
+  postproc::ForRows(ctx.threads_, buf.Height(), [&](int y0, int y1)
+  {
+    __m128i zero = _mm_setzero_si128();
+    __m128i alpha = _mm_set1_epi32(0xff);
+
+    for (int y = y0; y < y1; ++y)
+    {
+      int row = lay.Row(y);
+      ushort wy = ctx.vignette_row_[y];
+      __m128i row_w = _mm_set1_epi16(static_cast<short>(wy));
+      int x = 0;
+      for (; x + 4 <= w; x += 4)
+      {
+        auto* p = reinterpret_cast<__m128i*>(scr + row + lay.Col(x));
+        auto* cw = reinterpret_cast<const __m128i*>(&ctx.vignette_col_[x * 4]);
+        __m128i c = _mm_loadu_si128(p);
+        __m128i w_lo = _mm_mulhi_epu16(_mm_loadu_si128(cw), row_w);
+        __m128i w_hi = _mm_mulhi_epu16(_mm_loadu_si128(cw + 1), row_w);
+        __m128i lo = _mm_mulhi_epu16(_mm_unpacklo_epi8(c, zero), w_lo);
+        __m128i hi = _mm_mulhi_epu16(_mm_unpackhi_epi8(c, zero), w_hi);
+        __m128i res = _mm_packus_epi16(lo, hi);
+        res = _mm_or_si128(_mm_andnot_si128(alpha, res), _mm_and_si128(alpha, c));
+        _mm_storeu_si128(p, res);
+      }
+      for (; x < w; ++x)
+      {
+        uint& c = scr[row + lay.Col(x)];
+        uint k = (ctx.vignette_col_[x * 4] * wy) >> 16;
+        uint res {c & 0xff};
+        for (int sh = 8; sh < 32; sh += 8)
+          res |= ((((c >> sh) & 0xff) * k) >> 16) << sh;
+        c = res;
+      }
+    }
+  });
+}
+
+// Simplified fxaa: finds edges by luma contrast of 4 neighbours and blends
+// pixel with the neighbour across the edge (without end of edge search)
+
+void postproc::Fxaa(PostContext& ctx, ScrBuffer& buf)
+{
+  int w = buf.Width();
+  int h = buf.Height();
+  const auto& lay = buf.Layout();
+  uint* scr = buf.GetPointer();
+  uint* copy = ctx.copy_.data();
+  uchar* luma = ctx.luma_.data();
+
+  // Make linear copy of the screen and its luma
+
+  postproc::ForRows(ctx.threads_, h, [&](int y0, int y1)
+  {
+    __m128i mask = _mm_set1_epi32(0xff);
+    __m128i kr = _mm_set1_epi32(77);
+    __m128i kg = _mm_set1_epi32(150);
+    __m128i kb = _mm_set1_epi32(29);
+
+    for (int y = y0; y < y1; ++y)
+    {
+      int row = lay.Row(y);
+      int x = 0;
+      for (; x + 4 <= w; x += 4)
+      {
+        __m128i c = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(scr + row + lay.Col(x)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(copy + y * w + x), c);
+        __m128i r = _mm_and_si128(_mm_srli_epi32(c, 8), mask);
+        __m128i g = _mm_and_si128(_mm_srli_epi32(c, 16), mask);
+        __m128i b = _mm_srli_epi32(c, 24);
+        __m128i l = _mm_add_epi32(_mm_mullo_epi16(r, kr), _mm_mullo_epi16(g, kg));
+        l = _mm_srli_epi32(_mm_add_epi32(l, _mm_mullo_epi16(b, kb)), 8);
+        l = _mm_packus_epi16(_mm_packs_epi32(l, l), l);
+        int packed = _mm_cvtsi128_si32(l);
+        std::copy_n(reinterpret_cast<uchar*>(&packed), 4, luma + y * w + x);
+      }
+      for (; x < w; ++x)
+      {
+        copy[y * w + x] = scr[row + lay.Col(x)];
+        luma[y * w + x] = postproc_helpers::Luma(copy[y * w + x]);
+      }
+    }
+  });
+
+  // Smooth edges. Pixels are prefiltered by 16 at once with minimal luma
+  // contrast, and only candidates are processed by the full test
+
+  int threshold = std::min(std::max(ctx.fxaa_threshold_, 1), 255);
+  postproc::ForRows(ctx.threads_, h, [&](int y0, int y1)
+  {
+    __m128i thr = _mm_set1_epi8(static_cast<char>(threshold));
+    __m128i zero = _mm_setzero_si128();
+
+    for (int y = std::max(y0, 1); y < std::min(y1, h - 1); ++y)
+    {
+      int row = lay.Row(y);
+      int x = 1;
+      for (; x + 16 <= w - 1; x += 16)
+      {
+        const uchar* l = luma + y * w + x;
+        __m128i m  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(l));
+        __m128i n  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(l + w));
+        __m128i s  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(l - w));
+        __m128i e  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(l + 1));
+        __m128i wt = _mm_loadu_si128(reinterpret_cast<const __m128i*>(l - 1));
+        __m128i lmax = _mm_max_epu8(
+          _mm_max_epu8(_mm_max_epu8(n, s), _mm_max_epu8(e, wt)), m);
+        __m128i lmin = _mm_min_epu8(
+          _mm_min_epu8(_mm_min_epu8(n, s), _mm_min_epu8(e, wt)), m);
+        __m128i low = _mm_subs_epu8(thr, _mm_subs_epu8(lmax, lmin));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(low, zero));
+        while (mask)
+        {
+          int bit = __builtin_ctz(mask);
+          int i = y * w + x + bit;
+          mask &= mask - 1;
+          uint res {};
+          if (postproc_helpers::FxaaPixel(luma, copy, i, w, threshold, res))
+            scr[row + lay.Col(x + bit)] = res;
+        }
+      }
+      for (; x < w - 1; ++x)
+      {
+        uint res {};
+        if (postproc_helpers::FxaaPixel(luma, copy, y*w + x, w, threshold, res))
+          scr[row + lay.Col(x)] = res;
+      }
+    }
+  });
+}
+
+// Makes 3d lut with given contrast, saturation and tint (tint is the
+// color in 0-255 range, where white is not changing colors)
+
+void postproc::MakeLut(
+  V_Uint& lut, float contrast, float saturation, cFColor& tint)
+{
+  lut.resize(kLutSide * kLutSide * kLutSide);
+  for (int b = 0; b < kLutSide; ++b)
+    for (int g = 0; g < kLutSide; ++g)
+      for (int r = 0; r < kLutSide; ++r)
+      {
+        FColor c {r * 8.0f + 4.0f, g * 8.0f + 4.0f, b * 8.0f + 4.0f};
+        c.r_ = (c.r_ - 128.0f) * contrast + 128.0f;
+        c.g_ = (c.g_ - 128.0f) * contrast + 128.0f;
+        c.b_ = (c.b_ - 128.0f) * contrast + 128.0f;
+
+        float l = c.r_ * 0.3f + c.g_ * 0.59f + c.b_ * 0.11f;
+        c.r_ = (l + (c.r_ - l) * saturation) * tint.r_ / 255.0f;
+        c.g_ = (l + (c.g_ - l) * saturation) * tint.g_ / 255.0f;
+        c.b_ = (l + (c.b_ - l) * saturation) * tint.b_ / 255.0f;
+        c.Clamp();
+
+        lut[(b << 10) | (g << 5) | r] = c.GetARGB() & ~0xffu;
+      }
+}
+
+// Returns average of 4 colors (per channel)
+
+uint postproc_helpers::Avg4(uint a, uint b, uint c, uint d)
+{
+  uint res {0};
+  for (int sh = 0; sh < 32; sh += 8)
+  {
+    uint sum = ((a >> sh) & 0xff) + ((b >> sh) & 0xff) +
+               ((c >> sh) & 0xff) + ((d >> sh) & 0xff);
+    res |= (sum >> 2) << sh;
+  }
+  return res;
+}
+
+// Averages 2x2 blocks of 4 pixels from 2 rows and returns 2 pixels in the
+// low half of the result
+
+__m128i postproc_helpers::Halve4(const uint* r0, const uint* r1)
+{
+  __m128i v = _mm_avg_epu8(
+    _mm_loadu_si128(reinterpret_cast<const __m128i*>(r0)),
+    _mm_loadu_si128(reinterpret_cast<const __m128i*>(r1)));
+  __m128i even = _mm_shuffle_epi32(v, _MM_SHUFFLE(2,0,2,0));
+  __m128i odd  = _mm_shuffle_epi32(v, _MM_SHUFFLE(3,1,3,1));
+  return _mm_avg_epu8(even, odd);
+}
+
+// Returns sum of 5 taps [1 4 6 4 1] (in 16 bit lanes) of one half of pixels
+
+__m128i postproc_helpers::Taps16(
+  __m128i a, __m128i b, __m128i c, __m128i d, __m128i e)
+{
+  __m128i s = _mm_add_epi16(a, e);
+  s = _mm_add_epi16(s, _mm_slli_epi16(_mm_add_epi16(b, d), 2));
+  s = _mm_add_epi16(s, _mm_add_epi16(_mm_slli_epi16(c, 2), _mm_slli_epi16(c, 1)));
+  return _mm_srli_epi16(s, 4);
+}
+
+// Applies 5 taps blur to 4 pixels given by 5 loads
+
+__m128i postproc_helpers::Blur4(
+  __m128i a, __m128i b, __m128i c, __m128i d, __m128i e)
+{
+  __m128i zero = _mm_setzero_si128();
+  __m128i lo = postproc_helpers::Taps16(
+    _mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero),
+    _mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(d, zero),
+    _mm_unpacklo_epi8(e, zero));
+  __m128i hi = postproc_helpers::Taps16(
+    _mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero),
+    _mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(d, zero),
+    _mm_unpackhi_epi8(e, zero));
+  return _mm_packus_epi16(lo, hi);
+}
+
+// Applies 5 taps blur to one pixel. Taps are placed with given stride
+// and clamped by [0, n)
+
+uint postproc_helpers::BlurPixel(const uint* src, int i, int stride, int n)
+{
+  static const int kWeights[] {1, 4, 6, 4, 1};
+  uint res {0};
+  for (int sh = 0; sh < 32; sh += 8)
+  {
+    uint sum {0};
+    for (int k = -2; k <= 2; ++k)
+    {
+      int t = std::min(std::max(i + k, 0), n - 1);
+      sum += ((src[t * stride] >> sh) & 0xff) * kWeights[k + 2];
+    }
+    res |= (sum >> 4) << sh;
+  }
+  return res;
+}
+
+// Saturated addition of 2 colors (per channel)
+
+uint postproc_helpers::AddSat(uint a, uint b)
+{
+  uint res {0};
+  for (int sh = 0; sh < 32; sh += 8)
+  {
+    uint sum = ((a >> sh) & 0xff) + ((b >> sh) & 0xff);
+    res |= std::min(sum, 255u) << sh;
+  }
+  return res;
+}
+
+// Returns luma (0-255) of the color
+
+uint postproc_helpers::Luma(uint c)
+{
+  uint r = (c >> 8) & 0xff;
+  uint g = (c >> 16) & 0xff;
+  uint b = (c >> 24) & 0xff;
+  return (r * 77 + g * 150 + b * 29) >> 8;
+}
+
+// Returns index of the nearest cell of 3d lut
+
+uint postproc_helpers::LutIndex(uint c)
+{
+  return ((c >> 27) << 10) | (((c >> 19) & 31) << 5) | ((c >> 11) & 31);
+}
+
+// Smooths pixel i if it lies on the edge. Returns false if pixel is not
+// changed. Luma and copy are linear buffers with row width w
+
+bool postproc_helpers::FxaaPixel(
+  const uchar* luma, const uint* copy, int i, int w, int threshold, uint& res)
+{
+  int lm = luma[i];
+  int ln = luma[i + w];
+  int ls = luma[i - w];
+  int le = luma[i + 1];
+  int lw = luma[i - 1];
+  int lmax = std::max(std::max(std::max(ln, ls), std::max(le, lw)), lm);
+  int lmin = std::min(std::min(std::min(ln, ls), std::min(le, lw)), lm);
+  int range = lmax - lmin;
+  if (range < std::max(threshold, lmax >> 3))
+    return false;
+
+  // Choose neighbour across the edge and blend factor (0-128)
+
+  int other {};
+  bool horizontal = std::abs(ln + ls - 2 * lm) >= std::abs(le + lw - 2 * lm);
+  if (horizontal)
+    other = std::abs(ln - lm) >= std::abs(ls - lm) ? i + w : i - w;
+  else
+    other = std::abs(le - lm) >= std::abs(lw - lm) ? i + 1 : i - 1;
+
+  int avg = (ln + ls + le + lw) >> 2;
+  int f = std::min(128, std::abs(avg - lm) * 128 / range);
+
+  uint c1 = copy[i];
+  uint c2 = copy[other];
+  res = c1 & 0xff;
+  for (int sh = 8; sh < 32; sh += 8)
+  {
+    uint ch = ((c1 >> sh) & 0xff) * (256 - f) + ((c2 >> sh) & 0xff) * f;
+    res |= (ch >> 8) << sh;
+  }
+  return true;
+}
+
+// Resizes work buffers if screen size is changed
+
+void postproc_helpers::Resize(PostContext& ctx, int w, int h)
+{
+  if (ctx.w_ == w && ctx.h_ == h)
+    return;
+  ctx.w_ = w;
+  ctx.h_ = h;
+  ctx.bloom_.assign((w / 2) * (h / 2), 0);
+  ctx.bloom_tmp_.assign((w / 2) * (h / 2), 0);
+  ctx.copy_.assign(w * h, 0);
+  ctx.luma_.assign(w * h, 0);
+  ctx.vignette_built_ = -1.0f;
+}
+
+// Makes weights of rows and columns for vignette (1.0f is 65535)
+
+void postproc_helpers::MakeVignette(PostContext& ctx)
+{
+  float k = std::min(std::max(ctx.vignette_strength_, 0.0f), 1.0f);
+
+  ctx.vignette_col_.resize(ctx.w_ * 4 + 8);
+  for (int x = 0; x < ctx.w_; ++x)
+  {
+    float d = (x - ctx.w_ * 0.5f) / (ctx.w_ * 0.5f);
+    auto weight = static_cast<ushort>((1.0f - k * d * d) * 65535.0f);
+    std::fill_n(&ctx.vignette_col_[x * 4], 4, weight);
+  }
+  ctx.vignette_row_.resize(ctx.h_);
+  for (int y = 0; y < ctx.h_; ++y)
+  {
+    float d = (y - ctx.h_ * 0.5f) / (ctx.h_ * 0.5f);
+    ctx.vignette_row_[y] = static_cast<ushort>((1.0f - k * d * d) * 65535.0f);
+  }
+  ctx.vignette_built_ = ctx.vignette_strength_;
+}
+
+// Returns current time in nanoseconds
+
+long long postproc_helpers::Now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Returns milliseconds elapsed since start (in nanoseconds)
+
+float postproc_helpers::MsSince(long long start)
+{
+  return (postproc_helpers::Now() - start) / 1000000.0f;
+}
+
+} // namespace anshub
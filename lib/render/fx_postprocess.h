@@ -0,0 +1,131 @@
+// *************************************************************
+// File:    fx_postprocess.h
+// Descr:   post processing effects applied to screen buffer
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef FX_POSTPROCESS_H
+#define FX_POSTPROCESS_H
+
+#include <vector>
+#include <algorithm>
+#include <emmintrin.h>
+
+#include "lib/render/gl_scr_buffer.h"
+#include "lib/render/gl_aliases.h"
+#include "lib/render/gl_workers.h"
+#include "lib/render/fx_colors.h"
+
+namespace anshub {
+
+//****************************************************************************
+// Settings, timings and work buffers of post processing chain. Effects are
+// applied in order: bloom, color grading, vignette, fxaa
+//****************************************************************************
+
+struct PostContext
+{
+  PostContext();
+
+  bool    is_bloom_;
+  bool    is_grading_;
+  bool    is_vignette_;
+  bool    is_fxaa_;
+  int     threads_;             // workers count (including caller thread)
+  int     bloom_scale_;         // 2 - half, 4 - quarter resolution
+  int     bloom_threshold_;     // brightness (0-255) where bloom starts
+  float   bloom_strength_;      // 0.0f - 1.0f
+  float   vignette_strength_;   // 0.0f - 1.0f
+  int     fxaa_threshold_;      // min luma contrast (0-255) to smooth edge
+  V_Uint  lut_;                 // 3d lut for color grading (see note #1)
+
+  float   bloom_ms_;            // timings of effects during last frame
+  float   grading_ms_;
+  float   vignette_ms_;
+  float   fxaa_ms_;
+
+  // Work buffers (resized by postproc::Apply)
+
+  int       w_;
+  int       h_;
+  float     vignette_built_;    // strength of vignette in tables below
+  V_Uint    bloom_;             // low resolution bright pass
+  V_Uint    bloom_tmp_;         // temporary for downsampling and blur
+  V_Uint    copy_;              // linear copy of screen buffer for fxaa
+  V_Uchar   luma_;              // linear luma of screen buffer for fxaa
+  V_Ushort  vignette_col_;      // weights of columns (4 per pixel)
+  V_Ushort  vignette_row_;      // weights of rows
+
+}; // struct PostContext
+
+//****************************************************************************
+// Post processing functions
+//****************************************************************************
+
+namespace postproc {
+
+  constexpr int kLutSide = 32;  // 32*32*32 cells of 8 color levels
+
+  void Apply(PostContext&, ScrBuffer&);
+  void Bloom(PostContext&, ScrBuffer&);
+  void Grading(PostContext&, ScrBuffer&);
+  void Vignette(PostContext&, ScrBuffer&);
+  void Fxaa(PostContext&, ScrBuffer&);
+
+  void MakeLut(V_Uint&, float contrast, float saturation, cFColor& tint);
+
+  template<class Func>
+  void ForRows(int threads, int h, Func&&);
+
+} // namespace postproc
+
+namespace postproc_helpers {
+
+  void  Resize(PostContext&, int w, int h);
+  void  MakeVignette(PostContext&);
+  float MsSince(long long start_ns);
+  long long Now();
+
+  // Pixels helpers (color is stored as uint, see gl_scr_buffer.cc)
+
+  uint  Avg4(uint, uint, uint, uint);
+  uint  AddSat(uint, uint);
+  uint  Luma(uint);
+  uint  LutIndex(uint);
+  uint  BlurPixel(const uint* src, int i, int stride, int n);
+  bool  FxaaPixel(const uchar* luma, const uint*, int i, int w, int th, uint&);
+  __m128i Halve4(const uint* row_0, const uint* row_1);
+  __m128i Taps16(__m128i, __m128i, __m128i, __m128i, __m128i);
+  __m128i Blur4(__m128i, __m128i, __m128i, __m128i, __m128i);
+
+} // namespace postproc_helpers
+
+//****************************************************************************
+// Inline implementation
+//****************************************************************************
+
+// Splits rows [0; h) into equal chunks and calls func(y_begin, y_end) for
+// each chunk by the shared workers pool (see note #1 in gl_workers.h)
+
+template<class Func>
+inline void postproc::ForRows(int threads, int h, Func&& func)
+{
+  Workers::Shared().ForRanges(std::min(threads, h), h,
+    [&func](int, int y0, int y1)
+  {
+    if (y0 < y1)
+      func(y0, y1);
+  });
+}
+
+}  // namespace anshub
+
+#endif  // FX_POSTPROCESS_H
+
+// Note #1 : lut_ stores graded colors of cells centers. Grading adds the
+//  difference between graded and not graded cell center to the pixel, thus
+//  it doesn`t give banding on smooth gradients, while uses nearest lookup
+
+// Note #2 : all effects process 4 pixels at once with sse2 (baseline of
+//  x86-64). Groups of 4 pixels (x % 4 == 0) are contiguous both in linear
+//  and in tiled layouts of ScrBuffer, so effects don`t depend on layout
@@ -42,7 +42,7 @@ void raster::LineBres(
     d_err = dy;
     while (x1 != x2)
     {
-      buf[x1 + y1 * buf.Width()] = color;
+      buf(x1, y1) = color;
       if (d_err >= dx)
       {
         d_err -= dx;
@@ -56,7 +56,7 @@ void raster::LineBres(
     d_err = dx;
     while (y1 != y2)
     {
-      buf[x1 + y1 * buf.Width()] = color;
+      buf(x1, y1) = color;
       if (d_err >= dy)
       {
         d_err -= dy;
@@ -196,6 +196,61 @@ void raster::Line(
 	}
 }
 
+// Draws the line tested against 1/z buffer, where z1 and z2 are 1/z of the
+// ends. Line is clipped by screen, 1/z is interpolated linearly since it is
+// linear in screen space. Zbuffer isn`t changed
+
+void raster::LineZ(
+  float x1, float y1, float z1, float x2, float y2, float z2,
+  int color, ZBuffer& zbuf, ScrBuffer& buf) noexcept
+{
+  float dx = x2 - x1;
+  float dy = y2 - y1;
+  float dz = z2 - z1;
+  float cx1 = x1;
+  float cy1 = y1;
+  float cx2 = x2;
+  float cy2 = y2;
+  if (!segment2d::Clip(
+    0, 0, buf.Width() - 1, buf.Height() - 1, cx1, cy1, cx2, cy2))
+    return;
+
+  // Restore 1/z of clipped ends using the major axis
+
+  bool x_major = std::abs(dx) > std::abs(dy);
+  float len = x_major ? dx : dy;
+  if (math::FNotZero(len))
+  {
+    float t1 = x_major ? (cx1 - x1) / len : (cy1 - y1) / len;
+    float t2 = x_major ? (cx2 - x1) / len : (cy2 - y1) / len;
+    z2 = z1 + dz * t2;
+    z1 = z1 + dz * t1;
+  }
+
+  // Simple dda with 1/z test in each pixel
+
+  int steps = static_cast<int>(
+    std::max(std::abs(cx2 - cx1), std::abs(cy2 - cy1)));
+  float inv = steps ? 1.0f / steps : 0.0f;
+  float sx = (cx2 - cx1) * inv;
+  float sy = (cy2 - cy1) * inv;
+  float sz = (z2 - z1) * inv;
+  float x = cx1 + 0.5f;
+  float y = cy1 + 0.5f;
+  float z = z1;
+
+  for (int i = 0; i <= steps; ++i)
+  {
+    int px = static_cast<int>(x);
+    int py = static_cast<int>(y);
+    if (z >= zbuf(px, py))
+      buf(px, py) = color;
+    x += sx;
+    y += sy;
+    z += sz;
+  }
+}
+
 // Draws solid triangle. First, we should guarantee that y1 is most top, and
 // y3 is most bottom points. Then we draw top triangle from top to middle,
 // and then draw from bottom to the middle
@@ -916,6 +971,7 @@ void raster_tri::TexturedAffineFL(
 
   auto scr_ptr = scr_buf.GetPointer();
   int  scr_width = scr_buf.Width();
+  const auto& scr_lay = scr_buf.Layout();
   int  scr_height = scr_buf.Height();
   auto tex_ptr = bmp->GetPointer();
   auto tex_width = bmp->GetRowIncrement();
@@ -1118,7 +1174,7 @@ void raster_tri::TexturedAffineFL(
 
       // Draw texel
 
-      scr_ptr[x + y * scr_width] = total.GetARGB();
+      scr_ptr[scr_lay.Index(x, y)] = total.GetARGB();
     }
     
     x_lhs += dx_lhs;
@@ -1256,7 +1312,7 @@ void raster_tri::TexturedAffineFL(
 
       // Draw texel
 
-      scr_ptr[x + y * scr_width] = total.GetARGB();
+      scr_ptr[scr_lay.Index(x, y)] = total.GetARGB();
     }
   }
 }
@@ -1272,6 +1328,7 @@ void raster_tri::TexturedAffineGR(
 
   auto scr_ptr = scr_buf.GetPointer();
   int  scr_width = scr_buf.Width();
+  const auto& scr_lay = scr_buf.Layout();
   int  scr_height = scr_buf.Height();
   auto tex_ptr = bmp->GetPointer();
   auto tex_width = bmp->GetRowIncrement();
@@ -1502,7 +1559,7 @@ void raster_tri::TexturedAffineGR(
 
       // Draw point
 
-      scr_ptr[x + y * scr_width] = total.GetARGB();
+      scr_ptr[scr_lay.Index(x, y)] = total.GetARGB();
     }
     
     x_lhs += dx_lhs;
@@ -1660,7 +1717,7 @@ void raster_tri::TexturedAffineGR(
       
       // Draw point
 
-      scr_ptr[x + y * scr_width] = total.GetARGB();
+      scr_ptr[scr_lay.Index(x, y)] = total.GetARGB();
     }
   }
 }
@@ -1679,6 +1736,7 @@ int raster_tri::SolidFL(
   // Prepare fast buffers access
 
   int sbuf_w = sbuffer.Width();
+  const auto& sbuf_lay = sbuffer.Layout();
   int sbuf_h = sbuffer.Height();
   auto* s_buf = sbuffer.GetPointer();
   auto* z_buf = zbuffer.GetPointer();
@@ -1790,6 +1848,7 @@ int raster_tri::SolidFL(
 
     xlb = std::max(0, xlb);
     xrb = std::min(sbuf_w - 1, xrb);
+    int sbuf_row = sbuf_lay.Row(y);
 
     // Iterate over x line and draw pixels (alpha or not cases)
 
@@ -1797,7 +1856,7 @@ int raster_tri::SolidFL(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> buf_color {s_buf[idx]};
@@ -1813,7 +1872,7 @@ int raster_tri::SolidFL(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           s_buf[idx] = curr_color;
@@ -1926,6 +1985,7 @@ int raster_tri::SolidFL(
 
     xlb = std::max(0, xlb);
     xrb = std::min(sbuf_w - 1, xrb);
+    int sbuf_row = sbuf_lay.Row(y);
 
     // Iterate over x line and draw pixels (alpha or not cases)
 
@@ -1933,7 +1993,7 @@ int raster_tri::SolidFL(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> buf_color {s_buf[idx]};
@@ -1950,7 +2010,7 @@ int raster_tri::SolidFL(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           s_buf[idx] = curr_color;
@@ -1984,6 +2044,7 @@ int raster_tri::SolidGR(
   // Prepare fast buffers access
 
   int sbuf_w = sbuffer.Width();
+  const auto& sbuf_lay = sbuffer.Layout();
   int sbuf_h = sbuffer.Height();
   auto* s_buf = sbuffer.GetPointer();
   auto* z_buf = zbuffer.GetPointer();
@@ -2108,6 +2169,7 @@ int raster_tri::SolidGR(
 
     xlb = std::max(0, xlb);
     xrb = std::min(sbuf_w - 1, xrb);
+    int sbuf_row = sbuf_lay.Row(y);
 
     // Iterate over x line and draw pixels (alpha or not cases)
 
@@ -2115,7 +2177,7 @@ int raster_tri::SolidGR(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> buf_color {s_buf[idx]};
@@ -2133,7 +2195,7 @@ int raster_tri::SolidGR(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           s_buf[idx] = c_curr.GetARGB();
@@ -2267,6 +2329,7 @@ int raster_tri::SolidGR(
 
     xlb = std::max(0, xlb);
     xrb = std::min(sbuf_w - 1, xrb);
+    int sbuf_row = sbuf_lay.Row(y);
 
     // Iterate over x line and draw pixels (alpha or not cases)
 
@@ -2274,7 +2337,7 @@ int raster_tri::SolidGR(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> buf_color {s_buf[idx]};
@@ -2292,7 +2355,7 @@ int raster_tri::SolidGR(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           s_buf[idx] = c_curr.GetARGB();
@@ -2339,6 +2402,7 @@ int raster_tri::TexturedPerspective(
   // Prepare fast buffers access
 
   int sbuf_w = sbuf.Width();
+  const auto& sbuf_lay = sbuf.Layout();
   int sbuf_h = sbuf.Height();
   auto tex_width = bmp->GetRowIncrement();
   auto tex_texel_width = bmp->GetBytesPerPixel();
@@ -2481,6 +2545,7 @@ int raster_tri::TexturedPerspective(
 
     xlb = std::max(0, xlb);
     xrb = std::min(sbuf_w - 1, xrb);
+    int sbuf_row = sbuf_lay.Row(y);
 
     // Iterate over x line and draw pixels (alpha or not cases)
 
@@ -2488,7 +2553,7 @@ int raster_tri::TexturedPerspective(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> buf_color {s_buf[idx]};       // blend background
@@ -2521,7 +2586,7 @@ int raster_tri::TexturedPerspective(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> tex_color {};                 // bmp->get_pixel(u, v, r, g, b)
@@ -2692,6 +2757,7 @@ int raster_tri::TexturedPerspective(
 
     xlb = std::max(0, xlb);
     xrb = std::min(sbuf_w - 1, xrb);
+    int sbuf_row = sbuf_lay.Row(y);
 
     // Iterate over x line and draw pixels (alpha or not cases)
 
@@ -2699,7 +2765,7 @@ int raster_tri::TexturedPerspective(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> buf_color {s_buf[idx]};         // blend background
@@ -2732,7 +2798,7 @@ int raster_tri::TexturedPerspective(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> tex_color {};       // bmp->get_pixel(u, v, r, g, b)
@@ -2795,6 +2861,7 @@ int raster_tri::TexturedPerspectiveFL(
   // Prepare fast buffers access
 
   int sbuf_w = sbuf.Width();
+  const auto& sbuf_lay = sbuf.Layout();
   int sbuf_h = sbuf.Height();
   auto tex_width = bmp->GetRowIncrement();
   auto tex_texel_width = bmp->GetBytesPerPixel();
@@ -2938,6 +3005,7 @@ int raster_tri::TexturedPerspectiveFL(
 
     xlb = std::max(0, xlb);
     xrb = std::min(sbuf_w - 1, xrb);
+    int sbuf_row = sbuf_lay.Row(y);
 
     // Iterate over x line and draw pixels (alpha or not cases)
 
@@ -2945,7 +3013,7 @@ int raster_tri::TexturedPerspectiveFL(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> buf_color {s_buf[idx]};     // blend background
@@ -2978,7 +3046,7 @@ int raster_tri::TexturedPerspectiveFL(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> tex_color {};               // bmp->get_pixel(u, v, r, g, b)
@@ -3149,6 +3217,7 @@ int raster_tri::TexturedPerspectiveFL(
 
     xlb = std::max(0, xlb);
     xrb = std::min(sbuf_w - 1, xrb);
+    int sbuf_row = sbuf_lay.Row(y);
 
     // Iterate over x line and draw pixels (alpha or not cases)
 
@@ -3156,7 +3225,7 @@ int raster_tri::TexturedPerspectiveFL(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> buf_color {s_buf[idx]};         // blend background
@@ -3190,7 +3259,7 @@ int raster_tri::TexturedPerspectiveFL(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> tex_color {};       // bmp->get_pixel(u, v, r, g, b)
@@ -3253,6 +3322,7 @@ int raster_tri::TexturedPerspectiveFLBF(
   // Prepare fast buffers access
 
   int sbuf_w = sbuf.Width();
+  const auto& sbuf_lay = sbuf.Layout();
   int sbuf_h = sbuf.Height();
   auto tex_width = bmp->GetRowIncrement();
   auto tex_texel_width = bmp->GetBytesPerPixel();
@@ -3399,6 +3469,7 @@ int raster_tri::TexturedPerspectiveFLBF(
 
     xlb = std::max(0, xlb);
     xrb = std::min(sbuf_w - 1, xrb);
+    int sbuf_row = sbuf_lay.Row(y);
 
     // Iterate over x line and draw pixels (alpha or not cases)
 
@@ -3406,7 +3477,7 @@ int raster_tri::TexturedPerspectiveFLBF(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> buf_color {s_buf[idx]};     // blend background
@@ -3440,7 +3511,7 @@ int raster_tri::TexturedPerspectiveFLBF(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           // Get real u and v tex coords and diff from rounding for bifiltering
@@ -3661,6 +3732,7 @@ int raster_tri::TexturedPerspectiveFLBF(
 
     xlb = std::max(0, xlb);
     xrb = std::min(sbuf_w - 1, xrb);
+    int sbuf_row = sbuf_lay.Row(y);
 
     // Iterate over x line and draw pixels (alpha or not cases)
 
@@ -3668,7 +3740,7 @@ int raster_tri::TexturedPerspectiveFLBF(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> buf_color {s_buf[idx]};         // blend background
@@ -3702,7 +3774,7 @@ int raster_tri::TexturedPerspectiveFLBF(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           // Get real u and v tex coords and diff from rounding for bifiltering
@@ -3814,6 +3886,7 @@ int raster_tri::TexturedPerspectiveGR(
   // Prepare fast buffers access
 
   int sbuf_w = sbuf.Width();
+  const auto& sbuf_lay = sbuf.Layout();
   int sbuf_h = sbuf.Height();
   auto tex_width = bmp->GetRowIncrement();
   auto tex_texel_width = bmp->GetBytesPerPixel();
@@ -3976,6 +4049,7 @@ int raster_tri::TexturedPerspectiveGR(
 
     xlb = std::max(0, xlb);
     xrb = std::min(sbuf_w - 1, xrb);
+    int sbuf_row = sbuf_lay.Row(y);
 
     // Iterate over x line and draw pixels (alpha or not cases)
 
@@ -3983,7 +4057,7 @@ int raster_tri::TexturedPerspectiveGR(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> buf_color {s_buf[idx]};       // blend background
@@ -4020,7 +4094,7 @@ int raster_tri::TexturedPerspectiveGR(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> tex_color {};                 // bmp->get_pixel(u, v, r, g, b)
@@ -4214,6 +4288,7 @@ int raster_tri::TexturedPerspectiveGR(
 
     xlb = std::max(0, xlb);
     xrb = std::min(sbuf_w - 1, xrb);
+    int sbuf_row = sbuf_lay.Row(y);
 
     // Iterate over x line and draw pixels (alpha or not cases)
 
@@ -4221,7 +4296,7 @@ int raster_tri::TexturedPerspectiveGR(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> buf_color {s_buf[idx]};       // blend background
@@ -4258,7 +4333,7 @@ int raster_tri::TexturedPerspectiveGR(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> tex_color {};               // bmp->get_pixel(u, v, r, g, b)
@@ -4326,6 +4401,7 @@ int raster_tri::TexturedAffineGR(
   // Prepare fast buffers access
 
   int sbuf_w = sbuf.Width();
+  const auto& sbuf_lay = sbuf.Layout();
   int sbuf_h = sbuf.Height();
   auto tex_width = bmp->GetRowIncrement();
   auto tex_texel_width = bmp->GetBytesPerPixel();
@@ -4490,6 +4566,7 @@ int raster_tri::TexturedAffineGR(
 
     xlb = std::max(0, xlb);
     xrb = std::min(sbuf_w - 1, xrb);
+    int sbuf_row = sbuf_lay.Row(y);
 
     // Iterate over x line and draw pixels (alpha or not cases)
 
@@ -4497,7 +4574,7 @@ int raster_tri::TexturedAffineGR(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> buf_color {s_buf[idx]};     // blend background
@@ -4534,7 +4611,7 @@ int raster_tri::TexturedAffineGR(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> tex_color {};               // bmp->get_pixel(u, v, r, g, b)
@@ -4728,6 +4805,7 @@ int raster_tri::TexturedAffineGR(
 
     xlb = std::max(0, xlb);
     xrb = std::min(sbuf_w - 1, xrb);
+    int sbuf_row = sbuf_lay.Row(y);
 
     // Iterate over x line and draw pixels (alpha or not cases)
 
@@ -4735,7 +4813,7 @@ int raster_tri::TexturedAffineGR(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> buf_color {s_buf[idx]};     // blend background
@@ -4771,7 +4849,7 @@ int raster_tri::TexturedAffineGR(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> tex_color {};               // bmp->get_pixel(u, v, r, g, b)
@@ -4839,6 +4917,7 @@ int raster_tri::TexturedAffineGRBF(
   // Prepare fast buffers access
 
   int sbuf_w = sbuf.Width();
+  const auto& sbuf_lay = sbuf.Layout();
   int sbuf_h = sbuf.Height();
   auto tex_width = bmp->GetRowIncrement();
   auto tex_texel_width = bmp->GetBytesPerPixel();
@@ -5006,6 +5085,7 @@ int raster_tri::TexturedAffineGRBF(
 
     xlb = std::max(0, xlb);
     xrb = std::min(sbuf_w - 1, xrb);
+    int sbuf_row = sbuf_lay.Row(y);
 
     // Iterate over x line and draw pixels (alpha or not cases)
 
@@ -5013,7 +5093,7 @@ int raster_tri::TexturedAffineGRBF(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> buf_color {s_buf[idx]};     // blend background
@@ -5050,7 +5130,7 @@ int raster_tri::TexturedAffineGRBF(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           // Get real u and v tex coords and diff from rounding for bifiltering
@@ -5289,6 +5369,7 @@ int raster_tri::TexturedAffineGRBF(
 
     xlb = std::max(0, xlb);
     xrb = std::min(sbuf_w - 1, xrb);
+    int sbuf_row = sbuf_lay.Row(y);
 
     // Iterate over x line and draw pixels (alpha or not cases)
 
@@ -5296,7 +5377,7 @@ int raster_tri::TexturedAffineGRBF(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           Color<> buf_color {s_buf[idx]};     // blend background
@@ -5332,7 +5413,7 @@ int raster_tri::TexturedAffineGRBF(
     {
       for (int x = xlb; x < xrb; ++x)
       {
-        int idx = y * sbuf_w + x;
+        int idx = sbuf_row + sbuf_lay.Col(x);
         if (z_curr > z_buf[idx])
         {
           // Get real u and v tex coords and diff from rounding for bifiltering
@@ -5422,4 +5503,510 @@ int raster_tri::TexturedAffineGRBF(
   return total_drawn;
 }
 
+// Draws small triangle and returns numbers of drawn pixels:
+//  - bounding box scan using edge functions (pixel centers are integers
+//    as in other rasterizers)
+//  - const color for whole triangle
+//  - texture (if given) is point sampled once in the centroid
+//  - 1/z buffer
+//  - 50% fast alpha blending
+// Triangles which don`t cover any pixel center are rejected without drawing
+
+int raster_tri::Tiny(
+    cVertex& v1, cVertex& v2, cVertex& v3,
+    cFColor& color, Bitmap* bmp, ZBuffer& zbuf, ScrBuffer& sbuf) noexcept
+{
+  int total_drawn {};
+
+  // Find pixel centers bounding box clipped by screen
+
+  auto mm_x = std::minmax({v1.pos_.x, v2.pos_.x, v3.pos_.x});
+  auto mm_y = std::minmax({v1.pos_.y, v2.pos_.y, v3.pos_.y});
+  int xmin = std::max(0, (int)std::ceil(mm_x.first));
+  int xmax = std::min(sbuf.Width() - 1, (int)std::floor(mm_x.second));
+  int ymin = std::max(0, (int)std::ceil(mm_y.first));
+  int ymax = std::min(sbuf.Height() - 1, (int)std::floor(mm_y.second));
+
+  if (xmin > xmax || ymin > ymax)             // no pixel centers inside
+    return total_drawn;
+
+  float area = (v2.pos_.x - v1.pos_.x) * (v3.pos_.y - v1.pos_.y) -
+               (v3.pos_.x - v1.pos_.x) * (v2.pos_.y - v1.pos_.y);
+  if (math::Fzero(area))                      // degenerate triangle
+    return total_drawn;
+  float inv_area = 1.0f / area;
+
+  // Compute color of the whole triangle
+
+  Color<> total {color.GetARGB()};
+  if (bmp)
+  {
+    int tex_w = bmp->width();
+    int tex_h = bmp->height();
+    int u = (v1.texture_.x + v2.texture_.x + v3.texture_.x) * (tex_w-1) / 3.0f;
+    int v = (v1.texture_.y + v2.texture_.y + v3.texture_.y) * (tex_h-1) / 3.0f;
+    u = std::min(std::max(u, 0), tex_w-1);
+    v = std::min(std::max(v, 0), tex_h-1);
+
+    auto* tex_ptr = bmp->GetPointer();
+    int offset = (v * bmp->GetRowIncrement()) + (u * bmp->GetBytesPerPixel());
+    Color<> tex_color {};
+    tex_color.r_ = tex_ptr[offset + 2];
+    tex_color.g_ = tex_ptr[offset + 1];
+    tex_color.b_ = tex_ptr[offset + 0];
+
+    if (bmp->GetAlphaColor() == tex_color)
+      return total_drawn;
+    total.Modulate(tex_color);
+  }
+
+  bool alpha {color.a_ < 1.0f};
+  if (alpha)
+    color::ShiftRight(total, 1);
+  uint curr_color {total.GetARGB()};
+
+  // Prepare 1/z at the vertices
+
+  float z1 = 1.0f / v1.pos_.z;
+  float z2 = 1.0f / v2.pos_.z;
+  float z3 = 1.0f / v3.pos_.z;
+
+  // Scan bounding box and test pixel centers by barycentric coordinates
+
+  const auto& sbuf_lay = sbuf.Layout();
+  auto* s_buf = sbuf.GetPointer();
+  auto* z_buf = zbuf.GetPointer();
+
+  for (int y = ymin; y <= ymax; ++y)
+  {
+    int sbuf_row = sbuf_lay.Row(y);
+    for (int x = xmin; x <= xmax; ++x)
+    {
+      float b1 = ((v2.pos_.x - x) * (v3.pos_.y - y) -
+                  (v3.pos_.x - x) * (v2.pos_.y - y)) * inv_area;
+      float b2 = ((v3.pos_.x - x) * (v1.pos_.y - y) -
+                  (v1.pos_.x - x) * (v3.pos_.y - y)) * inv_area;
+      float b3 = 1.0f - b1 - b2;
+      if (b1 < 0.0f || b2 < 0.0f || b3 < 0.0f)
+        continue;
+
+      int idx = sbuf_row + sbuf_lay.Col(x);
+      float z_curr = b1 * z1 + b2 * z2 + b3 * z3;
+      if (z_curr > z_buf[idx])
+      {
+        if (alpha)
+        {
+          Color<> buf_color {s_buf[idx]};
+          color::ShiftRight(buf_color, 1);
+          s_buf[idx] = curr_color + buf_color.GetARGB();
+        }
+        else
+          s_buf[idx] = curr_color;
+        z_buf[idx] = z_curr;
+        ++total_drawn;
+      }
+    }
+  }
+  return total_drawn;
+}
+
+// Draws textured (affine) convex quad and returns numbers of drawn pixels:
+//  - gouraud shading
+//  - 1/z buffer
+// Vertices go around the quad (any winding). Both halves of the quad are
+// drawn by one pass over scanlines with one setup (see note #1 in header)
+
+int raster_tri::TexturedAffineGR(
+    cVertex& v1, cVertex& v2, cVertex& v3, cVertex& v4,
+    Bitmap* bmp, ZBuffer& zbuf, ScrBuffer& sbuf) noexcept
+{
+  int total_drawn {};
+
+  // Prepare fast buffers access
+
+  int sbuf_w = sbuf.Width();
+  const auto& sbuf_lay = sbuf.Layout();
+  int sbuf_h = sbuf.Height();
+  auto tex_width = bmp->GetRowIncrement();
+  auto tex_texel_width = bmp->GetBytesPerPixel();
+  auto* s_buf = sbuf.GetPointer();
+  auto* z_buf = zbuf.GetPointer();
+  auto* tex_ptr = bmp->GetPointer();
+  auto tex_transp = bmp->GetAlphaColor();
+
+  // Unnormalize texture coords, convert z to 1/z and find top and bottom.
+  // Vertices y are rounded up as in triangles rasterizers, thus shared
+  // edges are walked the same way (using top left filling convention)
+
+  Vertex vxs[4] {v1, v2, v3, v4};
+  int top {0};
+  int bot {0};
+
+  for (int i = 0; i < 4; ++i)
+  {
+    vxs[i].texture_.x *= bmp->width() - 1;
+    vxs[i].texture_.y *= bmp->height() - 1;
+    vxs[i].pos_.z = 1.0f / vxs[i].pos_.z;
+    vxs[i].pos_.y = std::ceil(vxs[i].pos_.y);
+    if (vxs[i].pos_.y > vxs[top].pos_.y)
+      top = i;
+    if (vxs[i].pos_.y < vxs[bot].pos_.y)
+      bot = i;
+  }
+
+  int y_top = std::min(sbuf_h - 1, (int)vxs[top].pos_.y);
+  int y_bot = std::max(0, (int)vxs[bot].pos_.y + 1);
+  if (y_top < y_bot)
+    return total_drawn;
+
+  // Sides are walked around the quad from top to bottom vertex in both
+  // directions. Interpolants are set to the values at the scanline y
+
+  struct Side
+  {
+    int     dir_;                           // +1 or -1 around the quad
+    int     end_;                           // vertex where side ends
+    float   x_, z_, u_, v_;
+    float   x_step_, z_step_, u_step_, v_step_;
+    FColor  c_, c_step_;
+  };
+
+  auto set_side = [&vxs](Side& s, int beg, int y)
+  {
+    s.end_ = (beg + s.dir_ + 4) % 4;
+    cVertex& a = vxs[beg];
+    cVertex& b = vxs[s.end_];
+    float dy = a.pos_.y - b.pos_.y;
+    float k = math::FNotZero(dy) ? 1.0f / dy : 0.0f;
+    s.x_step_ = (b.pos_.x - a.pos_.x) * k;
+    s.z_step_ = (b.pos_.z - a.pos_.z) * k;
+    s.u_step_ = (b.texture_.x - a.texture_.x) * k;
+    s.v_step_ = (b.texture_.y - a.texture_.y) * k;
+    s.c_step_ = (b.color_ - a.color_) * k;
+    float dy_curr = a.pos_.y - y;
+    s.x_ = a.pos_.x + s.x_step_ * dy_curr;
+    s.z_ = a.pos_.z + s.z_step_ * dy_curr;
+    s.u_ = a.texture_.x + s.u_step_ * dy_curr;
+    s.v_ = a.texture_.y + s.v_step_ * dy_curr;
+    s.c_ = a.color_ + s.c_step_ * dy_curr;
+  };
+
+  auto next_row = [](Side& s)
+  {
+    s.x_ += s.x_step_;
+    s.z_ += s.z_step_;
+    s.u_ += s.u_step_;
+    s.v_ += s.v_step_;
+    s.c_ += s.c_step_;
+  };
+
+  Side side_1 {};
+  Side side_2 {};
+  side_1.dir_ = 1;
+  side_2.dir_ = -1;
+  set_side(side_1, top, y_top);
+  set_side(side_2, top, y_top);
+
+  // Draw quad (note that 0-0 is in left bottom corner of screen)
+
+  for (int y = y_top; y >= y_bot; --y)
+  {
+    // Go to the next sides if current ones are ended at this scanline
+
+    while (side_1.end_ != bot && vxs[side_1.end_].pos_.y >= y)
+      set_side(side_1, side_1.end_, y);
+    while (side_2.end_ != bot && vxs[side_2.end_].pos_.y >= y)
+      set_side(side_2, side_2.end_, y);
+
+    const Side* lhs = &side_1;
+    const Side* rhs = &side_2;
+    if (lhs->x_ > rhs->x_)
+      std::swap(lhs, rhs);
+
+    // Convert most left and most right x pixels
+
+    int xlb = std::floor(lhs->x_);
+    int xrb = std::ceil(rhs->x_);             // guarantee no gaps
+    int dx_curr = xrb - xlb;
+
+    if (dx_curr > 0 && xrb > 0 && xlb < sbuf_w)
+    {
+      // Make interpolants and clip them from left side
+
+      float z_step = (rhs->z_ - lhs->z_) / dx_curr;
+      float u_step = (rhs->u_ - lhs->u_) / dx_curr;
+      float v_step = (rhs->v_ - lhs->v_) / dx_curr;
+      FColor c_step = (rhs->c_ - lhs->c_) / dx_curr;
+
+      int xl_dx = std::max(0, -xlb);
+      float z_curr = lhs->z_ + (z_step * xl_dx);
+      float u_curr = lhs->u_ + (u_step * xl_dx);
+      float v_curr = lhs->v_ + (v_step * xl_dx);
+      FColor c_curr = lhs->c_ + (c_step * xl_dx);
+
+      xlb = std::max(0, xlb);
+      xrb = std::min(sbuf_w, xrb);
+      int sbuf_row = sbuf_lay.Row(y);
+
+      for (int x = xlb; x < xrb; ++x)
+      {
+        int idx = sbuf_row + sbuf_lay.Col(x);
+        if (z_curr > z_buf[idx])
+        {
+          Color<> tex_color {};               // bmp->get_pixel(u, v, r, g, b)
+          int u = u_curr;
+          int v = v_curr;
+          int offset = (v * tex_width) + (u * tex_texel_width);
+
+          tex_color.r_ = tex_ptr[offset + 2];
+          tex_color.g_ = tex_ptr[offset + 1];
+          tex_color.b_ = tex_ptr[offset + 0];
+
+          if (tex_transp != tex_color)
+          {
+            Color<> total {c_curr.GetARGB()};
+            total.Modulate(tex_color);
+
+            s_buf[idx] = total.GetARGB();
+            z_buf[idx] = z_curr;
+            ++total_drawn;
+          }
+        }
+        z_curr += z_step;
+        u_curr += u_step;
+        v_curr += v_step;
+        c_curr += c_step;
+      }
+    }
+    next_row(side_1);
+    next_row(side_2);
+  }
+  return total_drawn;
+}
+
+// Draws reflective triangle and returns numbers of drawn pixels:
+//  - gouraud shading mixed with reflection image
+//  - 1/z buffer
+//  - alpha blending if vertex color is transparent
+// Sides are walked as in the quad rasterizer (see note #2 in header)
+
+int raster_tri::ReflectedGR(
+    cVertex& v1, cVertex& v2, cVertex& v3,
+    const ScrBuffer& refl, ZBuffer& zbuf, ScrBuffer& sbuf) noexcept
+{
+  int total_drawn {};
+
+  // Prepare fast buffers access
+
+  int sbuf_w = sbuf.Width();
+  int sbuf_h = sbuf.Height();
+  const auto& sbuf_lay = sbuf.Layout();
+  auto* s_buf = sbuf.GetPointer();
+  auto* z_buf = zbuf.GetPointer();
+
+  int refl_w = refl.Width();
+  int refl_h = refl.Height();
+  const auto& refl_lay = refl.Layout();
+  const auto* r_buf = refl.GetPointer();
+  float refl_kx = static_cast<float>(refl_w) / sbuf_w;
+  float refl_ky = static_cast<float>(refl_h) / sbuf_h;
+  bool alpha {v1.color_.a_ < 1.0f};
+
+  // Convert z to 1/z and find top and bottom (y are rounded up as in
+  // other rasterizers)
+
+  Vertex vxs[3] {v1, v2, v3};
+  int top {0};
+  int bot {0};
+
+  for (int i = 0; i < 3; ++i)
+  {
+    vxs[i].pos_.z = 1.0f / vxs[i].pos_.z;
+    vxs[i].pos_.y = std::ceil(vxs[i].pos_.y);
+    if (vxs[i].pos_.y > vxs[top].pos_.y)
+      top = i;
+    if (vxs[i].pos_.y < vxs[bot].pos_.y)
+      bot = i;
+  }
+
+  int y_top = std::min(sbuf_h - 1, (int)vxs[top].pos_.y);
+  int y_bot = std::max(0, (int)vxs[bot].pos_.y + 1);
+  if (y_top < y_bot)
+    return total_drawn;
+
+  struct Side
+  {
+    int     dir_;                           // +1 or -1 around the triangle
+    int     end_;                           // vertex where side ends
+    float   x_, z_;
+    float   x_step_, z_step_;
+    FColor  c_, c_step_;
+  };
+
+  auto set_side = [&vxs](Side& s, int beg, int y)
+  {
+    s.end_ = (beg + s.dir_ + 3) % 3;
+    cVertex& a = vxs[beg];
+    cVertex& b = vxs[s.end_];
+    float dy = a.pos_.y - b.pos_.y;
+    float k = math::FNotZero(dy) ? 1.0f / dy : 0.0f;
+    s.x_step_ = (b.pos_.x - a.pos_.x) * k;
+    s.z_step_ = (b.pos_.z - a.pos_.z) * k;
+    s.c_step_ = (b.color_ - a.color_) * k;
+    float dy_curr = a.pos_.y - y;
+    s.x_ = a.pos_.x + s.x_step_ * dy_curr;
+    s.z_ = a.pos_.z + s.z_step_ * dy_curr;
+    s.c_ = a.color_ + s.c_step_ * dy_curr;
+  };
+
+  auto next_row = [](Side& s)
+  {
+    s.x_ += s.x_step_;
+    s.z_ += s.z_step_;
+    s.c_ += s.c_step_;
+  };
+
+  Side side_1 {};
+  Side side_2 {};
+  side_1.dir_ = 1;
+  side_2.dir_ = -1;
+  set_side(side_1, top, y_top);
+  set_side(side_2, top, y_top);
+
+  // Draw triangle (note that 0-0 is in left bottom corner of screen)
+
+  for (int y = y_top; y >= y_bot; --y)
+  {
+    while (side_1.end_ != bot && vxs[side_1.end_].pos_.y >= y)
+      set_side(side_1, side_1.end_, y);
+    while (side_2.end_ != bot && vxs[side_2.end_].pos_.y >= y)
+      set_side(side_2, side_2.end_, y);
+
+    const Side* lhs = &side_1;
+    const Side* rhs = &side_2;
+    if (lhs->x_ > rhs->x_)
+      std::swap(lhs, rhs);
+
+    int xlb = std::floor(lhs->x_);
+    int xrb = std::ceil(rhs->x_);             // guarantee no gaps
+    int dx_curr = xrb - xlb;
+
+    if (dx_curr > 0 && xrb > 0 && xlb < sbuf_w)
+    {
+      float z_step = (rhs->z_ - lhs->z_) / dx_curr;
+      FColor c_step = (rhs->c_ - lhs->c_) / dx_curr;
+
+      int xl_dx = std::max(0, -xlb);
+      float z_curr = lhs->z_ + (z_step * xl_dx);
+      FColor c_curr = lhs->c_ + (c_step * xl_dx);
+
+      xlb = std::max(0, xlb);
+      xrb = std::min(sbuf_w, xrb);
+      int sbuf_row = sbuf_lay.Row(y);
+
+      // Mirrored image is flipped vertically (see note #2 in header)
+
+      int ry = std::min(refl_h - 1, (int)((sbuf_h - y) * refl_ky));
+      int refl_row = refl_lay.Row(ry);
+
+      for (int x = xlb; x < xrb; ++x)
+      {
+        int idx = sbuf_row + sbuf_lay.Col(x);
+        if (z_curr > z_buf[idx])
+        {
+          int rx = std::min(refl_w - 1, (int)(x * refl_kx));
+          Color<> refl_color {r_buf[refl_row + refl_lay.Col(rx)]};
+          Color<> total {c_curr.GetARGB()};
+          color::ShiftRight(refl_color, 1);
+          color::ShiftRight(total, 1);
+          uint curr_color = total.GetARGB() + refl_color.GetARGB();
+
+          if (alpha)
+          {
+            Color<> buf_color {s_buf[idx]};
+            Color<> mix_color {curr_color};
+            color::ShiftRight(buf_color, 1);
+            color::ShiftRight(mix_color, 1);
+            curr_color = mix_color.GetARGB() + buf_color.GetARGB();
+          }
+          s_buf[idx] = curr_color;
+          z_buf[idx] = z_curr;
+          ++total_drawn;
+        }
+        z_curr += z_step;
+        c_curr += c_step;
+      }
+    }
+    next_row(side_1);
+    next_row(side_2);
+  }
+  return total_drawn;
+}
+
+// Writes 1/z of triangle to zbuffer and returns numbers of written pixels.
+// Points are in screen coordinates with camera z. Barycentric coordinates
+// are stepped incrementally, and row scan stops after leaving triangle
+
+int raster_tri::Depth(
+    cVector& p1, cVector& p2, cVector& p3, ZBuffer& zbuf) noexcept
+{
+  int total_drawn {};
+
+  auto mm_x = std::minmax({p1.x, p2.x, p3.x});
+  auto mm_y = std::minmax({p1.y, p2.y, p3.y});
+  int xmin = std::max(0, (int)std::ceil(mm_x.first));
+  int xmax = std::min(zbuf.Width() - 1, (int)std::floor(mm_x.second));
+  int ymin = std::max(0, (int)std::ceil(mm_y.first));
+  int ymax = std::min(zbuf.Height() - 1, (int)std::floor(mm_y.second));
+
+  if (xmin > xmax || ymin > ymax)
+    return total_drawn;
+
+  float area = (p2.x - p1.x) * (p3.y - p1.y) - (p3.x - p1.x) * (p2.y - p1.y);
+  if (math::Fzero(area))
+    return total_drawn;
+  float inv_area = 1.0f / area;
+
+  float z1 = 1.0f / p1.z;
+  float z2 = 1.0f / p2.z;
+  float z3 = 1.0f / p3.z;
+  float b1_dx = (p2.y - p3.y) * inv_area;
+  float b2_dx = (p3.y - p1.y) * inv_area;
+  constexpr float kEps {-1e-4f};      // stepping error on shared edges
+
+  const auto& lay = zbuf.Layout();
+  auto* z_buf = zbuf.GetPointer();
+
+  for (int y = ymin; y <= ymax; ++y)
+  {
+    float b1 = ((p2.x - xmin) * (p3.y - y) - (p3.x - xmin) * (p2.y - y)) *
+               inv_area;
+    float b2 = ((p3.x - xmin) * (p1.y - y) - (p1.x - xmin) * (p3.y - y)) *
+               inv_area;
+    int row = lay.Row(y);
+    bool inside {false};
+
+    for (int x = xmin; x <= xmax; ++x, b1 += b1_dx, b2 += b2_dx)
+    {
+      float b3 = 1.0f - b1 - b2;
+      if (b1 < kEps || b2 < kEps || b3 < kEps)
+      {
+        if (inside)
+          break;
+        continue;
+      }
+      inside = true;
+
+      int idx = row + lay.Col(x);
+      float z_curr = b1 * z1 + b2 * z2 + b3 * z3;
+      if (z_curr > z_buf[idx])
+      {
+        z_buf[idx] = z_curr;
+        ++total_drawn;
+      }
+    }
+  }
+  return total_drawn;
+}
+
 } // namespace anshub
\ No newline at end of file
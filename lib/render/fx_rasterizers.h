@@ -15,6 +15,7 @@
 #include "lib/render/gl_vertex.h"
 
 #include "lib/math/vector.h"
+#include "lib/math/segment.h"
 
 #include "lib/data/bmp_loader.h"
 
@@ -39,6 +40,9 @@ namespace raster {
     int x1, int y1, int x2, int y2, int col, float, float, ScrBuffer&) noexcept;
   void LineBres(int x1, int y1, int x2, int y2, int col, ScrBuffer&) noexcept;
   void LineWu(int x1, int y1, int x2, int y2, int col, ScrBuffer&) noexcept;
+  void LineZ(
+    float x1, float y1, float z1, float x2, float y2, float z2,
+    int col, ZBuffer&, ScrBuffer&) noexcept;
   void HorizontalLine(int y, int x1, int x2, int col, ScrBuffer&) noexcept;
 
 } // namespace raster
@@ -113,6 +117,33 @@ namespace raster_tri {
     Bitmap*, ZBuffer&, ScrBuffer&    
   ) noexcept;
 
+  // Rasterizes convex quad (both halves of grid quad) with 1/z-buffering
+
+  int TexturedAffineGR(                         // v2, edge walking
+    cVertex& v1, cVertex& v2, cVertex& v3, cVertex& v4,
+    Bitmap*, ZBuffer&, ScrBuffer&
+  ) noexcept;
+
+  // Rasterizes reflective triangle with 1/z-buffering (see note #2)
+
+  int ReflectedGR(                              // v2, edge walking
+    cVertex& v1, cVertex& v2, cVertex& v3,
+    const ScrBuffer& refl, ZBuffer&, ScrBuffer&
+  ) noexcept;
+
+  // Rasterizes small triangle (few pixels) with 1/z-buffering
+
+  int Tiny(                                     // v2, bounding box scan
+    cVertex& v1, cVertex& v2, cVertex& v3,
+    cFColor& color, Bitmap*, ZBuffer&, ScrBuffer&
+  ) noexcept;
+
+  // Rasterizes triangle only to 1/z-buffer (depth pre-pass)
+
+  int Depth(                                    // v2, bounding box scan
+    cVector& p1, cVector& p2, cVector& p3, ZBuffer&
+  ) noexcept;
+
 } // namespace raster_tri
 
 
@@ -124,6 +155,8 @@ namespace raster_helpers {
 
   void SortVertices(Vertex&, Vertex&, Vertex&) noexcept;
   void UnnormalizeTexture(Vertex&, Vertex&, Vertex&, int w, int h) noexcept;
+  bool IsTinyTriangle(cVertex&, cVertex&, cVertex&, float size) noexcept;
+  bool IsConvexQuad(cVertex&, cVertex&, cVertex&, cVertex&) noexcept;
 
 } // namespace raster_helpers
 
@@ -136,7 +169,7 @@ namespace raster_helpers {
 inline void raster::Point(
   int x, int y, int color, ScrBuffer& buf) noexcept
 {
-  buf[x + y * buf.Width()] = color;
+  buf(x, y) = color;
 }
 
 // Draws point using screen buffer pointer
@@ -153,7 +186,15 @@ inline void raster::HorizontalLine(
   int y, int x1, int x2, int color, ScrBuffer& buf) noexcept
 {
   auto* ptr = buf.GetPointer();
-  std::fill_n(ptr + x1 + y * buf.Width(), x2-x1, color);
+  if (!buf.IsTiled())
+  {
+    std::fill_n(ptr + x1 + y * buf.Width(), x2-x1, color);
+    return;
+  }
+  const auto& layout = buf.Layout();
+  int row = layout.Row(y);
+  for (int x = x1; x < x2; ++x)
+    ptr[row + layout.Col(x)] = color;
 }
 
 // Sort vertices in order - v1 is the most top and v3 is the bottom
@@ -197,6 +238,51 @@ inline void raster_helpers::UnnormalizeTexture(
   v3.texture_.y *= h-1;
 }
 
+// Returns true if screen space bounding box of triangle is less than size
+
+inline bool raster_helpers::IsTinyTriangle(
+  cVertex& v1, cVertex& v2, cVertex& v3, float size) noexcept
+{
+  auto dx = std::minmax({v1.pos_.x, v2.pos_.x, v3.pos_.x});
+  auto dy = std::minmax({v1.pos_.y, v2.pos_.y, v3.pos_.y});
+  return (dx.second - dx.first) < size && (dy.second - dy.first) < size;
+}
+
+// Returns true if screen space quad (vertices go around it) is strictly
+// convex, i.e. it is not degenerate and not self-intersected
+
+inline bool raster_helpers::IsConvexQuad(
+  cVertex& v1, cVertex& v2, cVertex& v3, cVertex& v4) noexcept
+{
+  const Vector* p[4] {&v1.pos_, &v2.pos_, &v3.pos_, &v4.pos_};
+  int pos {0};
+  int neg {0};
+  for (int i = 0; i < 4; ++i)
+  {
+    cVector& a = *p[i];
+    cVector& b = *p[(i + 1) % 4];
+    cVector& c = *p[(i + 2) % 4];
+    float cross = (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
+    if (cross > 0.0f)
+      ++pos;
+    else if (cross < 0.0f)
+      ++neg;
+  }
+  return pos == 4 || neg == 4;
+}
+
 } // namespace anshub
 
-#endif  // FX_RASTERIZERS_H
\ No newline at end of file
+#endif  // FX_RASTERIZERS_H
+
+// Note #1 : quad rasterizer walks two chains of sides from the top vertex
+//  to the bottom one and interpolates attributes along them, thus on the
+//  edges shared with neighbouring quads (or triangles) values are the same
+//  as in the triangle rasterizers. Inside non planar quad the attributes
+//  are interpolated bilinearly instead of by two planes, which is not
+//  visible for small grid cells
+
+// Note #2 : reflective triangle takes mirrored image from the buffer of the
+//  lower resolution by screen coordinates (flipped vertically), mixes it
+//  with gouraud color in halves, and blends the result with the background
+//  if triangle is transparent
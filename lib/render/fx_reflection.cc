@@ -0,0 +1,140 @@
+// *************************************************************
+// File:    fx_reflection.cc
+// Descr:   low resolution cached planar reflections
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#include "fx_reflection.h"
+#include "gl_draw.h"
+
+namespace anshub {
+
+// Makes reflection with buffers of size (scr_w/div, scr_h/div)
+
+Reflection::Reflection(int scr_w, int scr_h, int div, float level, float far_z)
+  : ctx_{std::max(1, scr_w / std::max(1, div)),
+         std::max(1, scr_h / std::max(1, div)), color::Black}
+  , level_{level}
+  , far_z_{far_z}
+  , max_move_{0.5f}
+  , max_turn_{1.0f}
+  , valid_{false}
+  , vrp_{}
+  , dir_{}
+{
+  if (div <= 0)
+    throw RenderExcept("Reflection: div should be positive");
+  ctx_.is_alpha_ = false;
+}
+
+// Returns camera mirrored about the plane of reflection, with screen size
+// of the reflection buffer and reduced far plane (see note #1 in header)
+
+GlCamera reflection::MirrorCamera(const Reflection& refl, const GlCamera& cam)
+{
+  GlCamera mirror {cam};
+  mirror.vrp_.y = 2.0f * refl.level_ - cam.vrp_.y;
+  mirror.dir_.x = -cam.dir_.x;
+  mirror.dir_.z = -cam.dir_.z;
+  mirror.scr_w_ = refl.ctx_.sbuf_.Width();
+  mirror.scr_h_ = refl.ctx_.sbuf_.Height();
+  if (refl.far_z_ > 0.0f)
+    mirror.z_far_ = std::min(cam.z_far_, refl.far_z_);
+  mirror.UpdateFrustum();
+  return mirror;
+}
+
+// Returns true if camera has moved or turned too far since the last render
+
+bool reflection::NeedsUpdate(const Reflection& refl, const GlCamera& cam)
+{
+  if (!refl.valid_)
+    return true;
+  if (Vector{cam.vrp_ - refl.vrp_}.Length() > refl.max_move_)
+    return true;
+
+  float turn = std::max({
+    reflection_helpers::AngleDiff(cam.dir_.x, refl.dir_.x),
+    reflection_helpers::AngleDiff(cam.dir_.y, refl.dir_.y),
+    reflection_helpers::AngleDiff(cam.dir_.z, refl.dir_.z)
+  });
+  return turn > refl.max_turn_;
+}
+
+// Deactivates triangles (in world coordinates) which are entirely under
+// the plane of reflection and returns its count (see note #2 in header)
+
+int reflection::CullBelow(const Reflection& refl, V_Triangle& tris)
+{
+  int culled {0};
+  for (auto& tri : tris)
+  {
+    if (!tri.active_)
+      continue;
+    if (tri.vxs_[0].pos_.y < refl.level_ &&
+        tri.vxs_[1].pos_.y < refl.level_ &&
+        tri.vxs_[2].pos_.y < refl.level_)
+    {
+      tri.active_ = false;
+      ++culled;
+    }
+  }
+  return culled;
+}
+
+// The same as above, but deactivates faces of object in world coordinates
+
+int reflection::CullBelow(const Reflection& refl, GlObject& obj)
+{
+  if (!obj.active_)
+    return 0;
+
+  auto& vxs = obj.GetCoords();
+  int culled {0};
+  for (auto& face : obj.faces_)
+  {
+    if (!face.active_)
+      continue;
+    if (vxs[face[0]].pos_.y < refl.level_ &&
+        vxs[face[1]].pos_.y < refl.level_ &&
+        vxs[face[2]].pos_.y < refl.level_)
+    {
+      face.active_ = false;
+      ++culled;
+    }
+  }
+  return culled;
+}
+
+// Renders triangles (prepared by the mirrored camera) into the reflection
+// buffers and remembers state of the main camera. Returns drawn triangles
+
+int reflection::Render(Reflection& refl, const V_TrianglePtr& tris,
+                       const GlCamera& cam, const GlCamera& mirror)
+{
+  auto& ctx = refl.ctx_;
+  ctx.cam_ = const_cast<GlCamera*>(&mirror);
+
+  render_helpers::SyncBuffersLayout(ctx);
+  if (!render_helpers::IsSkyOn(ctx))    // else sky fills the rest of buffer
+    ctx.sbuf_.Clear();
+  ctx.zbuf_.Clear();
+
+  int drawn = render::Solid(tris, ctx);
+  ctx.cam_ = nullptr;
+  ctx.triangles_drawn_ = drawn;
+
+  refl.vrp_ = cam.vrp_;
+  refl.dir_ = cam.dir_;
+  refl.valid_ = true;
+  return drawn;
+}
+
+// Returns absolute difference between two angles in degrees (0 - 180)
+
+float reflection_helpers::AngleDiff(float a1, float a2)
+{
+  return std::abs(std::remainder(a1 - a2, 360.0f));
+}
+
+} // namespace anshub
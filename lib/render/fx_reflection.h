@@ -0,0 +1,74 @@
+// *************************************************************
+// File:    fx_reflection.h
+// Descr:   low resolution cached planar reflections
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef FX_REFLECTION_H
+#define FX_REFLECTION_H
+
+#include <cmath>
+#include <algorithm>
+
+#include "lib/render/gl_render_ctx.h"
+#include "lib/render/gl_aliases.h"
+#include "lib/render/gl_triangle.h"
+#include "lib/render/exceptions.h"
+#include "lib/render/cameras/gl_camera.h"
+
+#include "lib/math/vector.h"
+
+namespace anshub {
+
+//****************************************************************************
+// Image of the scene mirrored about horizontal plane y = level_, rendered
+// into buffers reduced by div in each dimension. Reflective objects sample
+// it by screen coordinates (see GlObject::reflection_), and it is reused
+// while camera moves and turns less than max_move_ and max_turn_
+//****************************************************************************
+
+struct Reflection
+{
+  Reflection(int scr_w, int scr_h, int div, float level, float far_z);
+
+  RenderContext ctx_;       // reduced buffers and render settings
+  float   level_;           // y of the mirror plane
+  float   far_z_;           // far plane of the mirrored camera
+  float   max_move_;        // distance in world units
+  float   max_turn_;        // angle in degrees
+  bool    valid_;           // false if should be rendered in any case
+  Vector  vrp_;             // camera position and direction of last render
+  Vector  dir_;
+
+}; // struct Reflection
+
+namespace reflection {
+
+  GlCamera MirrorCamera(const Reflection&, const GlCamera&);
+  bool  NeedsUpdate(const Reflection&, const GlCamera&);
+  int   CullBelow(const Reflection&, V_Triangle&);
+  int   CullBelow(const Reflection&, GlObject&);
+  int   Render(Reflection&, const V_TrianglePtr&, const GlCamera& cam,
+               const GlCamera& mirror);
+
+} // namespace reflection
+
+namespace reflection_helpers {
+
+  float AngleDiff(float a1, float a2);
+
+} // namespace reflection_helpers
+
+}  // namespace anshub
+
+#endif  // FX_REFLECTION_H
+
+// Note #1 : camera mirrored about horizontal plane is the camera with
+//  mirrored position and negated pitch and roll, which image is flipped
+//  vertically. Thus the pixel (x,y) of the screen reflects the pixel
+//  (x*w/scr_w, (scr_h-y)*h/scr_h) of the reflection buffer
+
+// Note #2 : mirrored camera is placed under the plane, thus objects under
+//  the plane should be removed before rendering. Triangles are removed
+//  entirely, without clipping by the plane (which is not visible when
+//  reflection is blended with the surface color)
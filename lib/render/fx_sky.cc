@@ -0,0 +1,196 @@
+// *************************************************************
+// File:    fx_sky.cc
+// Descr:   sky drawn by per pixel lookup of the cube map
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#include "fx_sky.h"
+
+namespace anshub {
+
+// Makes empty (black) cube map
+
+SkyCube::SkyCube(int size)
+  : size_{size}
+  , faces_{}
+{
+  if (size_ <= 0)
+    throw RenderExcept("SkyCube: size should be positive");
+  for (auto& face : faces_)
+    face.assign(size_ * size_, color::Black);
+}
+
+// Bakes cube map from object (local coordinates) by casting rays from the
+// local center through every texel (see note #1 in header)
+
+SkyCube::SkyCube(const GlObject& obj, int size)
+  : SkyCube(size)
+{
+  auto& vxs = obj.vxs_local_;
+  int last {0};                         // neighbour texels hit the same face
+
+  for (int f = 0; f < 6; ++f)
+  {
+    for (int y = 0; y < size_; ++y)
+    {
+      for (int x = 0; x < size_; ++x)
+      {
+        float s = (x + 0.5f) * 2.0f / size_ - 1.0f;
+        float t = (y + 0.5f) * 2.0f / size_ - 1.0f;
+        Vector dir = sky_helpers::FaceDirection(f, s, t);
+
+        float b2 {};
+        float b3 {};
+        int hit {-1};
+        for (int i = 0; i < (int)obj.faces_.size() && hit < 0; ++i)
+        {
+          int n = (last + i) % obj.faces_.size();
+          auto& face = obj.faces_[n];
+          if (sky_helpers::RayHitsFace(dir,
+            vxs[face[0]].pos_, vxs[face[1]].pos_, vxs[face[2]].pos_, b2, b3))
+            hit = n;
+        }
+        if (hit < 0)
+          continue;
+
+        last = hit;
+        faces_[f][y * size_ + x] =
+          sky_helpers::Bake(obj, obj.faces_[hit], b2, b3);
+      }
+    }
+  }
+}
+
+// Draws sky to pixels where 1/z is 0. View direction is linear function of
+// screen coordinates, thus it is stepped incrementally along the scanline.
+// Returns numbers of drawn pixels
+
+int sky::Draw(
+  const SkyCube& sky, const GlCamera& cam, ZBuffer& zbuf, ScrBuffer& sbuf)
+{
+  int total_drawn {};
+
+  // Camera space direction to the pixel (x,y) on the view plane is
+  // (x*kx - wov/2, y*ky - wov/2ar, dov). Rotation matrix is orthogonal,
+  // so world space direction is the same sum of transposed matrix rows
+
+  float m[9];
+  coords::World2CameraMatrix(cam.dir_, cam.trig_, m);
+  Vector row_x {m[0], m[1], m[2]};
+  Vector row_y {m[3], m[4], m[5]};
+  Vector row_z {m[6], m[7], m[8]};
+
+  float kx = cam.wov_ / cam.scr_w_;
+  float ky = cam.wov_ / (cam.scr_h_ * cam.ar_);
+  Vector dx = row_x * kx;
+  Vector dy = row_y * ky;
+  Vector origin =
+    row_x * (-cam.wov_ * 0.5f) +
+    row_y * (-cam.wov_ * 0.5f / cam.ar_) +
+    row_z * cam.dov_;
+
+  int w = std::min(sbuf.Width(), zbuf.Width());
+  int h = std::min(sbuf.Height(), zbuf.Height());
+  const auto& lay = sbuf.Layout();
+  auto* s_buf = sbuf.GetPointer();
+  auto* z_buf = zbuf.GetPointer();
+
+  for (int y = 0; y < h; ++y)
+  {
+    int row = lay.Row(y);
+    Vector dir = origin + dy * static_cast<float>(y);
+
+    for (int x = 0; x < w; ++x, dir += dx)
+    {
+      int idx = row + lay.Col(x);
+      if (z_buf[idx] == 0.0f)
+      {
+        s_buf[idx] = sky.Sample(dir);
+        ++total_drawn;
+      }
+    }
+  }
+  return total_drawn;
+}
+
+// Returns direction from the cube center to the point (s,t) of face, where
+// s and t are in range [-1;1] (inverse of SkyCube::Sample())
+
+Vector sky_helpers::FaceDirection(int face, float s, float t)
+{
+  switch (face)
+  {
+    case SkyCube::POS_X : return Vector{ 1.0f, -t, -s};
+    case SkyCube::NEG_X : return Vector{-1.0f, -t,  s};
+    case SkyCube::POS_Y : return Vector{ s,  1.0f,  t};
+    case SkyCube::NEG_Y : return Vector{ s, -1.0f, -t};
+    case SkyCube::POS_Z : return Vector{ s, -t,  1.0f};
+    default             : return Vector{-s, -t, -1.0f};
+  }
+}
+
+// Returns true if ray from the origin in direction dir hits triangle from
+// any side, and computes barycentric coords of hit point (Moller-Trumbore)
+
+bool sky_helpers::RayHitsFace(
+  cVector& dir, cVector& p1, cVector& p2, cVector& p3, float& b2, float& b3)
+{
+  constexpr float kEps {-1e-5f};        // don`t lose rays on shared edges
+
+  Vector e1 = p2 - p1;
+  Vector e2 = p3 - p1;
+  Vector p = vector::CrossProduct(dir, e2);
+  float det = vector::DotProduct(e1, p);
+  if (det == 0.0f)
+    return false;
+
+  float inv_det = 1.0f / det;
+  Vector o = Vector{0.0f, 0.0f, 0.0f} - p1;
+  b2 = vector::DotProduct(o, p) * inv_det;
+  if (b2 < kEps || b2 > 1.0f - kEps)
+    return false;
+
+  Vector q = vector::CrossProduct(o, e1);
+  b3 = vector::DotProduct(dir, q) * inv_det;
+  if (b3 < kEps || b2 + b3 > 1.0f - kEps)
+    return false;
+
+  return vector::DotProduct(e2, q) * inv_det > 0.0f;
+}
+
+// Returns color of object`s face at the point with given barycentric coords
+// as it would be drawn by rasterizers (texel modulated by light color)
+
+uint sky_helpers::Bake(const GlObject& obj, const Face& face, float b2, float b3)
+{
+  auto& vxs = obj.vxs_local_;
+  auto& lit = obj.GetCoords();
+  float b1 = 1.0f - b2 - b3;
+
+  FColor light {face.color_};
+  if (obj.shading_ == Shading::GOURANG)
+    light = lit[face[0]].color_ * b1 + lit[face[1]].color_ * b2 +
+            lit[face[2]].color_ * b3;
+
+  if (obj.textures_.empty())
+    return light.GetARGB();
+
+  auto* bmp = obj.textures_.front().get();
+  Vector tex = vxs[face[0]].texture_ * b1 + vxs[face[1]].texture_ * b2 +
+               vxs[face[2]].texture_ * b3;
+  int u = std::min(std::max(tex.x, 0.0f), 1.0f) * (bmp->width() - 1);
+  int v = std::min(std::max(tex.y, 0.0f), 1.0f) * (bmp->height() - 1);
+
+  uchar r, g, b;
+  bmp->get_pixel(u, v, r, g, b);
+  Color<> total {r, g, b};
+  if (obj.shading_ != Shading::CONST)
+  {
+    Color<> lc {light.GetARGB()};
+    lc.Modulate(total);
+    total = lc;
+  }
+  return total.GetARGB();
+}
+
+} // namespace anshub
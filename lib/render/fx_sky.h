@@ -0,0 +1,120 @@
+// *************************************************************
+// File:    fx_sky.h
+// Descr:   sky drawn by per pixel lookup of the cube map
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef FX_SKY_H
+#define FX_SKY_H
+
+#include <array>
+#include <cmath>
+#include <algorithm>
+
+#include "lib/render/gl_scr_buffer.h"
+#include "lib/render/gl_z_buffer.h"
+#include "lib/render/gl_aliases.h"
+#include "lib/render/gl_object.h"
+#include "lib/render/gl_coords.h"
+#include "lib/render/fx_colors.h"
+#include "lib/render/exceptions.h"
+#include "lib/render/cameras/gl_camera.h"
+
+#include "lib/math/vector.h"
+
+namespace anshub {
+
+//****************************************************************************
+// Cube map of six square faces (+x, -x, +y, -y, +z, -z) with colors in the
+// screen buffer format. Faces are addressed by world space direction, thus
+// the sky doesn`t depend on camera position
+//****************************************************************************
+
+struct SkyCube
+{
+  enum Faces { POS_X, NEG_X, POS_Y, NEG_Y, POS_Z, NEG_Z };
+
+  explicit SkyCube(int size);
+  SkyCube(const GlObject&, int size);
+
+  uint  Sample(cVector& dir) const;
+
+  int   size_;
+  std::array<V_Uint, 6> faces_;     // rows of texels, row 0 is the top
+
+}; // struct SkyCube
+
+//****************************************************************************
+// Sky pass. Draws sky to pixels which aren`t covered by the scene (z-buffer
+// value is 0), thus pixels are shaded once and screen clear may be skipped
+//****************************************************************************
+
+namespace sky {
+
+  int   Draw(const SkyCube&, const GlCamera&, ZBuffer&, ScrBuffer&);
+
+} // namespace sky
+
+namespace sky_helpers {
+
+  Vector FaceDirection(int face, float s, float t);
+  bool  RayHitsFace(
+    cVector& dir, cVector& p1, cVector& p2, cVector& p3,
+    float& b2, float& b3);
+  uint  Bake(const GlObject&, const Face&, float b2, float b3);
+
+} // namespace sky_helpers
+
+//****************************************************************************
+// Inline implementation
+//****************************************************************************
+
+// Returns texel of cube map in given direction (direction isn`t normalized).
+// Face is chosen by major axis, and other two axes are projected to it
+
+inline uint SkyCube::Sample(cVector& d) const
+{
+  float ax = std::abs(d.x);
+  float ay = std::abs(d.y);
+  float az = std::abs(d.z);
+  float ma {};
+  float s {};
+  float t {};
+  int face {};
+
+  if (ax >= ay && ax >= az)
+  {
+    ma = ax;
+    face = d.x > 0.0f ? POS_X : NEG_X;
+    s = d.x > 0.0f ? -d.z : d.z;
+    t = -d.y;
+  }
+  else if (ay >= az)
+  {
+    ma = ay;
+    face = d.y > 0.0f ? POS_Y : NEG_Y;
+    s = d.x;
+    t = d.y > 0.0f ? d.z : -d.z;
+  }
+  else
+  {
+    ma = az;
+    face = d.z > 0.0f ? POS_Z : NEG_Z;
+    s = d.z > 0.0f ? d.x : -d.x;
+    t = -d.y;
+  }
+
+  float k = 0.5f * size_ / ma;
+  int u = std::min(size_ - 1, static_cast<int>((s + ma) * k));
+  int v = std::min(size_ - 1, static_cast<int>((t + ma) * k));
+  return faces_[face][v * size_ + u];
+}
+
+}  // namespace anshub
+
+#endif  // FX_SKY_H
+
+// Note #1 : SkyCube may be baked from any textured object which encloses
+//  its local center, and every ray from the center hits the object once
+//  (i.e. usual skybox or sky sphere). Lighting of the object is baked too,
+//  so it should be lighted before baking if the sky has static lights
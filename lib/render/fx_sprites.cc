@@ -0,0 +1,162 @@
+// *************************************************************
+// File:    fx_sprites.cc
+// Descr:   run-length encoded sprites and 2d blitter
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#include <cstring>
+#include <algorithm>
+
+#include "fx_sprites.h"
+
+namespace anshub {
+
+// Encodes bitmap to spans of opaque pixels
+
+Sprite::Sprite(const Bitmap& bmp)
+  : w_(bmp.width())
+  , h_(bmp.height())
+  , pixels_{}
+  , spans_{}
+  , rows_{}
+{
+  auto transp = bmp.GetAlphaColor();
+  rows_.reserve(h_ + 1);
+
+  for (int y = 0; y < h_; ++y)
+  {
+    rows_.push_back(spans_.size());
+    int x = 0;
+    while (x < w_)
+    {
+      // Skip transparent run
+
+      Color<> c {};
+      uchar r, g, b;
+      for (; x < w_; ++x)
+      {
+        bmp.get_pixel(x, y, r, g, b);
+        c = Color<>(r, g, b);
+        if (c != transp)
+          break;
+      }
+      if (x == w_)
+        break;
+
+      // Store opaque run
+
+      Span span {x, 0, static_cast<int>(pixels_.size())};
+      for (; x < w_; ++x)
+      {
+        bmp.get_pixel(x, y, r, g, b);
+        c = Color<>(r, g, b);
+        if (c == transp)
+          break;
+        pixels_.push_back(c.GetARGB());
+        ++span.len_;
+      }
+      spans_.push_back(span);
+    }
+  }
+  rows_.push_back(spans_.size());
+}
+
+// Draws sprite with replacing screen pixels (opaque or color keyed blit)
+
+void sprite::Draw(const Sprite& spr, int x, int y, ScrBuffer& buf, int scale)
+{
+  sprite_helpers::WalkSpans(spr, x, y, scale, buf, sprite_helpers::Copy);
+}
+
+// Draws sprite blended with screen using constant alpha (0.0f - 1.0f)
+
+void sprite::DrawAlpha(
+  const Sprite& spr, int x, int y, float a, ScrBuffer& buf, int scale)
+{
+  int alpha = std::min(std::max(a, 0.0f), 1.0f) * 256.0f;
+  sprite_helpers::WalkSpans(spr, x, y, scale, buf,
+    [alpha](uint* dst, const uint* src, int cnt)
+    {
+      sprite_helpers::Blend(dst, src, cnt, alpha);
+    });
+}
+
+// Draws sprite added to screen pixels with saturation (i.e. for glowing)
+
+void sprite::DrawAdditive(
+  const Sprite& spr, int x, int y, ScrBuffer& buf, int scale)
+{
+  sprite_helpers::WalkSpans(spr, x, y, scale, buf, sprite_helpers::Add);
+}
+
+// Copies pixels
+
+void sprite_helpers::Copy(uint* dst, const uint* src, int cnt)
+{
+  std::memcpy(dst, src, cnt * sizeof(uint));
+}
+
+// Blends pixels using alpha in range 0-256: dst = (src*a + dst*(256-a))/256
+
+void sprite_helpers::Blend(uint* dst, const uint* src, int cnt, int alpha)
+{
+  __m128i zero = _mm_setzero_si128();
+  __m128i ka = _mm_set1_epi16(alpha);
+  __m128i kb = _mm_set1_epi16(256 - alpha);
+
+  int i = 0;
+  for (; i + 4 <= cnt; i += 4)
+  {
+    auto* d = reinterpret_cast<__m128i*>(dst + i);
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i b = _mm_loadu_si128(d);
+    __m128i lo = _mm_add_epi16(
+      _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), ka),
+      _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), kb));
+    __m128i hi = _mm_add_epi16(
+      _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), ka),
+      _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), kb));
+    lo = _mm_srli_epi16(lo, 8);
+    hi = _mm_srli_epi16(hi, 8);
+    _mm_storeu_si128(d, _mm_packus_epi16(lo, hi));
+  }
+  for (; i < cnt; ++i)
+  {
+    uint res {0};
+    for (int sh = 0; sh < 32; sh += 8)
+    {
+      uint c = ((src[i] >> sh) & 0xff) * alpha +
+               ((dst[i] >> sh) & 0xff) * (256 - alpha);
+      res |= (c >> 8) << sh;
+    }
+    dst[i] = res;
+  }
+}
+
+// Adds pixels with saturation (alpha byte of dst is kept)
+
+void sprite_helpers::Add(uint* dst, const uint* src, int cnt)
+{
+  __m128i mask = _mm_set1_epi32(static_cast<int>(0xffffff00));
+
+  int i = 0;
+  for (; i + 4 <= cnt; i += 4)
+  {
+    auto* d = reinterpret_cast<__m128i*>(dst + i);
+    __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    s = _mm_and_si128(s, mask);
+    _mm_storeu_si128(d, _mm_adds_epu8(_mm_loadu_si128(d), s));
+  }
+  for (; i < cnt; ++i)
+  {
+    uint res {dst[i] & 0xff};
+    for (int sh = 8; sh < 32; sh += 8)
+    {
+      uint c = ((src[i] >> sh) & 0xff) + ((dst[i] >> sh) & 0xff);
+      res |= std::min(c, 255u) << sh;
+    }
+    dst[i] = res;
+  }
+}
+
+} // namespace anshub
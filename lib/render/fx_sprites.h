@@ -0,0 +1,145 @@
+// *************************************************************
+// File:    fx_sprites.h
+// Descr:   run-length encoded sprites and 2d blitter
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef FX_SPRITES_H
+#define FX_SPRITES_H
+
+#include <vector>
+#include <algorithm>
+#include <emmintrin.h>
+
+#include "lib/render/gl_scr_buffer.h"
+#include "lib/render/gl_aliases.h"
+#include "lib/render/fx_colors.h"
+
+#include "lib/data/bmp_loader.h"
+
+namespace anshub {
+
+//****************************************************************************
+// Sprite made from bitmap, where each row is encoded as spans of opaque
+// pixels. Pixels of bitmap equal to its alpha color are transparent and
+// aren`t stored (if bitmap has no alpha color, sprite has one span per row)
+//****************************************************************************
+
+struct Sprite
+{
+  struct Span
+  {
+    int x_;           // start of the span in the row
+    int len_;         // count of pixels
+    int offset_;      // index of the first pixel in pixels_
+  };
+
+  explicit Sprite(const Bitmap&);
+
+  int Width() const { return w_; }
+  int Height() const { return h_; }
+  int OpaquePixels() const { return pixels_.size(); }
+
+  int w_;
+  int h_;
+  V_Uint pixels_;                 // opaque pixels of all spans
+  std::vector<Span> spans_;       // spans of all rows (from top row)
+  std::vector<int>  rows_;        // index of first span of each row (h_ + 1)
+
+}; // struct Sprite
+
+//****************************************************************************
+// Functions to draw sprites. Position (x, y) is the left-bottom corner of
+// the sprite on the screen, scale is the integer magnification
+//****************************************************************************
+
+namespace sprite {
+
+  void Draw(const Sprite&, int x, int y, ScrBuffer&, int scale = 1);
+  void DrawAlpha(const Sprite&, int x, int y, float a, ScrBuffer&, int scale = 1);
+  void DrawAdditive(const Sprite&, int x, int y, ScrBuffer&, int scale = 1);
+
+} // namespace sprite
+
+namespace sprite_helpers {
+
+  void Copy(uint* dst, const uint* src, int cnt);
+  void Blend(uint* dst, const uint* src, int cnt, int alpha);
+  void Add(uint* dst, const uint* src, int cnt);
+
+  template<class Spr, class Func>
+  void WalkSpans(const Spr&, int x, int y, int scale, ScrBuffer&, Func);
+
+} // namespace sprite_helpers
+
+//****************************************************************************
+// Inline implementation
+//****************************************************************************
+
+// Walks through all visible spans of the sprite and calls func for each
+// contiguous part of the span in the screen buffer. If scale is greater
+// than 1, span is expanded once and then is copied to scale rows. Spr is
+// any struct with Sprite`s members layout (see TextRun in fx_text.h)
+
+template<class Spr, class Func>
+inline void sprite_helpers::WalkSpans(
+  const Spr& spr, int x, int y, int scale, ScrBuffer& buf, Func func)
+{
+  scale = std::max(scale, 1);
+  const auto& lay = buf.Layout();
+  uint* scr = buf.GetPointer();
+  int w = buf.Width();
+  int h = buf.Height();
+  decltype(spr.pixels_) expanded {};
+
+  for (int row = 0; row < spr.h_; ++row)
+  {
+    // Sprite rows are stored from top, while screen y is from bottom
+
+    int top = y + (spr.h_ - row) * scale - 1;
+    int bottom = top - scale + 1;
+    if (bottom >= h || top < 0)
+      continue;
+
+    for (int i = spr.rows_[row]; i < spr.rows_[row + 1]; ++i)
+    {
+      const auto& span = spr.spans_[i];
+      int x0 = x + span.x_ * scale;
+      int x1 = x0 + span.len_ * scale;
+      int cx0 = std::max(x0, 0);
+      int cx1 = std::min(x1, w);
+      if (cx0 >= cx1)
+        continue;
+
+      const auto* src = &spr.pixels_[span.offset_];
+      if (scale > 1)
+      {
+        expanded.resize(span.len_ * scale);
+        for (int k = 0; k < span.len_; ++k)
+          std::fill_n(&expanded[k * scale], scale, src[k]);
+        src = expanded.data();
+      }
+      src += cx0 - x0;
+
+      for (int sy = std::max(bottom, 0); sy <= std::min(top, h - 1); ++sy)
+      {
+        int scr_row = lay.Row(sy);
+        const auto* s = src;
+        for (int sx = cx0; sx < cx1; )
+        {
+          int cnt = std::min(cx1 - sx, lay.Contiguous(sx));
+          func(scr + scr_row + lay.Col(sx), s, cnt);
+          sx += cnt;
+          s += cnt;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace anshub
+
+#endif  // FX_SPRITES_H
+
+// Note #1 : cost of drawing is proportional to count of opaque pixels,
+//  since transparent runs are skipped entirely while encoding
@@ -0,0 +1,374 @@
+// *************************************************************
+// File:    fx_text.cc
+// Descr:   software text output to screen buffer using glyph atlas
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#include <cstring>
+#include <algorithm>
+
+#include "fx_text.h"
+
+namespace anshub {
+
+// Built-in 8x8 font (ascii 32-126), byte is a row from top, low bit is
+// the left pixel
+
+const uchar font_8x8[text_helpers::kFontCount * text_helpers::kFontSide] {
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,  // space
+  0x18,0x3c,0x3c,0x18,0x18,0x00,0x18,0x00,  // !
+  0x36,0x36,0x00,0x00,0x00,0x00,0x00,0x00,  // "
+  0x36,0x36,0x7f,0x36,0x7f,0x36,0x36,0x00,  // #
+  0x0c,0x3e,0x03,0x1e,0x30,0x1f,0x0c,0x00,  // $
+  0x00,0x63,0x33,0x18,0x0c,0x66,0x63,0x00,  // %
+  0x1c,0x36,0x1c,0x6e,0x3b,0x33,0x6e,0x00,  // &
+  0x06,0x06,0x03,0x00,0x00,0x00,0x00,0x00,  // '
+  0x18,0x0c,0x06,0x06,0x06,0x0c,0x18,0x00,  // (
+  0x06,0x0c,0x18,0x18,0x18,0x0c,0x06,0x00,  // )
+  0x00,0x66,0x3c,0xff,0x3c,0x66,0x00,0x00,  // *
+  0x00,0x0c,0x0c,0x3f,0x0c,0x0c,0x00,0x00,  // +
+  0x00,0x00,0x00,0x00,0x00,0x0c,0x0c,0x06,  // ,
+  0x00,0x00,0x00,0x3f,0x00,0x00,0x00,0x00,  // -
+  0x00,0x00,0x00,0x00,0x00,0x0c,0x0c,0x00,  // .
+  0x60,0x30,0x18,0x0c,0x06,0x03,0x01,0x00,  // /
+  0x3e,0x63,0x73,0x7b,0x6f,0x67,0x3e,0x00,  // 0
+  0x0c,0x0e,0x0c,0x0c,0x0c,0x0c,0x3f,0x00,  // 1
+  0x1e,0x33,0x30,0x1c,0x06,0x33,0x3f,0x00,  // 2
+  0x1e,0x33,0x30,0x1c,0x30,0x33,0x1e,0x00,  // 3
+  0x38,0x3c,0x36,0x33,0x7f,0x30,0x78,0x00,  // 4
+  0x3f,0x03,0x1f,0x30,0x30,0x33,0x1e,0x00,  // 5
+  0x1c,0x06,0x03,0x1f,0x33,0x33,0x1e,0x00,  // 6
+  0x3f,0x33,0x30,0x18,0x0c,0x0c,0x0c,0x00,  // 7
+  0x1e,0x33,0x33,0x1e,0x33,0x33,0x1e,0x00,  // 8
+  0x1e,0x33,0x33,0x3e,0x30,0x18,0x0e,0x00,  // 9
+  0x00,0x0c,0x0c,0x00,0x00,0x0c,0x0c,0x00,  // :
+  0x00,0x0c,0x0c,0x00,0x00,0x0c,0x0c,0x06,  // ;
+  0x18,0x0c,0x06,0x03,0x06,0x0c,0x18,0x00,  // <
+  0x00,0x00,0x3f,0x00,0x00,0x3f,0x00,0x00,  // =
+  0x06,0x0c,0x18,0x30,0x18,0x0c,0x06,0x00,  // >
+  0x1e,0x33,0x30,0x18,0x0c,0x00,0x0c,0x00,  // ?
+  0x3e,0x63,0x7b,0x7b,0x7b,0x03,0x1e,0x00,  // @
+  0x0c,0x1e,0x33,0x33,0x3f,0x33,0x33,0x00,  // A
+  0x3f,0x66,0x66,0x3e,0x66,0x66,0x3f,0x00,  // B
+  0x3c,0x66,0x03,0x03,0x03,0x66,0x3c,0x00,  // C
+  0x1f,0x36,0x66,0x66,0x66,0x36,0x1f,0x00,  // D
+  0x7f,0x46,0x16,0x1e,0x16,0x46,0x7f,0x00,  // E
+  0x7f,0x46,0x16,0x1e,0x16,0x06,0x0f,0x00,  // F
+  0x3c,0x66,0x03,0x03,0x73,0x66,0x7c,0x00,  // G
+  0x33,0x33,0x33,0x3f,0x33,0x33,0x33,0x00,  // H
+  0x1e,0x0c,0x0c,0x0c,0x0c,0x0c,0x1e,0x00,  // I
+  0x78,0x30,0x30,0x30,0x33,0x33,0x1e,0x00,  // J
+  0x67,0x66,0x36,0x1e,0x36,0x66,0x67,0x00,  // K
+  0x0f,0x06,0x06,0x06,0x46,0x66,0x7f,0x00,  // L
+  0x63,0x77,0x7f,0x7f,0x6b,0x63,0x63,0x00,  // M
+  0x63,0x67,0x6f,0x7b,0x73,0x63,0x63,0x00,  // N
+  0x1c,0x36,0x63,0x63,0x63,0x36,0x1c,0x00,  // O
+  0x3f,0x66,0x66,0x3e,0x06,0x06,0x0f,0x00,  // P
+  0x1e,0x33,0x33,0x33,0x3b,0x1e,0x38,0x00,  // Q
+  0x3f,0x66,0x66,0x3e,0x36,0x66,0x67,0x00,  // R
+  0x1e,0x33,0x07,0x0e,0x38,0x33,0x1e,0x00,  // S
+  0x3f,0x2d,0x0c,0x0c,0x0c,0x0c,0x1e,0x00,  // T
+  0x33,0x33,0x33,0x33,0x33,0x33,0x3f,0x00,  // U
+  0x33,0x33,0x33,0x33,0x33,0x1e,0x0c,0x00,  // V
+  0x63,0x63,0x63,0x6b,0x7f,0x77,0x63,0x00,  // W
+  0x63,0x63,0x36,0x1c,0x1c,0x36,0x63,0x00,  // X
+  0x33,0x33,0x33,0x1e,0x0c,0x0c,0x1e,0x00,  // Y
+  0x7f,0x63,0x31,0x18,0x4c,0x66,0x7f,0x00,  // Z
+  0x1e,0x06,0x06,0x06,0x06,0x06,0x1e,0x00,  // [
+  0x03,0x06,0x0c,0x18,0x30,0x60,0x40,0x00,  // backslash
+  0x1e,0x18,0x18,0x18,0x18,0x18,0x1e,0x00,  // ]
+  0x08,0x1c,0x36,0x63,0x00,0x00,0x00,0x00,  // ^
+  0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xff,  // _
+  0x0c,0x0c,0x18,0x00,0x00,0x00,0x00,0x00,  // `
+  0x00,0x00,0x1e,0x30,0x3e,0x33,0x6e,0x00,  // a
+  0x07,0x06,0x06,0x3e,0x66,0x66,0x3b,0x00,  // b
+  0x00,0x00,0x1e,0x33,0x03,0x33,0x1e,0x00,  // c
+  0x38,0x30,0x30,0x3e,0x33,0x33,0x6e,0x00,  // d
+  0x00,0x00,0x1e,0x33,0x3f,0x03,0x1e,0x00,  // e
+  0x1c,0x36,0x06,0x0f,0x06,0x06,0x0f,0x00,  // f
+  0x00,0x00,0x6e,0x33,0x33,0x3e,0x30,0x1f,  // g
+  0x07,0x06,0x36,0x6e,0x66,0x66,0x67,0x00,  // h
+  0x0c,0x00,0x0e,0x0c,0x0c,0x0c,0x1e,0x00,  // i
+  0x30,0x00,0x30,0x30,0x30,0x33,0x33,0x1e,  // j
+  0x07,0x06,0x66,0x36,0x1e,0x36,0x67,0x00,  // k
+  0x0e,0x0c,0x0c,0x0c,0x0c,0x0c,0x1e,0x00,  // l
+  0x00,0x00,0x33,0x7f,0x7f,0x6b,0x63,0x00,  // m
+  0x00,0x00,0x1f,0x33,0x33,0x33,0x33,0x00,  // n
+  0x00,0x00,0x1e,0x33,0x33,0x33,0x1e,0x00,  // o
+  0x00,0x00,0x3b,0x66,0x66,0x3e,0x06,0x0f,  // p
+  0x00,0x00,0x6e,0x33,0x33,0x3e,0x30,0x78,  // q
+  0x00,0x00,0x3b,0x6e,0x66,0x06,0x0f,0x00,  // r
+  0x00,0x00,0x3e,0x03,0x1e,0x30,0x1f,0x00,  // s
+  0x08,0x0c,0x3e,0x0c,0x0c,0x2c,0x18,0x00,  // t
+  0x00,0x00,0x33,0x33,0x33,0x33,0x6e,0x00,  // u
+  0x00,0x00,0x33,0x33,0x33,0x1e,0x0c,0x00,  // v
+  0x00,0x00,0x63,0x6b,0x7f,0x7f,0x36,0x00,  // w
+  0x00,0x00,0x63,0x36,0x1c,0x36,0x63,0x00,  // x
+  0x00,0x00,0x33,0x33,0x33,0x3e,0x30,0x1f,  // y
+  0x00,0x00,0x3f,0x19,0x0c,0x26,0x3f,0x00,  // z
+  0x38,0x0c,0x0c,0x07,0x0c,0x0c,0x38,0x00,  // {
+  0x18,0x18,0x18,0x00,0x18,0x18,0x18,0x00,  // |
+  0x07,0x0c,0x0c,0x38,0x0c,0x0c,0x07,0x00,  // }
+  0x6e,0x3b,0x00,0x00,0x00,0x00,0x00,0x00,  // ~
+};
+
+// Bakes built-in font magnified by integer scale
+
+GlyphAtlas::GlyphAtlas(int scale)
+  : glyph_w_{text_helpers::kFontSide * std::max(scale, 1)}
+  , glyph_h_{glyph_w_}
+  , first_{text_helpers::kFontFirst}
+  , count_{text_helpers::kFontCount}
+  , cov_(count_ * glyph_w_ * glyph_h_, 0)
+{
+  scale = std::max(scale, 1);
+  for (int g = 0; g < count_; ++g)
+  {
+    uchar* glyph = &cov_[g * glyph_w_ * glyph_h_];
+    for (int y = 0; y < glyph_h_; ++y)
+    {
+      uchar bits = font_8x8[g * text_helpers::kFontSide + y / scale];
+      for (int x = 0; x < glyph_w_; ++x)
+        glyph[y * glyph_w_ + x] = ((bits >> (x / scale)) & 1) ? 255 : 0;
+    }
+  }
+}
+
+// Bakes font from bitmap, where glyphs are placed in the grid with cols
+// columns from the top-left corner. Luma of pixel is its coverage (light
+// glyphs on the dark background), alpha color of bitmap is empty pixel
+
+GlyphAtlas::GlyphAtlas(const Bitmap& bmp, int cols, int first, int count)
+  : glyph_w_{}
+  , glyph_h_{}
+  , first_{first}
+  , count_{count}
+  , cov_{}
+{
+  if (cols <= 0 || count <= 0)
+    throw RenderExcept("GlyphAtlas: wrong glyphs grid");
+
+  int rows = (count + cols - 1) / cols;
+  glyph_w_ = bmp.width() / cols;
+  glyph_h_ = bmp.height() / rows;
+  if (!glyph_w_ || !glyph_h_)
+    throw RenderExcept("GlyphAtlas: bitmap is less than glyphs grid");
+
+  auto transp = bmp.GetAlphaColor();
+  cov_.resize(count_ * glyph_w_ * glyph_h_);
+  for (int i = 0; i < count_; ++i)
+  {
+    uchar* glyph = &cov_[i * glyph_w_ * glyph_h_];
+    int bx = (i % cols) * glyph_w_;
+    int by = (i / cols) * glyph_h_;
+    for (int y = 0; y < glyph_h_; ++y)
+    {
+      for (int x = 0; x < glyph_w_; ++x)
+      {
+        uchar r, g, b;
+        bmp.get_pixel(bx + x, by + y, r, g, b);
+        if (Color<>(r, g, b) == transp)
+          glyph[y * glyph_w_ + x] = 0;
+        else
+          glyph[y * glyph_w_ + x] = (r * 77 + g * 150 + b * 29) >> 8;
+      }
+    }
+  }
+}
+
+// Returns pointer to glyph coverage or nullptr if font hasn`t glyph
+
+const uchar* GlyphAtlas::Glyph(char c) const
+{
+  int idx = static_cast<uchar>(c) - first_;
+  if (idx < 0 || idx >= count_)
+    return nullptr;
+  return &cov_[idx * glyph_w_ * glyph_h_];
+}
+
+SoftText::SoftText() : SoftText(GlyphAtlas()) { }
+
+SoftText::SoftText(const GlyphAtlas& atlas)
+  : atlas_{atlas}
+  , color_{color::White}
+  , frame_{0}
+  , cache_{}
+  , queue_{}
+{ }
+
+// Queues string to be drawn at (x, y) - left-bottom corner of the text
+
+void SoftText::PrintString(int x, int y, const char* str)
+{
+  PrintString(x, y, str, color_);
+}
+
+void SoftText::PrintString(int x, int y, const char* str, uint color)
+{
+  if (str && *str)
+    queue_.push_back(Line{x, y, color, &Shape(str)});
+}
+
+// Draws queued strings and evicts runs which weren`t used (see note #1)
+
+void SoftText::Flush(ScrBuffer& buf)
+{
+  for (const auto& line : queue_)
+  {
+    uint color = line.color_;
+    sprite_helpers::WalkSpans(*line.run_, line.x_, line.y_, 1, buf,
+      [color](uint* dst, const uchar* cov, int cnt)
+      {
+        text_helpers::BlendCoverage(dst, cov, cnt, color);
+      });
+  }
+  queue_.clear();
+
+  for (auto it = cache_.begin(); it != cache_.end(); )
+  {
+    if (it->second.frame_ != frame_)
+      it = cache_.erase(it);
+    else
+      ++it;
+  }
+  ++frame_;
+}
+
+// Returns cached run of the string or shapes it. Strings may contain
+// new lines
+
+const TextRun& SoftText::Shape(const std::string& str)
+{
+  auto it = cache_.find(str);
+  if (it != cache_.end())
+  {
+    it->second.frame_ = frame_;
+    return it->second.run_;
+  }
+
+  int lines {1};
+  int cols {0};
+  int max_cols {0};
+  for (auto c : str)
+  {
+    if (c == '\n') {
+      ++lines;
+      cols = 0;
+    }
+    else
+      max_cols = std::max(max_cols, ++cols);
+  }
+
+  int gw = atlas_.glyph_w_;
+  int gh = atlas_.glyph_h_;
+  int w = max_cols * gw;
+  V_Uchar cov (w * lines * gh, 0);
+
+  int line {0};
+  int col {0};
+  for (auto c : str)
+  {
+    if (c == '\n') {
+      ++line;
+      col = 0;
+      continue;
+    }
+    const uchar* glyph = atlas_.Glyph(c);
+    if (glyph)
+    {
+      for (int y = 0; y < gh; ++y)
+      {
+        uchar* dst = &cov[(line * gh + y) * w + col * gw];
+        std::memcpy(dst, glyph + y * gw, gw);
+      }
+    }
+    ++col;
+  }
+
+  auto& cached = cache_[str];
+  cached.frame_ = frame_;
+  cached.run_.w_ = w;
+  cached.run_.h_ = lines * gh;
+  text_helpers::Encode(cached.run_, cov);
+  return cached.run_;
+}
+
+// Encodes coverage image (rows from top) to spans of non-empty pixels
+
+void text_helpers::Encode(TextRun& run, const V_Uchar& cov)
+{
+  run.pixels_.clear();
+  run.spans_.clear();
+  run.rows_.clear();
+  run.rows_.reserve(run.h_ + 1);
+
+  for (int y = 0; y < run.h_; ++y)
+  {
+    run.rows_.push_back(run.spans_.size());
+    const uchar* row = &cov[y * run.w_];
+    int x = 0;
+    while (x < run.w_)
+    {
+      while (x < run.w_ && !row[x])
+        ++x;
+      if (x == run.w_)
+        break;
+      
+      Sprite::Span span {x, 0, static_cast<int>(run.pixels_.size())};
+      for (; x < run.w_ && row[x]; ++x, ++span.len_)
+        run.pixels_.push_back(row[x]);
+      run.spans_.push_back(span);
+    }
+  }
+  run.rows_.push_back(run.spans_.size());
+}
+
+// Blends color with pixels using coverage as alpha
+
+void text_helpers::BlendCoverage(
+  uint* dst, const uchar* cov, int cnt, uint color)
+{
+  __m128i zero = _mm_setzero_si128();
+  __m128i k256 = _mm_set1_epi16(256);
+  __m128i col = _mm_unpacklo_epi8(
+    _mm_set1_epi32(static_cast<int>(color)), zero);
+
+  int i = 0;
+  for (; i + 4 <= cnt; i += 4)
+  {
+    int cov4;
+    std::memcpy(&cov4, cov + i, sizeof(cov4));
+    __m128i a = _mm_unpacklo_epi8(_mm_cvtsi32_si128(cov4), zero);
+    a = _mm_add_epi16(a, _mm_srli_epi16(a, 7));       // 255 -> 256
+    a = _mm_unpacklo_epi16(a, a);
+    __m128i a_lo = _mm_unpacklo_epi32(a, a);          // 4 lanes per pixel
+    __m128i a_hi = _mm_unpackhi_epi32(a, a);
+
+    auto* d = reinterpret_cast<__m128i*>(dst + i);
+    __m128i b = _mm_loadu_si128(d);
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(col, a_lo),
+      _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), _mm_sub_epi16(k256, a_lo)));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(col, a_hi),
+      _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), _mm_sub_epi16(k256, a_hi)));
+    lo = _mm_srli_epi16(lo, 8);
+    hi = _mm_srli_epi16(hi, 8);
+    _mm_storeu_si128(d, _mm_packus_epi16(lo, hi));
+  }
+  for (; i < cnt; ++i)
+  {
+    uint a = cov[i] + (cov[i] >> 7);
+    uint res {0};
+    for (int sh = 0; sh < 32; sh += 8)
+    {
+      uint c = ((color >> sh) & 0xff) * a +
+               ((dst[i] >> sh) & 0xff) * (256 - a);
+      res |= (c >> 8) << sh;
+    }
+    dst[i] = res;
+  }
+}
+
+} // namespace anshub
+
+// Note #1 : runs are stored in unordered_map, which doesn`t invalidate
+//  references to elements on rehashing, thus queue may hold pointers
@@ -0,0 +1,121 @@
+// *************************************************************
+// File:    fx_text.h
+// Descr:   software text output to screen buffer using glyph atlas
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef FX_TEXT_H
+#define FX_TEXT_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <emmintrin.h>
+
+#include "lib/render/gl_scr_buffer.h"
+#include "lib/render/gl_aliases.h"
+#include "lib/render/fx_sprites.h"
+#include "lib/render/fx_colors.h"
+#include "lib/render/exceptions.h"
+
+#include "lib/data/bmp_loader.h"
+
+namespace anshub {
+
+//****************************************************************************
+// Font baked into the array of glyphs coverage (0 - empty, 255 - full).
+// Glyphs have the same size and are stored one after another
+//****************************************************************************
+
+struct GlyphAtlas
+{
+  explicit GlyphAtlas(int scale = 1);
+  GlyphAtlas(const Bitmap&, int cols, int first, int count);
+
+  const uchar* Glyph(char) const;
+
+  int     glyph_w_;
+  int     glyph_h_;
+  int     first_;       // code of the first glyph
+  int     count_;
+  V_Uchar cov_;
+
+}; // struct GlyphAtlas
+
+//****************************************************************************
+// Shaped string - coverage of glyphs run encoded as spans (the same layout
+// as in Sprite, thus may be drawn by sprite_helpers::WalkSpans)
+//****************************************************************************
+
+struct TextRun
+{
+  int     w_;
+  int     h_;
+  V_Uchar pixels_;                    // coverage of non-empty pixels
+  std::vector<Sprite::Span> spans_;
+  std::vector<int>  rows_;
+
+}; // struct TextRun
+
+//****************************************************************************
+// Represents text output to ScrBuffer. Strings are queued by PrintString()
+// and drawn by Flush() (render::Context calls it before sending buffer to
+// the frame buffer if RenderContext::text_ is set)
+//****************************************************************************
+
+class SoftText
+{
+public:
+  SoftText();
+  explicit SoftText(const GlyphAtlas&);
+
+  void PrintString(int, int, const char*);
+  void PrintString(int, int, const char*, uint color);
+  void Flush(ScrBuffer&);
+  void SetColor(uint color) { color_ = color; }
+
+  const TextRun& Shape(const std::string&);
+  int  CachedRuns() const { return cache_.size(); }
+  int  LineHeight() const { return atlas_.glyph_h_; }
+
+private:
+  struct Cached
+  {
+    TextRun run_;
+    int     frame_;     // last frame when run was used
+  };
+  struct Line
+  {
+    int     x_;
+    int     y_;
+    uint    color_;
+    const TextRun* run_;
+  };
+
+  GlyphAtlas  atlas_;
+  uint        color_;
+  int         frame_;
+  std::unordered_map<std::string, Cached> cache_;
+  std::vector<Line> queue_;
+
+}; // class SoftText
+
+namespace text_helpers {
+
+  constexpr int kFontSide   = 8;      // built-in font is 8x8 px
+  constexpr int kFontFirst  = 32;     // and has printable ascii glyphs
+  constexpr int kFontCount  = 95;
+
+  void  Encode(TextRun&, const V_Uchar& cov);
+  void  BlendCoverage(uint* dst, const uchar* cov, int cnt, uint color);
+
+} // namespace text_helpers
+
+}  // namespace anshub
+
+#endif  // FX_TEXT_H
+
+// Note #1 : unlike GlText, SoftText doesn`t need gl display lists and X
+//  fonts, and costs one blit per string. Strings which weren`t printed
+//  during the last frame are evicted from the cache by Flush(), thus
+//  static lines are shaped once, while changing lines don`t grow the cache
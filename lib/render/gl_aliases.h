@@ -25,15 +25,20 @@ namespace anshub {
   struct Vector;
   template<class T> struct Color;
   struct GlObject;
+  struct MeshInstance;
   struct Triangle;
   struct Vertex;
   struct Face;
+  struct MeshEdge;
+  struct MeshCluster;
+  struct MeshLod;
   struct TrigTable;
   
   // Simple aliases
 
   using uint  = unsigned int;
   using uchar = unsigned char;
+  using ushort = unsigned short;
   using byte  = unsigned char;
   using FColor = Color<float>;
   using cFColor = const Color<float>;
@@ -43,12 +48,14 @@ namespace anshub {
   // Pointer aliases
 
   using P_Bitmap = std::shared_ptr<Bitmap>;
+  using P_GlObject = std::shared_ptr<GlObject>;
 
   // Containers aliases
 
   using V_Uint = std::vector<uint>;
   using V_Float = std::vector<float>;
   using V_Uchar = std::vector<uchar>;
+  using V_Ushort = std::vector<ushort>;
   using V_Triangle = std::vector<Triangle>;
   using V_TrianglePtr = std::vector<Triangle*>;
   using A3_Int = std::array<int,3>;
@@ -58,10 +65,17 @@ namespace anshub {
   using A3_FColor = std::array<FColor,3>;
   using V_Face = std::vector<Face>;
   using VV_Face = std::vector<V_Face>;
+  using V_MeshEdge = std::vector<MeshEdge>;
+  using VV_MeshEdge = std::vector<V_MeshEdge>;
+  using V_MeshCluster = std::vector<MeshCluster>;
+  using VV_MeshCluster = std::vector<V_MeshCluster>;
+  using V_MeshLod = std::vector<MeshLod>;
   using V_Vertex = std::vector<Vertex>;
   using V_Vector = std::vector<Vector>;
+  using VV_Vector = std::vector<V_Vector>;
   using V_GlObject = std::vector<GlObject>;
   using V_GlObjectP = std::vector<GlObject*>;
+  using V_MeshInstance = std::vector<MeshInstance>;
   using V_FColor = std::vector<Color<float>>;
   using V_Color = std::vector<Color<uchar>>;
   using V_Bitmap = std::vector<P_Bitmap>;
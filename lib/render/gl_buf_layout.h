@@ -0,0 +1,64 @@
+// *************************************************************
+// File:    gl_buf_layout.h
+// Descr:   memory layout (linear or tiled) of screen and z buffers
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef GL_BUF_LAYOUT_H
+#define GL_BUF_LAYOUT_H
+
+namespace anshub {
+
+//****************************************************************************
+// Maps (x,y) screen coordinates to the index in the buffer storage. Both
+// layouts use the same formula, so indexing is branch-free (see note #1)
+//****************************************************************************
+
+struct BufLayout
+{
+  static constexpr int kTileShift = 3;
+  static constexpr int kTileSize  = 1 << kTileShift;    // 8x8 px tiles
+  static constexpr int kMaxRun    = 1 << 30;            // run in linear layout
+
+  BufLayout(int w, int h, bool tiled);
+
+  int   Row(int y) const { return (y >> shift_) * row_pitch_ + ((y & mask_) << shift_); }
+  int   Col(int x) const { return ((x >> shift_) << tile_shift_) + (x & mask_); }
+  int   Index(int x, int y) const { return Row(y) + Col(x); }
+  int   Contiguous(int x) const { return IsTiled() ? kTileSize - (x & mask_) : kMaxRun; }
+  int   Size() const { return row_pitch_ * rows_; }
+  int   PaddedWidth() const { return padded_w_; }
+  bool  IsTiled() const { return shift_ != 0; }
+
+private:
+  int shift_;       // log2 of tile side (0 for linear)
+  int mask_;        // tile side - 1
+  int tile_shift_;  // log2 of tile area
+  int padded_w_;    // width rounded up to the tile side
+  int row_pitch_;   // elements between two rows of tiles
+  int rows_;        // count of rows of tiles
+
+}; // struct BufLayout
+
+//****************************************************************************
+// Inline implementation
+//****************************************************************************
+
+inline BufLayout::BufLayout(int w, int h, bool tiled)
+  : shift_{tiled ? kTileShift : 0}
+  , mask_{(1 << shift_) - 1}
+  , tile_shift_{shift_ * 2}
+  , padded_w_{(w + mask_) & ~mask_}
+  , row_pitch_{padded_w_ << shift_}
+  , rows_{(h + mask_) >> shift_}
+{ }
+
+}  // namespace anshub
+
+#endif  // GL_BUF_LAYOUT_H
+
+// Note #1 : in linear layout shift_ == mask_ == 0, thus Row(y) is y * w and
+//  Col(x) is x. In tiled layout the buffer is the sequence of 8x8 tiles
+//  stored row by row, and pixels inside the tile are stored row by row too.
+//  Width and height are padded to the multiple of 8, thus kernels may walk
+//  through the tile without bounds checks
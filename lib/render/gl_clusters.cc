@@ -0,0 +1,183 @@
+// *************************************************************
+// File:    gl_clusters.cc
+// Descr:   clusters of faces culled by frustum and normals cones
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#include "gl_clusters.h"
+
+namespace anshub {
+
+// Reorders faces by z-order curve of their centers, thus each run of faces
+// in the list is spatially compact. Should be called before any data which
+// refers to faces numbers (edges, clusters) is computed
+
+void clusters::SortFaces(cV_Vertex& vxs, V_Face& faces)
+{
+  if (faces.size() <= static_cast<std::size_t>(kSize) || vxs.empty())
+    return;
+
+  Vector min {vxs.front().pos_};
+  Vector max {vxs.front().pos_};
+  for (const auto& vx : vxs)
+  {
+    min.x = std::min(min.x, vx.pos_.x);
+    min.y = std::min(min.y, vx.pos_.y);
+    min.z = std::min(min.z, vx.pos_.z);
+    max.x = std::max(max.x, vx.pos_.x);
+    max.y = std::max(max.y, vx.pos_.y);
+    max.z = std::max(max.z, vx.pos_.z);
+  }
+
+  // Quantize centers to 10 bits per axis and interleave bits
+
+  constexpr float kSteps {1023.0f};
+  float size = std::max({max.x - min.x, max.y - min.y, max.z - min.z});
+  float k = size > 0.0f ? kSteps / size : 0.0f;
+
+  std::vector<std::pair<uint, int>> codes (faces.size());
+  for (std::size_t i = 0; i < faces.size(); ++i)
+  {
+    Vector c = (vxs[faces[i][0]].pos_ + vxs[faces[i][1]].pos_ +
+                vxs[faces[i][2]].pos_) / 3.0f;
+    uint x = static_cast<uint>((c.x - min.x) * k);
+    uint y = static_cast<uint>((c.y - min.y) * k);
+    uint z = static_cast<uint>((c.z - min.z) * k);
+    codes[i].first = clusters_helpers::SpreadBits(x) |
+                     clusters_helpers::SpreadBits(y) << 1 |
+                     clusters_helpers::SpreadBits(z) << 2;
+    codes[i].second = i;
+  }
+  std::stable_sort(codes.begin(), codes.end(),
+    [](const std::pair<uint, int>& l, const std::pair<uint, int>& r) {
+      return l.first < r.first;
+  });
+
+  V_Face res {};
+  res.reserve(faces.size());
+  for (const auto& code : codes)
+    res.push_back(faces[code.second]);
+  faces = std::move(res);
+}
+
+// Makes cluster of faces in range [first; first + count). Normals are
+// computed by vertices since face normals may be out of date
+
+MeshCluster clusters::Make(cV_Vertex& vxs, cV_Face& faces, int first, int count)
+{
+  MeshCluster cl {first, count, Vector{}, 0.0f, Vector{}, 0.0f, 1.0f};
+
+  // Bounding sphere with center in the middle of bounding box
+
+  Vector min {vxs[faces[first][0]].pos_};
+  Vector max {min};
+  for (int i = first; i < first + count; ++i)
+  {
+    for (auto v : faces[i].vxs_)
+    {
+      const auto& p = vxs[v].pos_;
+      min.x = std::min(min.x, p.x);
+      min.y = std::min(min.y, p.y);
+      min.z = std::min(min.z, p.z);
+      max.x = std::max(max.x, p.x);
+      max.y = std::max(max.y, p.y);
+      max.z = std::max(max.z, p.z);
+    }
+  }
+  cl.center_ = (min + max) / 2.0f;
+  for (int i = first; i < first + count; ++i)
+  {
+    for (auto v : faces[i].vxs_)
+      cl.rad_ = std::max(cl.rad_, Vector{cl.center_, vxs[v].pos_}.Length());
+  }
+
+  // Cone axis is the average of faces normals, cone angle is the greatest
+  // angle between the axis and normals
+
+  V_Vector normals {};
+  for (int i = first; i < first + count; ++i)
+  {
+    const auto& face = faces[i];
+    Vector u {vxs[face[0]].pos_, vxs[face[1]].pos_};
+    Vector v {vxs[face[0]].pos_, vxs[face[2]].pos_};
+    Vector n = vector::CrossProduct(u, v);
+    if (n.IsZero())
+      continue;
+    n.Normalize();
+    normals.push_back(n);
+    cl.axis_ += n;
+  }
+  if (normals.empty() || cl.axis_.IsZero())
+    return cl;
+
+  cl.axis_.Normalize();
+  float min_cos {1.0f};
+  for (const auto& n : normals)
+    min_cos = std::min(min_cos, vector::DotProduct(cl.axis_, n));
+  cl.cos_ = min_cos;
+  cl.sin_ = std::sqrt(std::max(0.0f, 1.0f - min_cos * min_cos));
+  return cl;
+}
+
+// Splits faces into clusters by runs of kSize faces
+
+V_MeshCluster clusters::Make(cV_Vertex& vxs, cV_Face& faces)
+{
+  V_MeshCluster res {};
+  int size = faces.size();
+  for (int first = 0; first < size; first += kSize)
+    res.push_back(Make(vxs, faces, first, std::min(kSize, size - first)));
+  return res;
+}
+
+// Marks faces of clusters, which are out of frustum or turned back to camera,
+// as inactive. Offset is the position of coordinates of clusters in world
+// coordinates. Returns count of culled faces
+
+int clusters::Cull(
+  const V_MeshCluster& arr, V_Face& faces, const GlCamera& cam, cVector& offset)
+{
+  std::array<Plane3d, 6> planes {cam.frustum_};
+  for (auto& p : planes)
+    p.d_ += p.a_ * offset.x + p.b_ * offset.y + p.c_ * offset.z;
+  return Cull(arr, faces, planes, cam.vrp_ - offset);
+}
+
+// The same as above, but frustum planes and camera position are given in
+// coordinates of clusters
+
+int clusters::Cull(const V_MeshCluster& arr, V_Face& faces,
+  const std::array<Plane3d, 6>& planes, cVector& cam_pos)
+{
+  int cnt {0};
+  for (const auto& cl : arr)
+  {
+    if (!clusters_helpers::IsOutside(cl, planes) &&
+        !clusters_helpers::IsBackFacing(cl, cam_pos))
+      continue;
+
+    for (int i = cl.first_; i < cl.first_ + cl.count_; ++i)
+    {
+      if (faces[i].active_)
+      {
+        faces[i].active_ = false;
+        ++cnt;
+      }
+    }
+  }
+  return cnt;
+}
+
+// Inserts two zero bits between each of 10 low bits of number
+
+uint clusters_helpers::SpreadBits(uint x)
+{
+  x &= 0x3ff;
+  x = (x | (x << 16)) & 0x030000ff;
+  x = (x | (x << 8))  & 0x0300f00f;
+  x = (x | (x << 4))  & 0x030c30c3;
+  x = (x | (x << 2))  & 0x09249249;
+  return x;
+}
+
+} // namespace anshub
@@ -0,0 +1,99 @@
+// *************************************************************
+// File:    gl_clusters.h
+// Descr:   clusters of faces culled by frustum and normals cones
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef GC_GL_CLUSTERS_H
+#define GC_GL_CLUSTERS_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <array>
+
+#include "lib/render/gl_aliases.h"
+#include "lib/render/gl_vertex.h"
+#include "lib/render/gl_face.h"
+#include "lib/render/cameras/gl_camera.h"
+
+#include "lib/math/vector.h"
+#include "lib/math/plane3d.h"
+
+namespace anshub {
+
+//****************************************************************************
+// Helper functions to split faces of mesh into clusters and to cull faces
+// by whole clusters before per face work (see note #1)
+//****************************************************************************
+
+namespace clusters {
+
+  constexpr int kSize {64};     // faces in one cluster
+
+  void  SortFaces(cV_Vertex&, V_Face&);
+  MeshCluster Make(cV_Vertex&, cV_Face&, int first, int count);
+  V_MeshCluster Make(cV_Vertex&, cV_Face&);
+  int   Cull(const V_MeshCluster&, V_Face&, const GlCamera&, cVector& offset);
+  int   Cull(const V_MeshCluster&, V_Face&,
+             const std::array<Plane3d, 6>& planes, cVector& cam_pos);
+
+} // namespace clusters
+
+namespace clusters_helpers {
+
+  uint  SpreadBits(uint);
+  bool  IsOutside(const MeshCluster&, const std::array<Plane3d, 6>&);
+  bool  IsBackFacing(const MeshCluster&, cVector& cam_pos);
+
+} // namespace clusters_helpers
+
+//****************************************************************************
+// Inline implementation
+//****************************************************************************
+
+// Returns true if bounding sphere of cluster is entirely behind one of the
+// planes (normals of planes are directed inside)
+
+inline bool clusters_helpers::IsOutside(
+  const MeshCluster& cl, const std::array<Plane3d, 6>& planes)
+{
+  cVector& c = cl.center_;
+  for (const auto& p : planes)
+  {
+    if (p.a_ * c.x + p.b_ * c.y + p.c_ * c.z + p.d_ < -cl.rad_)
+      return true;
+  }
+  return false;
+}
+
+// Returns true if all faces of cluster are turned back to camera position
+// (given in coordinates of cluster). Let d is vector from camera to center
+// and t is angle between d and cone axis, then the least product of d and
+// faces normals is |d| * cos(t + cone angle), which should be greater than
+// bounding radius
+
+inline bool clusters_helpers::IsBackFacing(
+  const MeshCluster& cl, cVector& cam_pos)
+{
+  if (cl.cos_ <= 0.0f)
+    return false;
+
+  Vector d {cl.center_ - cam_pos};
+  float d_cos = vector::DotProduct(d, cl.axis_);      // |d| * cos(t)
+  float d_sin = std::sqrt(
+    std::max(0.0f, vector::DotProduct(d, d) - d_cos * d_cos));
+  return d_cos * cl.cos_ - d_sin * cl.sin_ > cl.rad_;
+}
+
+}  // namespace anshub
+
+#endif  // GC_GL_CLUSTERS_H
+
+// Note #1 : faces are culled by frustum planes and removed as back faces
+//  one by one in CullAndClip() and RemoveHiddenSurfaces(). If cluster of
+//  neighboring faces is out of frustum, or all its faces are turned back
+//  (see IsBackFacing()), then all faces are marked as inactive at once and
+//  per face functions skip them. Clusters are made in coordinates of
+//  vertices, and are moved to the world by offset (i.e. world position of
+//  object)
@@ -74,6 +74,50 @@ void coords::World2Camera(
   coords::RotateRoll(vec, -cam_dir.z, trig);
 }
 
+// Makes 3x3 matrix (by rows) of camera rotation, using the same sequence of
+// rotations as World2Camera() above. Translation isn`t included
+
+void coords::World2CameraMatrix(
+  cVector& cam_dir, const TrigTable& trig, float* m)
+{
+  Vector axes[3] {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}};
+  for (auto& axis : axes)
+  {
+    coords::RotateYaw(axis, -cam_dir.y, trig);
+    coords::RotatePitch(axis, -cam_dir.x, trig);
+    coords::RotateRoll(axis, -cam_dir.z, trig);
+  }
+  for (int i = 0; i < 3; ++i)
+  {
+    m[i] = axes[i].x;
+    m[i + 3] = axes[i].y;
+    m[i + 6] = axes[i].z;
+  }
+}
+
+// Makes row-based camera matrix (translation and then rotation), which
+// transforms vectors the same way as World2Camera() above
+
+MatrixCamera coords::World2CameraMatrix(
+  cVector& cam_pos, cVector& cam_dir, const TrigTable& trig)
+{
+  float m[9];
+  coords::World2CameraMatrix(cam_dir, trig, m);
+
+  MatrixCamera mx {};
+  for (int i = 0; i < 3; ++i)
+  {
+    for (int k = 0; k < 3; ++k)
+      mx(i,k) = m[k * 3 + i];
+  }
+  for (int k = 0; k < 3; ++k)
+  {
+    mx(3,k) = -(cam_pos.x * mx(0,k) + cam_pos.y * mx(1,k) +
+                cam_pos.z * mx(2,k));
+  }
+  return mx;
+}
+
 // Translates all vertexes from camera (world) to perspective
 
 void coords::Camera2Persp(V_Vertex& vxs, float dov, float ar)
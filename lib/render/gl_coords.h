@@ -13,6 +13,7 @@
 #include "lib/math/trig.h"
 #include "lib/math/vector.h"
 #include "lib/math/matrices/mx_rotate_uvn.h"
+#include "lib/math/matrices/mx_camera.h"
 
 namespace anshub {
 
@@ -25,6 +26,8 @@ namespace coords {
   void  Camera2Persp(Vector&, float dov, float ar);
   void  World2Camera(V_Vertex&, cVector& pos, cVector& dir, const TrigTable&);
   void  World2Camera(Vector&, cVector& pos, cVector& dir, const TrigTable&);
+  void  World2CameraMatrix(cVector& dir, const TrigTable&, float* m);
+  MatrixCamera World2CameraMatrix(cVector& pos, cVector& dir, const TrigTable&);
   void  Persp2Screen(V_Vertex&, float wov, int scr_w, int scr_h);
   void  Persp2Screen(Vector&, float wov, int scr_w, int scr_h);
   void  ClipNearZ(Vector&, float near_z);
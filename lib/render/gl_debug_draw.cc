@@ -4,6 +4,8 @@
 // Author:  Novoselov Anton @ 2017
 // *************************************************************
 
+#include <xmmintrin.h>
+
 #include "gl_debug_draw.h"
 
 namespace anshub {
@@ -12,13 +14,67 @@ DebugContext::DebugContext()
   : lines_{}
   , text_{}
   , render_first_{false}
-{ }
+  , depth_test_{true}
+  , lines_drawn_{0}
+  , xs_{}
+  , ys_{}
+  , zs_{}
+  , circle_{}
+{
+  for (int i = 0; i < debug_render::kSphereSegments; ++i)
+  {
+    float angle = math::kPI_mul2 * i / debug_render::kSphereSegments;
+    circle_.push_back(std::cos(angle));
+    circle_.push_back(std::sin(angle));
+  }
+}
 
 void DebugContext::AddLine(const Vector& p0, const Vector& p1, const FColor& color)
 {
   lines_.push_back({p0, p1, color});
 }
 
+// Adds 12 edges of axis aligned bounding box
+
+void DebugContext::AddAabb(
+  const Vector& min, const Vector& max, const FColor& color)
+{
+  Vector v[8] {
+    {min.x, min.y, min.z}, {max.x, min.y, min.z},
+    {max.x, max.y, min.z}, {min.x, max.y, min.z},
+    {min.x, min.y, max.z}, {max.x, min.y, max.z},
+    {max.x, max.y, max.z}, {min.x, max.y, max.z}
+  };
+  for (int i = 0; i < 4; ++i)
+  {
+    lines_.push_back({v[i], v[(i + 1) % 4], color});          // near face
+    lines_.push_back({v[i + 4], v[(i + 1) % 4 + 4], color});  // far face
+    lines_.push_back({v[i], v[i + 4], color});                // sides
+  }
+}
+
+// Adds sphere as 3 circles in the axis planes
+
+void DebugContext::AddSphere(
+  const Vector& center, float radius, const FColor& color)
+{
+  const int segs = debug_render::kSphereSegments;
+  for (int i = 0; i < segs; ++i)
+  {
+    int k = (i + 1) % segs;
+    float c0 = circle_[i * 2] * radius;
+    float s0 = circle_[i * 2 + 1] * radius;
+    float c1 = circle_[k * 2] * radius;
+    float s1 = circle_[k * 2 + 1] * radius;
+    lines_.push_back(
+      {center + Vector{c0, s0, 0.0f}, center + Vector{c1, s1, 0.0f}, color});
+    lines_.push_back(
+      {center + Vector{c0, 0.0f, s0}, center + Vector{c1, 0.0f, s1}, color});
+    lines_.push_back(
+      {center + Vector{0.0f, c0, s0}, center + Vector{0.0f, c1, s1}, color});
+  }
+}
+
 // Draws line by given 2 vectors. Vector are in world coordinates 
 
 void debug_render::DrawVector(Vector begin, Vector end, const FColor& color, RenderContext& ctx)
@@ -43,4 +99,124 @@ void debug_render::DrawVector(Vector begin, Vector end, const FColor& color, Ren
     raster::Line(begin.x, begin.y, end.x, end.y, color.GetARGB(), ctx.sbuf_);
 }
 
+// Draws all lines of debug context by batches (see note #1 in header). If
+// behind is true, lines are drawn only to pixels not covered by the scene
+// (see note #2 in header). Returns count of visible lines
+
+int debug_render::DrawLines(DebugContext& dbg, RenderContext& ctx, bool behind)
+{
+  const auto& cam = *ctx.cam_;
+  int ends = dbg.lines_.size() * 2;
+  int padded = (ends + 3) & ~3;
+  dbg.xs_.resize(padded);
+  dbg.ys_.resize(padded);
+  dbg.zs_.resize(padded);
+
+  for (std::size_t i = 0; i < dbg.lines_.size(); ++i)
+  {
+    const auto& line = dbg.lines_[i];
+    dbg.xs_[i * 2] = line.begin_.x;
+    dbg.ys_[i * 2] = line.begin_.y;
+    dbg.zs_[i * 2] = line.begin_.z;
+    dbg.xs_[i * 2 + 1] = line.end_.x;
+    dbg.ys_[i * 2 + 1] = line.end_.y;
+    dbg.zs_[i * 2 + 1] = line.end_.z;
+  }
+
+  float m[9];
+  coords::World2CameraMatrix(cam.dir_, cam.trig_, m);
+  debug_helpers::Transform(m, cam.vrp_, dbg.xs_, dbg.ys_, dbg.zs_);
+
+  // Clip, project and rasterize each line
+
+  float kx = cam.scr_w_ / cam.wov_;
+  float ky = cam.scr_h_ / cam.wov_;
+  float half_wov = cam.wov_ / 2.0f;
+  bool depth = dbg.depth_test_ && ctx.is_zbuf_;
+  int drawn {0};
+
+  for (std::size_t i = 0; i < dbg.lines_.size(); ++i)
+  {
+    Vector p0 {dbg.xs_[i * 2], dbg.ys_[i * 2], dbg.zs_[i * 2]};
+    Vector p1 {dbg.xs_[i * 2 + 1], dbg.ys_[i * 2 + 1], dbg.zs_[i * 2 + 1]};
+    if (!debug_helpers::ClipZ(p0, p1, cam.z_near_, cam.z_far_))
+      continue;
+
+    float x0 = (p0.x * cam.dov_ / p0.z + half_wov) * kx;
+    float y0 = (p0.y * cam.dov_ * cam.ar_ / p0.z + half_wov) * ky;
+    float x1 = (p1.x * cam.dov_ / p1.z + half_wov) * kx;
+    float y1 = (p1.y * cam.dov_ * cam.ar_ / p1.z + half_wov) * ky;
+    int color = dbg.lines_[i].color_.GetARGB();
+
+    if (behind && ctx.is_zbuf_)
+      raster::LineZ(x0, y0, 0.0f, x1, y1, 0.0f, color, ctx.zbuf_, ctx.sbuf_);
+    else if (depth)
+      raster::LineZ(
+        x0, y0, kDepthBias / p0.z, x1, y1, kDepthBias / p1.z,
+        color, ctx.zbuf_, ctx.sbuf_);
+    else if (segment2d::Clip(
+      0, 0, cam.scr_w_ - 1, cam.scr_h_ - 1, x0, y0, x1, y1))
+      raster::Line(x0, y0, x1, y1, color, ctx.sbuf_);
+    ++drawn;
+  }
+  dbg.lines_drawn_ = drawn;
+  return drawn;
+}
+
+// Transforms points from world to camera space, 4 points at once. Sizes
+// of arrays should be multiple of 4
+
+void debug_helpers::Transform(
+  const float* m, cVector& cam_pos, V_Float& xs, V_Float& ys, V_Float& zs)
+{
+  __m128 m0 = _mm_set1_ps(m[0]);
+  __m128 m1 = _mm_set1_ps(m[1]);
+  __m128 m2 = _mm_set1_ps(m[2]);
+  __m128 m3 = _mm_set1_ps(m[3]);
+  __m128 m4 = _mm_set1_ps(m[4]);
+  __m128 m5 = _mm_set1_ps(m[5]);
+  __m128 m6 = _mm_set1_ps(m[6]);
+  __m128 m7 = _mm_set1_ps(m[7]);
+  __m128 m8 = _mm_set1_ps(m[8]);
+  __m128 cx = _mm_set1_ps(cam_pos.x);
+  __m128 cy = _mm_set1_ps(cam_pos.y);
+  __m128 cz = _mm_set1_ps(cam_pos.z);
+
+  for (std::size_t i = 0; i < xs.size(); i += 4)
+  {
+    __m128 x = _mm_sub_ps(_mm_loadu_ps(&xs[i]), cx);
+    __m128 y = _mm_sub_ps(_mm_loadu_ps(&ys[i]), cy);
+    __m128 z = _mm_sub_ps(_mm_loadu_ps(&zs[i]), cz);
+    __m128 rx = _mm_add_ps(_mm_add_ps(
+      _mm_mul_ps(m0, x), _mm_mul_ps(m1, y)), _mm_mul_ps(m2, z));
+    __m128 ry = _mm_add_ps(_mm_add_ps(
+      _mm_mul_ps(m3, x), _mm_mul_ps(m4, y)), _mm_mul_ps(m5, z));
+    __m128 rz = _mm_add_ps(_mm_add_ps(
+      _mm_mul_ps(m6, x), _mm_mul_ps(m7, y)), _mm_mul_ps(m8, z));
+    _mm_storeu_ps(&xs[i], rx);
+    _mm_storeu_ps(&ys[i], ry);
+    _mm_storeu_ps(&zs[i], rz);
+  }
+}
+
+// Clips segment in camera space by near and far z planes. Returns false
+// if segment is fully outside
+
+bool debug_helpers::ClipZ(Vector& p0, Vector& p1, float z_near, float z_far)
+{
+  if ((p0.z < z_near && p1.z < z_near) || (p0.z > z_far && p1.z > z_far))
+    return false;
+
+  if (p0.z < z_near)
+    p0 += (p1 - p0) * ((z_near - p0.z) / (p1.z - p0.z));
+  else if (p1.z < z_near)
+    p1 += (p0 - p1) * ((z_near - p1.z) / (p0.z - p1.z));
+
+  if (p0.z > z_far)
+    p0 += (p1 - p0) * ((z_far - p0.z) / (p1.z - p0.z));
+  else if (p1.z > z_far)
+    p1 += (p0 - p1) * ((z_far - p1.z) / (p0.z - p1.z));
+  return true;
+}
+
 } // namespace anshub
\ No newline at end of file
@@ -37,10 +37,21 @@ struct DebugContext
 
   DebugContext();
   void AddLine(const Vector& p0, const Vector& p1, const FColor& color);
+  void AddAabb(const Vector& min, const Vector& max, const FColor& color);
+  void AddSphere(const Vector& center, float radius, const FColor& color);
 
   std::vector<Line> lines_;
   std::vector<std::string> text_;
   bool render_first_;
+  bool depth_test_;       // test lines against zbuffer (if ctx.is_zbuf_)
+  int  lines_drawn_;      // debug info: lines visible during last frame
+
+  // Work buffers of batched drawing (see note #1)
+
+  V_Float xs_;            // ends of lines (2 per line) in camera space
+  V_Float ys_;
+  V_Float zs_;
+  V_Float circle_;        // cos and sin of the sphere circle segments
 
 }; // struct DebugContext
 
@@ -50,10 +61,32 @@ struct DebugContext
 
 namespace debug_render {
 
+  constexpr int   kSphereSegments = 16;
+  constexpr float kDepthBias      = 1.001f;   // lines on surfaces are seen
+
   void DrawVector(Vector begin, Vector end, const FColor&, RenderContext&);
+  int  DrawLines(DebugContext&, RenderContext&, bool behind = false);
+
+} // namespace debug_render
 
-} // namespace debug_draw
+namespace debug_helpers {
+
+  void Transform(const float* m, cVector& cam_pos, V_Float&, V_Float&, V_Float&);
+  bool ClipZ(Vector& p0, Vector& p1, float z_near, float z_far);
+
+} // namespace debug_helpers
 
 } // namespace anshub
 
-#endif  // GL_DEBUG_DRAW_H
\ No newline at end of file
+#endif  // GL_DEBUG_DRAW_H
+
+// Note #1 : lines are processed in batches - all ends are copied to the
+//  arrays of x, y and z and transformed to camera space by sse (4 ends at
+//  once), then each line is clipped by near and far planes in camera space,
+//  projected and rasterized by raster::LineZ. Buffers are kept between
+//  frames, thus drawing doesn`t allocate memory after first frames
+
+// Note #2 : lines drawn before the scene don`t write zbuffer, thus the sky
+//  pass would paint over them. When the sky is on, such lines are drawn
+//  after the scene with 1/z equal to 0, which passes the test only where
+//  the scene hasn`t covered zbuffer (pixels of the sky)
@@ -0,0 +1,118 @@
+// *************************************************************
+// File:    gl_depth_sort.cc
+// Descr:   radix sort of triangles by depth
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#include "gl_depth_sort.h"
+
+namespace anshub {
+
+DepthSorter::DepthSorter(int threads)
+  : threads_{threads}
+  , keys_{}
+  , keys_tmp_{}
+  , tris_tmp_{}
+  , counts_{}
+{
+  if (threads_ <= 0)
+    threads_ = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+// Sorts triangles by average z coordinate (first - nearest). Triangles
+// farther than far_z get the same key, thus are placed in the end in their
+// original order (sort is stable)
+
+void depth_sort::SortZAvg(V_TrianglePtr& arr, DepthSorter& ds, float far_z)
+{
+  depth_sort_helpers::Sort(arr, ds, far_z, false);
+}
+
+// The same as above but first - farthest
+
+void depth_sort::SortZAvgInv(V_TrianglePtr& arr, DepthSorter& ds, float far_z)
+{
+  depth_sort_helpers::Sort(arr, ds, far_z, true);
+}
+
+// Computes keys and sorts triangles with keys by passes of radix sort (see
+// note #1 in header)
+
+void depth_sort_helpers::Sort(
+  V_TrianglePtr& arr, DepthSorter& ds, float far_z, bool inverse)
+{
+  int size = arr.size();
+  if (size < 2)
+    return;
+
+  int threads = std::min(ds.threads_, size / DepthSorter::kMinPerThread);
+  threads = std::max(1, threads);
+
+  ds.keys_.resize(size);
+  ds.keys_tmp_.resize(size);
+  ds.tris_tmp_.resize(size);
+  ds.counts_.resize(threads);
+
+  float k = far_z > 0.0f ? 65535.0f / far_z : 0.0f;
+
+  auto* keys_src = &ds.keys_;
+  auto* keys_dst = &ds.keys_tmp_;
+  auto* tris_src = &arr;
+  auto* tris_dst = &ds.tris_tmp_;
+
+  for (int pass = 0; pass < DepthSorter::kPasses; ++pass)
+  {
+    int shift = pass * DepthSorter::kBits;
+
+    // Count digits in range of each worker (keys are computed in first pass)
+
+    Workers::Shared().ForRanges(threads, size, [&](int t, int begin, int end)
+    {
+      auto& counts = ds.counts_[t];
+      counts.fill(0);
+      for (int i = begin; i < end; ++i)
+      {
+        if (pass == 0)
+          (*keys_src)[i] = ComputeKey((*tris_src)[i], k, inverse);
+        ++counts[((*keys_src)[i] >> shift) & (DepthSorter::kBuckets - 1)];
+      }
+    });
+
+    // Turn counts into first places of each worker in each bucket
+
+    int place {0};
+    for (int b = 0; b < DepthSorter::kBuckets; ++b)
+    {
+      for (int t = 0; t < threads; ++t)
+      {
+        int count = ds.counts_[t][b];
+        ds.counts_[t][b] = place;
+        place += count;
+      }
+    }
+
+    // Place keys and triangles
+
+    Workers::Shared().ForRanges(threads, size, [&](int t, int begin, int end)
+    {
+      auto& places = ds.counts_[t];
+      for (int i = begin; i < end; ++i)
+      {
+        uint key = (*keys_src)[i];
+        int dst = places[(key >> shift) & (DepthSorter::kBuckets - 1)]++;
+        (*keys_dst)[dst] = key;
+        (*tris_dst)[dst] = (*tris_src)[i];
+      }
+    });
+
+    std::swap(keys_src, keys_dst);
+    std::swap(tris_src, tris_dst);
+  }
+
+  // After even count of passes result is in the source array
+
+  if (tris_src != &arr)
+    std::copy(tris_src->begin(), tris_src->end(), arr.begin());
+}
+
+} // namespace anshub
@@ -0,0 +1,87 @@
+// *************************************************************
+// File:    gl_depth_sort.h
+// Descr:   radix sort of triangles by depth
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef GC_GL_DEPTH_SORT_H
+#define GC_GL_DEPTH_SORT_H
+
+#include <vector>
+#include <array>
+#include <thread>
+#include <algorithm>
+
+#include "lib/render/gl_aliases.h"
+#include "lib/render/gl_triangle.h"
+#include "lib/render/gl_workers.h"
+
+namespace anshub {
+
+//****************************************************************************
+// Work buffers of radix sort of triangles by quantized depth. Buffers are
+// kept between frames, thus sorting doesn`t allocate memory when count of
+// triangles is stable (see note #1)
+//****************************************************************************
+
+struct DepthSorter
+{
+  static constexpr int kBits {8};               // bits of key per pass
+  static constexpr int kBuckets {1 << kBits};
+  static constexpr int kPasses {2};             // 16 bit keys
+  static constexpr int kMinPerThread {16384};   // less is sorted in one
+
+  explicit DepthSorter(int threads = 1);
+
+  using Counts = std::array<int, kBuckets>;
+
+  int       threads_;         // workers count (0 - hardware concurrency)
+  V_Uint    keys_;            // quantized depths of triangles
+  V_Uint    keys_tmp_;
+  V_TrianglePtr tris_tmp_;
+  std::vector<Counts> counts_;  // histograms of each worker
+
+}; // struct DepthSorter
+
+namespace depth_sort {
+
+  void  SortZAvg(V_TrianglePtr&, DepthSorter&, float far_z);
+  void  SortZAvgInv(V_TrianglePtr&, DepthSorter&, float far_z);
+
+} // namespace depth_sort
+
+namespace depth_sort_helpers {
+
+  void  Sort(V_TrianglePtr&, DepthSorter&, float far_z, bool inverse);
+  uint  ComputeKey(const Triangle*, float k, bool inverse);
+
+} // namespace depth_sort_helpers
+
+//****************************************************************************
+// Inline implementation
+//****************************************************************************
+
+// Returns average z of triangle quantized to 16 bits, where k is count of
+// steps per unit of z
+
+inline uint depth_sort_helpers::ComputeKey(
+  const Triangle* t, float k, bool inverse)
+{
+  float avg_z = 0.3333333f * (t->vxs_[0].pos_.z + t->vxs_[1].pos_.z + t->vxs_[2].pos_.z);
+  float key = std::min(std::max(avg_z * k, 0.0f), 65535.0f);
+  uint res = static_cast<uint>(key);
+  return inverse ? 65535u - res : res;
+}
+
+}  // namespace anshub
+
+#endif  // GC_GL_DEPTH_SORT_H
+
+// Note #1 : triangles::SortZAvgCounting() allocates arrays every frame and
+//  computes depth of each triangle twice, and SortZAvg() computes it in each
+//  comparison. Here depth is computed once per triangle, and keys with
+//  pointers are sorted by least significant digit first (two stable passes
+//  by 8 bits). In each pass every worker counts digits of its range, then
+//  ranges are placed one after another in each bucket, thus parallel sort
+//  is stable too. Ranges are processed by the shared workers pool (see
+//  gl_workers.h)
@@ -306,7 +306,9 @@ int draw_triangles::Solid(
 
 int render::Context(const V_TrianglePtr& triangles, RenderContext& ctx) noexcept
 {
-  ctx.sbuf_.Clear();
+  render_helpers::SyncBuffersLayout(ctx);
+  if (!render_helpers::IsSkyOn(ctx))    // else sky fills the rest of screen
+    ctx.sbuf_.Clear();
   if (ctx.is_zbuf_)
     ctx.zbuf_.Clear();
 
@@ -320,6 +322,10 @@ int render::Context(const V_TrianglePtr& triangles, RenderContext& ctx) noexcept
   else if (ctx.is_zbuf_ && ctx.is_alpha_)
     drawn += render::SolidWithAlpha(triangles, ctx);
   
+  if (ctx.post_)
+    postproc::Apply(*ctx.post_, ctx.sbuf_);
+  if (ctx.text_)
+    ctx.text_->Flush(ctx.sbuf_);
   ctx.sbuf_.SendDataToFB();
   ctx.pixels_drawn_ = drawn;
   
@@ -331,13 +337,18 @@ int render::Context(const V_TrianglePtr& triangles, RenderContext& ctx) noexcept
 int render::Context(const V_TrianglePtr& triangles, RenderContext& ctx,
                     DebugContext& dbg) noexcept
 {
-  ctx.sbuf_.Clear();
+  render_helpers::SyncBuffersLayout(ctx);
+  if (!render_helpers::IsSkyOn(ctx))    // else sky fills the rest of screen
+    ctx.sbuf_.Clear();
   if (ctx.is_zbuf_)
     ctx.zbuf_.Clear();
 
-  if (dbg.render_first_)
-    for (const auto& line : dbg.lines_)
-      debug_render::DrawVector(line.begin_, line.end_, line.color_, ctx);
+  // Lines drawn first would be painted over by the sky pass, thus they are
+  // drawn behind the scene after it (see note #2 in gl_debug_draw.h)
+
+  bool behind = dbg.render_first_ && render_helpers::IsSkyOn(ctx);
+  if (dbg.render_first_ && !behind)
+    debug_render::DrawLines(dbg, ctx);
 
   int drawn {0};
   if (ctx.is_wired_)
@@ -349,19 +360,58 @@ int render::Context(const V_TrianglePtr& triangles, RenderContext& ctx,
   else if (ctx.is_zbuf_ && ctx.is_alpha_)
     drawn += render::SolidWithAlpha(triangles, ctx);
 
-  if (!dbg.render_first_)
-    for (const auto& line : dbg.lines_)
-      debug_render::DrawVector(line.begin_, line.end_, line.color_, ctx);
+  if (!dbg.render_first_ || behind)
+    debug_render::DrawLines(dbg, ctx, behind);
 
   dbg.lines_.clear();
+  if (ctx.post_)
+    postproc::Apply(*ctx.post_, ctx.sbuf_);
+  if (ctx.text_)
+    ctx.text_->Flush(ctx.sbuf_);
   ctx.sbuf_.SendDataToFB();
   ctx.pixels_drawn_ = drawn;
 
   return drawn;
 }
 
+// Draws objects (in world coordinates) in wired mode by unique edges with
+// optional depth pre-pass (see note #1 in header)
+
+int render::Wired(const V_GlObjectP& objs, RenderContext& ctx) noexcept
+{
+  render_helpers::SyncBuffersLayout(ctx);
+  ctx.sbuf_.Clear();
+  if (ctx.is_zbuf_)
+    ctx.zbuf_.Clear();
+
+  float m[9];
+  coords::World2CameraMatrix(ctx.cam_->dir_, ctx.cam_->trig_, m);
+  for (auto* obj : objs)
+    if (obj->active_)
+      render_helpers::WiredToCamera(*obj, m, ctx);
+
+  if (ctx.is_zbuf_)
+    for (const auto* obj : objs)
+      if (obj->active_)
+        render_helpers::WiredDepth(*obj, ctx);
+
+  int drawn {0};
+  for (const auto* obj : objs)
+    if (obj->active_)
+      drawn += render_helpers::WiredEdges(*obj, ctx);
+
+  if (ctx.post_)
+    postproc::Apply(*ctx.post_, ctx.sbuf_);
+  if (ctx.text_)
+    ctx.text_->Flush(ctx.sbuf_);
+  ctx.sbuf_.SendDataToFB();
+  ctx.pixels_drawn_ = 0;
+
+  return drawn;
+}
+
 // Renders triangles and uses dist as chooser between affine and perspective
-// correct texturing
+// correct texturing. Sky (if is on) is drawn after triangles
 
 int render::Solid(const V_TrianglePtr& arr, RenderContext& ctx) noexcept
 {
@@ -379,6 +429,37 @@ int render::Solid(const V_TrianglePtr& arr, RenderContext& ctx) noexcept
     auto& v2 = t->vxs_[1];
     auto& v3 = t->vxs_[2];
 
+    // Draw both halves of regular grid quad at once by the first half
+
+    if (t->quad_ != Quad::NONE)
+    {
+      auto* first = t->quad_ == Quad::FIRST ? t : t - 1;
+      if (render_helpers::IsQuad(first, ctx))
+      {
+        if (t == first)
+          render_helpers::DrawQuad(first, ctx);
+        ++total_tris;
+        continue;
+      }
+    }
+
+    // Draw reflective triangle (i.e. water) with mirrored image
+
+    if (t->reflection_)
+    {
+      render_helpers::DrawReflected(t, ctx);
+      ++total_tris;
+      continue;
+    }
+
+    // Draw small triangle using fast path
+
+    if (render_helpers::DrawTinyTriangle(t, ctx))
+    {
+      ++total_tris;
+      continue;
+    }
+
     // Draw textured triangle
 
     if (!t->textures_->empty())
@@ -396,7 +477,7 @@ int render::Solid(const V_TrianglePtr& arr, RenderContext& ctx) noexcept
       }
       else if (t->shading_ == Shading::GOURANG)
       {
-        if (v1.pos_.z < ctx.clarity_)
+        if (v1.pos_.z < ctx.clarity_ && !render_helpers::IsAffineAccurate(t, ctx))
           raster_tri::TexturedPerspectiveGR(v1, v2, v3, tex, zbuf, sbuf);
         else if (ctx.is_bifiltering_)
           raster_tri::TexturedAffineGRBF(v1, v2, v3, tex, zbuf, sbuf);
@@ -413,12 +494,14 @@ int render::Solid(const V_TrianglePtr& arr, RenderContext& ctx) noexcept
     }
     ++total_tris;
   }
+  render_helpers::DrawSky(ctx);
 
   return total_tris;
 }
 
 // Renders triangles, uses dist as chooser between affine and perspective
-// correct texturing, and use alpha blending
+// correct texturing, and use alpha blending. Sky (if is on) is drawn after
+// opaque triangles, thus transparent ones are blended with it
 
 int render::SolidWithAlpha(const V_TrianglePtr& arr, RenderContext& ctx) noexcept
 {
@@ -435,6 +518,7 @@ int render::SolidWithAlpha(const V_TrianglePtr& arr, RenderContext& ctx) noexcep
 
   int tri_idx {-1};
   int alpha_cnt {0};
+  bool sky_drawn {false};
   auto it = arr.begin();
   Triangle* t = nullptr;
 
@@ -454,6 +538,10 @@ int render::SolidWithAlpha(const V_TrianglePtr& arr, RenderContext& ctx) noexcep
       }
     }
     else {
+      if (!sky_drawn) {
+        render_helpers::DrawSky(ctx);
+        sky_drawn = true;
+      }
       t = arr[alpha_tris[alpha_cnt-1]];
       --alpha_cnt;
     }
@@ -462,6 +550,37 @@ int render::SolidWithAlpha(const V_TrianglePtr& arr, RenderContext& ctx) noexcep
     auto& v2 = t->vxs_[1];
     auto& v3 = t->vxs_[2];
 
+    // Draw both halves of regular grid quad at once by the first half
+
+    if (t->quad_ != Quad::NONE)
+    {
+      auto* first = t->quad_ == Quad::FIRST ? t : t - 1;
+      if (render_helpers::IsQuad(first, ctx))
+      {
+        if (t == first)
+          render_helpers::DrawQuad(first, ctx);
+        ++total_tris;
+        continue;
+      }
+    }
+
+    // Draw reflective triangle (i.e. water) with mirrored image
+
+    if (t->reflection_)
+    {
+      render_helpers::DrawReflected(t, ctx);
+      ++total_tris;
+      continue;
+    }
+
+    // Draw small triangle using fast path
+
+    if (render_helpers::DrawTinyTriangle(t, ctx))
+    {
+      ++total_tris;
+      continue;
+    }
+
     // Draw textured triangle
 
     if (!t->textures_->empty())
@@ -479,7 +598,7 @@ int render::SolidWithAlpha(const V_TrianglePtr& arr, RenderContext& ctx) noexcep
       }
       else if (t->shading_ == Shading::GOURANG)
       {
-        if (v1.pos_.z < ctx.clarity_)
+        if (v1.pos_.z < ctx.clarity_ && !render_helpers::IsAffineAccurate(t, ctx))
           raster_tri::TexturedPerspectiveGR(v1, v2, v3, tex, zbuf, sbuf);
         else if (ctx.is_bifiltering_)
           raster_tri::TexturedAffineGRBF(v1, v2, v3, tex, zbuf, sbuf);
@@ -500,10 +619,87 @@ int render::SolidWithAlpha(const V_TrianglePtr& arr, RenderContext& ctx) noexcep
 
     ++total_tris;
   }
+  if (!sky_drawn)
+    render_helpers::DrawSky(ctx);
 
   return total_tris;
 }
 
+// Returns true if sky should be drawn behind the scene
+
+bool render_helpers::IsSkyOn(const RenderContext& ctx)
+{
+  return ctx.sky_ && ctx.cam_ && ctx.is_zbuf_ && !ctx.is_wired_;
+}
+
+// Draws sky to pixels which weren`t covered by triangles
+
+int render_helpers::DrawSky(RenderContext& ctx)
+{
+  if (!render_helpers::IsSkyOn(ctx))
+    return 0;
+  return sky::Draw(*ctx.sky_, *ctx.cam_, ctx.zbuf_, ctx.sbuf_);
+}
+
+// Returns true if triangle is the first half of grid quad and both halves
+// may be drawn by quad rasterizer. Since both halves ask the same, the quad
+// is drawn once, otherwise halves are drawn as usual triangles
+
+bool render_helpers::IsQuad(const Triangle* first, const RenderContext& ctx)
+{
+  const Triangle* second = first + 1;
+
+  if (first->quad_ != Quad::FIRST || second->quad_ != Quad::SECOND)
+    return false;
+  if (!first->active_ || !second->active_)
+    return false;
+  if (first->textures_->empty() || first->shading_ != Shading::GOURANG)
+    return false;
+  if (ctx.is_bifiltering_)
+    return false;
+
+  for (auto* t : {first, second})
+  {
+    auto& v = t->vxs_;
+    if (t->color_.a_ < 1.0f || v[0].color_.a_ < 1.0f)
+      return false;
+    if (raster_helpers::IsTinyTriangle(v[0], v[1], v[2], ctx.tiny_tri_size_))
+      return false;
+    if (v[0].pos_.z < ctx.clarity_ && !render_helpers::IsAffineAccurate(t, ctx))
+      return false;
+  }
+  return raster_helpers::IsConvexQuad(
+    first->vxs_[0], first->vxs_[1], second->vxs_[1], first->vxs_[2]);
+}
+
+// Draws both halves of grid quad (quad {a,b,d,c} is splitted into {a,b,c}
+// and {b,d,c}) and returns numbers of drawn pixels
+
+int render_helpers::DrawQuad(Triangle* first, RenderContext& ctx)
+{
+  auto* second = first + 1;
+  auto* tex = render_helpers::ChooseMipmapLevel(first, ctx);
+  return raster_tri::TexturedAffineGR(
+    first->vxs_[0], first->vxs_[1], second->vxs_[1], first->vxs_[2],
+    tex, ctx.zbuf_, ctx.sbuf_);
+}
+
+// Draws triangle which samples mirrored image from its reflection buffer.
+// Flat and const shaded triangles are drawn with the color of triangle
+
+int render_helpers::DrawReflected(Triangle* t, RenderContext& ctx)
+{
+  if (t->shading_ == Shading::GOURANG)
+    return raster_tri::ReflectedGR(
+      t->vxs_[0], t->vxs_[1], t->vxs_[2], *t->reflection_, ctx.zbuf_, ctx.sbuf_);
+
+  Vertex vxs[3] {t->vxs_[0], t->vxs_[1], t->vxs_[2]};
+  for (auto& vx : vxs)
+    vx.color_ = t->color_;
+  return raster_tri::ReflectedGR(
+    vxs[0], vxs[1], vxs[2], *t->reflection_, ctx.zbuf_, ctx.sbuf_);
+}
+
 // Returns best mipmap texture based on simplified distance choosing
 
 Bitmap* render_helpers::ChooseMipmapLevel(Triangle* t, const RenderContext& ctx)
@@ -519,4 +715,164 @@ Bitmap* render_helpers::ChooseMipmapLevel(Triangle* t, const RenderContext& ctx)
   return (*t->textures_)[mipmap].get();
 }
 
+// Draws triangle by the small triangles fast path if its screen bounding
+// box is less than ctx.tiny_tri_size_. Returns false if triangle is not small
+
+bool render_helpers::DrawTinyTriangle(Triangle* t, RenderContext& ctx)
+{
+  auto& v1 = t->vxs_[0];
+  auto& v2 = t->vxs_[1];
+  auto& v3 = t->vxs_[2];
+
+  if (!raster_helpers::IsTinyTriangle(v1, v2, v3, ctx.tiny_tri_size_))
+    return false;
+
+  // Make one color for the whole triangle (gouraud is averaged, const
+  // textured is not lighted)
+
+  Bitmap* tex {nullptr};
+  if (!t->textures_->empty())
+    tex = render_helpers::ChooseMipmapLevel(t, ctx);
+
+  FColor color {t->color_};
+  if (t->shading_ == Shading::GOURANG)
+  {
+    color = (v1.color_ + v2.color_ + v3.color_) / 3.0f;
+    color.a_ = v1.color_.a_;
+  }
+  else if (tex)
+  {
+    if (t->shading_ == Shading::CONST)
+      color = FColor{255.0f, 255.0f, 255.0f};
+    color.a_ = v1.color_.a_;
+  }
+
+  raster_tri::Tiny(v1, v2, v3, color, tex, ctx.zbuf_, ctx.sbuf_);
+  return true;
+}
+
+// Returns true if depth ratio of the triangle is small enough to draw it with
+// affine texturing (i.e. when triangles were subdivided by triangles::Subdivide)
+
+bool render_helpers::IsAffineAccurate(const Triangle* t, const RenderContext& ctx)
+{
+  return ctx.affine_ratio_ > 0.0f && 
+         triangle::DepthRatio(*t) <= ctx.affine_ratio_;
+}
+
+// Transforms to camera coordinates only vertices of active faces, where m
+// is the camera rotation matrix (see coords::World2CameraMatrix)
+
+void render_helpers::WiredToCamera(
+  GlObject& obj, const float* m, RenderContext& ctx)
+{
+  auto& vxs = obj.GetCoords();
+  auto& marks = ctx.wired_marks_;
+  marks.assign(vxs.size(), 0);
+  for (const auto& face : obj.faces_)
+  {
+    if (face.active_)
+      marks[face[0]] = marks[face[1]] = marks[face[2]] = 1;
+  }
+
+  const auto& cam_pos = ctx.cam_->vrp_;
+  for (std::size_t i = 0; i < vxs.size(); ++i)
+  {
+    if (!marks[i])
+      continue;
+    Vector p = vxs[i].pos_ - cam_pos;
+    vxs[i].pos_.x = m[0] * p.x + m[1] * p.y + m[2] * p.z;
+    vxs[i].pos_.y = m[3] * p.x + m[4] * p.y + m[5] * p.z;
+    vxs[i].pos_.z = m[6] * p.x + m[7] * p.y + m[8] * p.z;
+  }
+}
+
+// Draws active faces of object (in camera coordinates) to zbuffer only.
+// Faces crossed by near or far planes are skipped
+
+int render_helpers::WiredDepth(const GlObject& obj, RenderContext& ctx)
+{
+  const auto& cam = *ctx.cam_;
+  const auto& vxs = obj.GetCoords();
+  int drawn {0};
+
+  for (const auto& face : obj.faces_)
+  {
+    if (!face.active_)
+      continue;
+
+    const auto& p1 = vxs[face[0]].pos_;
+    const auto& p2 = vxs[face[1]].pos_;
+    const auto& p3 = vxs[face[2]].pos_;
+    if (std::min({p1.z, p2.z, p3.z}) < cam.z_near_ ||
+        std::max({p1.z, p2.z, p3.z}) > cam.z_far_)
+      continue;
+
+    drawn += raster_tri::Depth(
+      Project(p1, cam), Project(p2, cam), Project(p3, cam), ctx.zbuf_);
+  }
+  return drawn;
+}
+
+// Draws edges of object (in camera coordinates) which belong to at least
+// one active face. Returns count of drawn edges
+
+int render_helpers::WiredEdges(const GlObject& obj, RenderContext& ctx)
+{
+  const auto& cam = *ctx.cam_;
+  const auto& vxs = obj.GetCoords();
+  int w = ctx.sbuf_.Width();
+  int h = ctx.sbuf_.Height();
+  int drawn {0};
+
+  for (const auto& edge : obj.edges_)
+  {
+    int face = edge.face_1_;
+    if (!obj.faces_[face].active_)
+      face = edge.face_2_;
+    if (face < 0 || !obj.faces_[face].active_)
+      continue;
+
+    Vector p1 = vxs[edge.v1_].pos_;
+    Vector p2 = vxs[edge.v2_].pos_;
+    if (!debug_helpers::ClipZ(p1, p2, cam.z_near_, cam.z_far_))
+      continue;
+
+    p1 = Project(p1, cam);
+    p2 = Project(p2, cam);
+    int color = obj.faces_[face].color_.GetARGB();
+
+    if (ctx.is_zbuf_)
+      raster::LineZ(
+        p1.x, p1.y, debug_render::kDepthBias / p1.z,
+        p2.x, p2.y, debug_render::kDepthBias / p2.z,
+        color, ctx.zbuf_, ctx.sbuf_);
+    else if (segment2d::Clip(0, 0, w-1, h-1, p1.x, p1.y, p2.x, p2.y))
+      raster::Line(p1.x, p1.y, p2.x, p2.y, color, ctx.sbuf_);
+    ++drawn;
+  }
+  return drawn;
+}
+
+// Projects point from camera to screen coordinates (z is kept)
+
+Vector render_helpers::Project(cVector& p, const GlCamera& cam)
+{
+  float half_wov = cam.wov_ / 2.0f;
+  return Vector{
+    (p.x * cam.dov_ / p.z + half_wov) * (cam.scr_w_ / cam.wov_),
+    (p.y * cam.dov_ * cam.ar_ / p.z + half_wov) * (cam.scr_h_ / cam.wov_),
+    p.z
+  };
+}
+
+// Makes memory layout of screen and z buffers the same as requested by
+// ctx.is_tiled_ (rasterizers use one index for both buffers)
+
+void render_helpers::SyncBuffersLayout(RenderContext& ctx)
+{
+  ctx.sbuf_.SetTiled(ctx.is_tiled_);
+  ctx.zbuf_.SetTiled(ctx.is_tiled_);
+}
+
 } // namespace anshub
\ No newline at end of file
@@ -60,6 +60,7 @@ namespace render {
 
   int  Context(const V_TrianglePtr&, RenderContext&) noexcept;
   int  Context(const V_TrianglePtr&, RenderContext&, DebugContext&) noexcept;
+  int  Wired(const V_GlObjectP&, RenderContext&) noexcept;
   int  Solid(const V_TrianglePtr&, RenderContext&) noexcept;
   int  SolidWithAlpha(const V_TrianglePtr&, RenderContext&) noexcept;
 
@@ -70,6 +71,21 @@ namespace render {
 namespace render_helpers {
 
   Bitmap* ChooseMipmapLevel(Triangle*, const RenderContext&);
+  bool    DrawTinyTriangle(Triangle*, RenderContext&);
+  bool    IsAffineAccurate(const Triangle*, const RenderContext&);
+  bool    IsSkyOn(const RenderContext&);
+  int     DrawSky(RenderContext&);
+  bool    IsQuad(const Triangle* first, const RenderContext&);
+  int     DrawQuad(Triangle* first, RenderContext&);
+  int     DrawReflected(Triangle*, RenderContext&);
+  void    SyncBuffersLayout(RenderContext&);
+
+  // Wired mode by unique edges of objects (see note #1)
+
+  void    WiredToCamera(GlObject&, const float* m, RenderContext&);
+  int     WiredDepth(const GlObject&, RenderContext&);
+  int     WiredEdges(const GlObject&, RenderContext&);
+  Vector  Project(cVector&, const GlCamera&);
 
 }
 
@@ -94,4 +110,10 @@ inline int render::Solid(const V_TrianglePtr& t, ZBuffer& z, ScrBuffer& b)
 
 } // namespace anshub
 
-#endif  // GL_DRAW_H
\ No newline at end of file
+#endif  // GL_DRAW_H
+
+// Note #1 : render::Wired() takes objects in world coordinates and
+//  transforms to camera space only vertices of active faces. If zbuffer is
+//  on, active faces are drawn to zbuffer only (pre-pass), and then each
+//  edge is drawn once with 1/z test. Thus hidden lines are removed, while
+//  shared edges aren`t drawn twice as by draw_triangles::Wired()
\ No newline at end of file
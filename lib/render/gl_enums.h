@@ -40,6 +40,18 @@ enum class Shading
 
 }; // enum class Shading
 
+// Used to mark two faces (triangles) of regular grid which form one quad. The
+// second half goes right after the first and shares its v1-v2 edge, i.e. the
+// quad {a,b,d,c} is splitted into halves {a,b,c} and {b,d,c}
+
+enum class Quad
+{
+  NONE,
+  FIRST,
+  SECOND
+
+}; // enum class Quad
+
 // Used to define which texturing we would use
 
 enum class Texturing
@@ -7,6 +7,7 @@
 #ifndef GC_GL_FACE_H
 #define GC_GL_FACE_H
 
+#include "lib/render/gl_enums.h"
 #include "lib/render/gl_aliases.h"
 #include "lib/render/fx_colors.h"
 #include "lib/render/gl_vertex.h"
@@ -28,9 +29,48 @@ struct Face
   Vector    normal_;
   FColor    color_;
   A3_Float  angles_;  // angles to compute vertices normals
+  Quad      quad_;    // half of regular grid quad (see gl_enums.h)
 
 }; // struct Face
 
+// Edge of the mesh shared by one or two faces
+
+struct MeshEdge
+{
+  int v1_;          // numbers of vertices in vertices list
+  int v2_;
+  int face_1_;      // numbers of faces in faces list
+  int face_2_;      // -1 if edge is border
+
+}; // struct MeshEdge
+
+// Cluster of neighboring faces with bounding sphere and cone of faces
+// normals, used to cull faces by groups (see gl_clusters.h)
+
+struct MeshCluster
+{
+  int     first_;     // number of first face in faces list
+  int     count_;     // count of faces
+  Vector  center_;    // bounding sphere in coordinates of vertices
+  float   rad_;
+  Vector  axis_;      // axis of normals cone
+  float   cos_;       // cos and sin of half angle of normals cone (cone
+  float   sin_;       // isn`t used if cos_ <= 0)
+
+}; // struct MeshCluster
+
+// Faces of the mesh and data computed by them for one level of detail (see
+// gl_lods.h)
+
+struct MeshLod
+{
+  V_Face        faces_;
+  V_MeshEdge    edges_;
+  V_MeshCluster clusters_;
+  V_Vector      normals_local_;
+
+}; // struct MeshLod
+
 //**********************************************************************
 // Inline implementation
 //**********************************************************************
@@ -53,6 +93,7 @@ inline Face::Face(V_Vertex& vxs, int f1, int f2, int f3)
     vector::AngleBetween(
       Vector(vxs[f1].pos_ - vxs[f3].pos_), Vector(vxs[f2].pos_ - vxs[f3].pos_)
     ) }
+  , quad_{Quad::NONE}
 {
   if (!normal_.IsZero())
     normal_.Normalize();
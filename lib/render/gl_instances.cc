@@ -0,0 +1,167 @@
+// *************************************************************
+// File:    gl_instances.cc
+// Descr:   instances of shared meshes
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#include "gl_instances.h"
+
+namespace anshub {
+
+// Returns mesh loaded from file. File is loaded, levels of detail are made,
+// and faces are sorted and clustered only at the first request
+
+P_GlObject MeshCache::Get(const std::string& fname)
+{
+  auto found = meshes_.find(fname);
+  if (found != meshes_.end())
+    return found->second;
+
+  auto mesh = std::make_shared<GlObject>(fname, Vector{0.0f, 0.0f, 0.0f});
+  object::MakeClusters(*mesh);
+  if (lods_ > 1)
+  {
+    auto lods_fname = str::Replace(fname, ".ply", ".lod");
+    if (!lods::Load(*mesh, lods_fname))
+    {
+      lods::Make(*mesh, lods_);
+      lods::Save(*mesh, lods_fname);    // without cache if can`t be saved
+    }
+  }
+  meshes_[fname] = mesh;
+  return mesh;
+}
+
+// Culls faces of mesh for given instance and transforms vertices of the rest
+// faces from local to world coordinates (see note #1 in header). Returns count
+// of culled faces
+
+int instance::Build(
+  MeshInstance& inst, const GlCamera& cam, cTrigTable& trig, V_Uchar& marks)
+{
+  auto& mesh = *inst.mesh_;
+  lods::Set(mesh, inst.lod_);
+  object::ResetAttributes(mesh);
+  mesh.SetCoords(Coords::TRANS);
+  mesh.world_pos_ = inst.world_pos_;
+  if (mesh.clusters_.empty())
+    object::MakeClusters(mesh);
+
+  float m[9];
+  instance_helpers::RotationMatrix(inst.dir_, trig, m);
+  float inv_scale = 1.0f / inst.scale_;
+
+  // Camera position and frustum planes in local coords. Rotation matrix is
+  // orthogonal, thus transposed matrix is the inverse rotation
+
+  Vector p {cam.vrp_ - inst.world_pos_};
+  Vector cam_pos {
+    (m[0] * p.x + m[3] * p.y + m[6] * p.z) * inv_scale,
+    (m[1] * p.x + m[4] * p.y + m[7] * p.z) * inv_scale,
+    (m[2] * p.x + m[5] * p.y + m[8] * p.z) * inv_scale
+  };
+
+  std::array<Plane3d, 6> planes {};
+  for (std::size_t i = 0; i < planes.size(); ++i)
+  {
+    const auto& w = cam.frustum_[i];
+    planes[i].a_ = m[0] * w.a_ + m[3] * w.b_ + m[6] * w.c_;
+    planes[i].b_ = m[1] * w.a_ + m[4] * w.b_ + m[7] * w.c_;
+    planes[i].c_ = m[2] * w.a_ + m[5] * w.b_ + m[8] * w.c_;
+    planes[i].d_ = (w.a_ * inst.world_pos_.x + w.b_ * inst.world_pos_.y +
+                    w.c_ * inst.world_pos_.z + w.d_) * inv_scale;
+  }
+
+  int cnt = clusters::Cull(mesh.clusters_, mesh.faces_, planes, cam_pos);
+  cnt += object::RemoveHiddenSurfacesLocal(mesh, cam_pos);
+
+  // Transform vertices and normals of remaining faces (scale is uniform,
+  // thus normals are only rotated)
+
+  auto& src = mesh.vxs_local_;
+  auto& dst = mesh.vxs_trans_;
+  dst.resize(src.size());
+  marks.assign(src.size(), 0);
+  for (std::size_t i = 0; i < mesh.faces_.size(); ++i)
+  {
+    auto& face = mesh.faces_[i];
+    if (!face.active_)
+      continue;
+    marks[face[0]] = marks[face[1]] = marks[face[2]] = 1;
+    cVector& n = mesh.normals_local_[i];
+    face.normal_.x = m[0] * n.x + m[1] * n.y + m[2] * n.z;
+    face.normal_.y = m[3] * n.x + m[4] * n.y + m[5] * n.z;
+    face.normal_.z = m[6] * n.x + m[7] * n.y + m[8] * n.z;
+  }
+
+  for (std::size_t i = 0; i < src.size(); ++i)
+  {
+    if (!marks[i])
+      continue;
+    dst[i] = src[i];
+    cVector& v = src[i].pos_;
+    cVector& n = src[i].normal_;
+    dst[i].pos_.x = (m[0] * v.x + m[1] * v.y + m[2] * v.z) * inst.scale_;
+    dst[i].pos_.y = (m[3] * v.x + m[4] * v.y + m[5] * v.z) * inst.scale_;
+    dst[i].pos_.z = (m[6] * v.x + m[7] * v.y + m[8] * v.z) * inst.scale_;
+    dst[i].pos_ += inst.world_pos_;
+    dst[i].normal_.x = m[0] * n.x + m[1] * n.y + m[2] * n.z;
+    dst[i].normal_.y = m[3] * n.x + m[4] * n.y + m[5] * n.z;
+    dst[i].normal_.z = m[6] * n.x + m[7] * n.y + m[8] * n.z;
+  }
+  return cnt;
+}
+
+// Adds active faces of mesh (built for given instance) to triangles and
+// tints them by the color of instance
+
+void instance::AddTriangles(const MeshInstance& inst, V_Triangle& tris)
+{
+  std::size_t first = tris.size();
+  triangles::AddFromObject(*inst.mesh_, tris);
+
+  cFColor& tint = inst.tint_;
+  if (tint.r_ == 1.0f && tint.g_ == 1.0f && tint.b_ == 1.0f)
+    return;
+
+  for (std::size_t i = first; i < tris.size(); ++i)
+  {
+    tris[i].color_ *= tint;
+    for (auto& vx : tris[i].vxs_)
+      vx.color_ *= tint;
+  }
+}
+
+// Fills rotation matrix (row-major 3x3, column vector) which rotates vectors
+// as object::Rotate() does, i.e. by y, then by x, then by z axis
+
+void instance_helpers::RotationMatrix(cVector& dir, cTrigTable& t, float* m)
+{
+  float ysin = t.Sin(dir.y);
+  float ycos = t.Cos(dir.y);
+  float xsin = t.Sin(dir.x);
+  float xcos = t.Cos(dir.x);
+  float zsin = t.Sin(dir.z);
+  float zcos = t.Cos(dir.z);
+
+  // Rotate basis vectors, which are the columns of matrix
+
+  for (int col = 0; col < 3; ++col)
+  {
+    Vector v {col == 0 ? 1.0f : 0.0f, col == 1 ? 1.0f : 0.0f, col == 2 ? 1.0f : 0.0f};
+    float old {v.x};
+    v.x = (v.x * ycos) + (v.z * ysin);
+    v.z = (v.z * ycos) - (old * ysin);
+    old = v.y;
+    v.y = (v.y * xcos) - (v.z * xsin);
+    v.z = (v.z * xcos) + (old * xsin);
+    old = v.x;
+    v.x = (v.x * zcos) - (v.y * zsin);
+    v.y = (v.y * zcos) + (old * zsin);
+    m[col] = v.x;
+    m[3 + col] = v.y;
+    m[6 + col] = v.z;
+  }
+}
+
+} // namespace anshub
@@ -0,0 +1,109 @@
+// *************************************************************
+// File:    gl_instances.h
+// Descr:   instances of shared meshes
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef GC_GL_INSTANCES_H
+#define GC_GL_INSTANCES_H
+
+#include <map>
+#include <string>
+#include <memory>
+#include <array>
+
+#include "lib/render/gl_aliases.h"
+#include "lib/render/gl_object.h"
+#include "lib/render/gl_triangle.h"
+#include "lib/render/gl_clusters.h"
+#include "lib/render/gl_lods.h"
+#include "lib/render/fx_colors.h"
+#include "lib/render/cameras/gl_camera.h"
+
+#include "lib/math/trig.h"
+#include "lib/math/vector.h"
+#include "lib/math/plane3d.h"
+
+namespace anshub {
+
+//****************************************************************************
+// Instance of mesh. Geometry and textures are shared between instances of
+// the same mesh, and instance holds only transform, bounds and state (see
+// note #1)
+//****************************************************************************
+
+struct MeshInstance
+{
+  MeshInstance(P_GlObject mesh, cVector& world_pos);
+
+  P_GlObject mesh_;           // shared mesh, used as scratch buffer too
+  bool      active_;          // state
+  Vector    world_pos_;       // position of mesh center in world`s coords
+  Vector    dir_;             // rotation angles (YXZ as in object::Rotate())
+  float     scale_;
+  float     sphere_rad_;      // bounding sphere radius
+  FColor    tint_;            // multiplies colors of triangles
+  int       lod_;             // level of detail of mesh (see gl_lods.h)
+
+}; // struct MeshInstance
+
+//****************************************************************************
+// Meshes loaded from files, each file is loaded only once. If levels of
+// detail are requested, they are loaded from the file near the mesh file
+// (the same name with "lod" extension), or are made and saved there
+//****************************************************************************
+
+struct MeshCache
+{
+  explicit MeshCache(int lods = 1) : lods_{lods}, meshes_{} { }
+
+  P_GlObject Get(const std::string& fname);
+  int   Size() const { return meshes_.size(); }
+
+  int   lods_;                // levels of detail of each mesh
+  std::map<std::string, P_GlObject> meshes_;
+
+}; // struct MeshCache
+
+namespace instance {
+
+  int   Build(MeshInstance&, const GlCamera&, cTrigTable&, V_Uchar& marks);
+  void  AddTriangles(const MeshInstance&, V_Triangle&);
+
+} // namespace instance
+
+namespace instance_helpers {
+
+  void  RotationMatrix(cVector& dir, cTrigTable&, float* m);
+
+} // namespace instance_helpers
+
+//****************************************************************************
+// Inline implementation
+//****************************************************************************
+
+inline MeshInstance::MeshInstance(P_GlObject mesh, cVector& world_pos)
+  : mesh_{mesh}
+  , active_{true}
+  , world_pos_{world_pos}
+  , dir_{0.0f, 0.0f, 0.0f}
+  , scale_{1.0f}
+  , sphere_rad_{mesh->sphere_rad_}
+  , tint_{1.0f, 1.0f, 1.0f}
+  , lod_{0}
+{ }
+
+}  // namespace anshub
+
+#endif  // GC_GL_INSTANCES_H
+
+// Note #1 : instances are processed one by one. Build() culls faces of mesh
+//  by clusters and removes back faces in local coords of mesh (camera is
+//  moved to local coords by inverse transform of instance), then transforms
+//  only vertices of remaining faces into transformed coords of mesh (and
+//  rotates cached local normals of these faces). Then
+//  AddTriangles() copies faces into triangles, thus mesh may be used for the
+//  next instance. Level of detail of mesh is set by Build() for each
+//  instance. Mesh shouldn`t have streams, and its local vertices
+//  shouldn`t be changed after instances are made (radiuses of instances
+//  depend on them)
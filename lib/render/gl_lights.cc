@@ -124,9 +124,10 @@ void light::Objects(V_GlObject& arr, Lights& lights)
     if (obj.active_) light::Object(obj, lights);
 }
 
-// Lights triangles (in camera coordinates)
+// Lights triangles (in camera coordinates). Normals of flat shaded
+// triangles may be given already normalized
 
-void light::Triangles(V_Triangle& arr, Lights& lights)
+void light::Triangles(V_Triangle& arr, Lights& lights, bool normalize)
 {
   for (auto& tri : arr)
   {
@@ -146,7 +147,7 @@ void light::Triangles(V_Triangle& arr, Lights& lights)
       auto& cc = tri.color_;              // color to change
       cc = {0.0f, 0.0f, 0.0f, bc.a_};
 
-      if (!tri.normal_.IsZero())
+      if (normalize && !tri.normal_.IsZero())
         tri.normal_.Normalize();
 
       for (auto& light : lights.ambient_)
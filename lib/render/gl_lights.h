@@ -49,7 +49,7 @@ namespace light {
 
   void Object(GlObject&, Lights&);
   void Objects(V_GlObject&, Lights&);
-  void Triangles(V_Triangle&, Lights&);
+  void Triangles(V_Triangle&, Lights&, bool normalize = true);
 
 } // namespace light
   
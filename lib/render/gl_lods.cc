@@ -0,0 +1,421 @@
+// *************************************************************
+// File:    gl_lods.cc
+// Descr:   levels of detail of objects
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#include "gl_lods.h"
+
+namespace anshub {
+
+// Makes simplified levels of object (see note #1 in header). Object should
+// be on the level 0. If mesh can`t be simplified enough, then levels count
+// would be less than requested
+
+void lods::Make(GlObject& obj, int levels)
+{
+  lods::Set(obj, 0);
+  obj.lods_.clear();
+  if (levels < 2)
+    return;
+
+  auto faces = lods_helpers::Simplify(obj.vxs_local_, obj.faces_, levels);
+  if (faces.empty())
+    return;
+
+  obj.lods_.resize(1);    // place for level 0, which is in object now
+  for (auto& level : faces)
+  {
+    obj.lods_.push_back(
+      lods_helpers::MakeLevel(obj.vxs_local_, std::move(level)));
+  }
+}
+
+// Loads levels made by Save() from the file. Returns false if file is absent
+// or if it was made for other mesh (or for older version of this mesh)
+
+bool lods::Load(GlObject& obj, const std::string& fname)
+{
+  std::ifstream fs {fname};
+  if (!fs)
+    return false;
+
+  lods::Set(obj, 0);
+  std::string header {};
+  int levels {0};
+  std::size_t vxs_cnt {0};
+  std::size_t faces_cnt {0};
+  std::uint64_t hash {0};
+  fs >> header >> levels >> vxs_cnt >> faces_cnt >> hash;
+  if (!fs || header != "lods" || levels < 1 ||
+      vxs_cnt != obj.vxs_local_.size() || faces_cnt != obj.faces_.size() ||
+      hash != lods_helpers::ComputeHash(obj.vxs_local_, obj.faces_))
+    return false;
+
+  int total = obj.vxs_local_.size();
+  V_MeshLod res (1);
+  for (int i = 1; i < levels; ++i)
+  {
+    int cnt {0};
+    fs >> cnt;
+    if (!fs || cnt <= 0)
+      return false;
+
+    V_Face faces {};
+    faces.reserve(cnt);
+    for (int k = 0; k < cnt; ++k)
+    {
+      int f1 {0}, f2 {0}, f3 {0};
+      fs >> f1 >> f2 >> f3;
+      if (!fs || std::min({f1, f2, f3}) < 0 || std::max({f1, f2, f3}) >= total)
+        return false;
+      faces.push_back(lods_helpers::MakeFace(obj.vxs_local_, f1, f2, f3));
+    }
+    res.push_back(lods_helpers::MakeLevel(obj.vxs_local_, std::move(faces)));
+  }
+  obj.lods_ = std::move(res);
+  return true;
+}
+
+// Saves levels of object to the file
+
+bool lods::Save(const GlObject& obj, const std::string& fname)
+{
+  std::ofstream fs {fname};
+  if (!fs)
+    return false;
+
+  int levels = std::max<int>(1, obj.lods_.size());
+  cV_Face& full = obj.lod_ == 0 ? obj.faces_ : obj.lods_.front().faces_;
+  fs << "lods " << levels << ' ' << obj.vxs_local_.size() << ' '
+     << full.size() << ' '
+     << lods_helpers::ComputeHash(obj.vxs_local_, full) << '\n';
+
+  for (int i = 1; i < levels; ++i)
+  {
+    cV_Face& faces = i == obj.lod_ ? obj.faces_ : obj.lods_[i].faces_;
+    fs << faces.size() << '\n';
+    for (const auto& face : faces)
+      fs << face[0] << ' ' << face[1] << ' ' << face[2] << '\n';
+  }
+  return static_cast<bool>(fs);
+}
+
+// Makes given level to be current. Faces, edges, clusters and local normals
+// of object are swapped with ones of level
+
+void lods::Set(GlObject& obj, int level)
+{
+  if (obj.lods_.empty())
+    return;
+
+  level = std::max(0, std::min(level, static_cast<int>(obj.lods_.size()) - 1));
+  if (level == obj.lod_)
+    return;
+
+  for (int i : {obj.lod_, level})
+  {
+    auto& lod = obj.lods_[i];
+    std::swap(obj.faces_, lod.faces_);
+    std::swap(obj.edges_, lod.edges_);
+    std::swap(obj.clusters_, lod.clusters_);
+    std::swap(obj.normals_local_, lod.normals_local_);
+  }
+  obj.lod_ = level;
+}
+
+// Returns level of detail for object with bounding sphere in the world. If
+// projected size is near the limits of current level, then current level is
+// kept to prevent popping of levels
+
+int lods::Select(
+  const GlCamera& cam, cVector& pos, float rad, int curr, int levels)
+{
+  float dist = Vector{cam.vrp_, pos}.Length();
+  if (levels < 2 || dist <= rad)
+    return 0;
+
+  float size = 2.0f * rad * cam.dov_ / dist * cam.scr_w_ / cam.wov_;
+  int coarser = lods_helpers::LevelBySize(size * (1.0f + kHysteresis), levels);
+  int finer = lods_helpers::LevelBySize(size * (1.0f - kHysteresis), levels);
+  if (coarser > curr)
+    return coarser;
+  else if (finer < curr)
+    return finer;
+  else
+    return curr;
+}
+
+// Simplifies mesh by collapses of edges with the least error (Garland and
+// Heckbert quadric error metrics). Vertex of edge is moved into other one,
+// thus vertices are not changed. Returns faces of levels 1..levels-1
+
+VV_Face lods_helpers::Simplify(V_Vertex& vxs, cV_Face& faces, int levels)
+{
+  int vxs_cnt = vxs.size();
+  int faces_cnt = faces.size();
+
+  std::vector<A3_Int> tris (faces_cnt);
+  std::vector<bool> alive (faces_cnt, true);
+  std::vector<std::vector<int>> vx_tris (vxs_cnt);
+  std::vector<Quadric> quadrics (vxs_cnt, Quadric{});
+  std::vector<int> stamps (vxs_cnt, 0);
+
+  auto normal = [&](const A3_Int& t) {
+    return vector::CrossProduct(
+      Vector{vxs[t[0]].pos_, vxs[t[1]].pos_},
+      Vector{vxs[t[0]].pos_, vxs[t[2]].pos_});
+  };
+
+  // Quadrics of faces planes weighted by faces areas
+
+  for (int i = 0; i < faces_cnt; ++i)
+  {
+    tris[i] = faces[i].vxs_;
+    Vector n = normal(tris[i]);
+    float len = n.Length();
+    for (auto v : tris[i])
+    {
+      vx_tris[v].push_back(i);
+      if (len > 0.0f)
+        AddPlane(quadrics[v], n / len, vxs[tris[i][0]].pos_, len / 2.0f);
+    }
+  }
+
+  // Border edges are kept by planes orthogonal to faces
+
+  auto edges = object::ComputeEdges(faces);
+  for (const auto& edge : edges)
+  {
+    if (edge.face_2_ >= 0)
+      continue;
+    Vector e {vxs[edge.v1_].pos_, vxs[edge.v2_].pos_};
+    Vector n = vector::CrossProduct(e, normal(tris[edge.face_1_]));
+    if (n.IsZero())
+      continue;
+    n.Normalize();
+    float weight = kBorderWeight * e.SquareLength();
+    AddPlane(quadrics[edge.v1_], n, vxs[edge.v1_].pos_, weight);
+    AddPlane(quadrics[edge.v2_], n, vxs[edge.v1_].pos_, weight);
+  }
+
+  // Queue of collapses. Collapse is out of date if stamp of one of its
+  // vertices is changed
+
+  struct Collapse
+  {
+    double  cost_;
+    int     from_;
+    int     to_;
+    int     stamp_;
+    bool operator<(const Collapse& rhs) const { return cost_ > rhs.cost_; }
+  };
+  std::priority_queue<Collapse> queue {};
+
+  auto push = [&](int from, int to) {
+    double cost = ComputeError(quadrics[from], quadrics[to], vxs[to].pos_);
+    queue.push(Collapse{cost, from, to, stamps[from] + stamps[to]});
+  };
+  for (const auto& edge : edges)
+  {
+    push(edge.v1_, edge.v2_);
+    push(edge.v2_, edge.v1_);
+  }
+
+  // Returns neighbours of vertex by alive faces (and removes dead faces)
+
+  auto neighbours = [&](int v) {
+    auto& list = vx_tris[v];
+    list.erase(std::remove_if(list.begin(), list.end(),
+      [&](int t) { return !alive[t]; }), list.end());
+    std::vector<int> res {};
+    for (auto t : list)
+    {
+      for (auto w : tris[t])
+      {
+        if (w != v)
+          res.push_back(w);
+      }
+    }
+    std::sort(res.begin(), res.end());
+    res.erase(std::unique(res.begin(), res.end()), res.end());
+    return res;
+  };
+
+  // Collapse is valid if it doesn`t change topology (neighbours of both
+  // vertices are only vertices of their shared faces) and doesn`t turn
+  // faces too much
+
+  auto is_valid = [&](int from, int to) {
+    auto from_nb = neighbours(from);
+    auto to_nb = neighbours(to);
+    std::vector<int> common {};
+    std::set_intersection(from_nb.begin(), from_nb.end(),
+      to_nb.begin(), to_nb.end(), std::back_inserter(common));
+
+    int shared {0};
+    for (auto t : vx_tris[from])
+    {
+      auto& tri = tris[t];
+      if (tri[0] == to || tri[1] == to || tri[2] == to)
+      {
+        ++shared;
+        continue;
+      }
+      A3_Int moved {tri};
+      std::replace(moved.begin(), moved.end(), from, to);
+      Vector old_n = normal(tri);
+      Vector new_n = normal(moved);
+      if (new_n.IsZero() || old_n.IsZero() ||
+          vector::DotProduct(old_n, new_n) <
+          kMinCos * old_n.Length() * new_n.Length())
+        return false;
+    }
+    return shared > 0 && static_cast<int>(common.size()) == shared;
+  };
+
+  VV_Face res {};
+  int alive_cnt = faces_cnt;
+  int last_cnt = faces_cnt;
+  while (static_cast<int>(res.size()) + 1 < levels)
+  {
+    // Collapse the cheapest edges until count of faces is halved
+
+    int target = last_cnt / 2;
+    while (alive_cnt > target && !queue.empty())
+    {
+      Collapse c = queue.top();
+      queue.pop();
+      if (c.stamp_ != stamps[c.from_] + stamps[c.to_] || c.from_ == c.to_)
+        continue;
+      if (!is_valid(c.from_, c.to_))
+        continue;
+
+      for (auto t : vx_tris[c.from_])
+      {
+        auto& tri = tris[t];
+        if (tri[0] == c.to_ || tri[1] == c.to_ || tri[2] == c.to_)
+        {
+          alive[t] = false;
+          --alive_cnt;
+        }
+        else
+        {
+          std::replace(tri.begin(), tri.end(), c.from_, c.to_);
+          vx_tris[c.to_].push_back(t);
+        }
+      }
+      vx_tris[c.from_].clear();
+      for (std::size_t k = 0; k < quadrics[c.to_].size(); ++k)
+        quadrics[c.to_][k] += quadrics[c.from_][k];
+
+      // Stamps of both vertices are changed, thus all collapses with them
+      // are out of date. Push new collapses of the rest vertex
+
+      ++stamps[c.from_];
+      ++stamps[c.to_];
+      for (auto w : neighbours(c.to_))
+      {
+        push(c.to_, w);
+        push(w, c.to_);
+      }
+    }
+
+    // Mesh can`t be simplified enough
+
+    if (alive_cnt > last_cnt * 3 / 4)
+      break;
+
+    V_Face level {};
+    level.reserve(alive_cnt);
+    for (int i = 0; i < faces_cnt; ++i)
+    {
+      if (alive[i])
+        level.push_back(MakeFace(vxs, tris[i][0], tris[i][1], tris[i][2]));
+    }
+    res.push_back(std::move(level));
+    last_cnt = alive_cnt;
+  }
+  return res;
+}
+
+// Makes level of detail from faces. Faces are sorted as faces of clustered
+// objects (see object::MakeClusters()), and clusters and local normals are
+// made on demand
+
+MeshLod lods_helpers::MakeLevel(V_Vertex& vxs, V_Face&& faces)
+{
+  MeshLod lod {};
+  lod.faces_ = std::move(faces);
+  clusters::SortFaces(vxs, lod.faces_);
+  lod.edges_ = object::ComputeEdges(lod.faces_);
+  return lod;
+}
+
+// Returns FNV-1a hash of positions of vertices and of indices of faces
+
+std::uint64_t lods_helpers::ComputeHash(cV_Vertex& vxs, cV_Face& faces)
+{
+  std::uint64_t hash {14695981039346656037ull};
+  auto add = [&hash](std::uint32_t val)
+  {
+    for (int i = 0; i < 4; ++i, val >>= 8)
+    {
+      hash ^= val & 0xff;
+      hash *= 1099511628211ull;
+    }
+  };
+
+  for (const auto& vx : vxs)
+  {
+    for (float coord : {vx.pos_.x, vx.pos_.y, vx.pos_.z})
+    {
+      std::uint32_t bits {0};
+      std::memcpy(&bits, &coord, sizeof(bits));
+      add(bits);
+    }
+  }
+  for (const auto& face : faces)
+  {
+    add(face[0]);
+    add(face[1]);
+    add(face[2]);
+  }
+  return hash;
+}
+
+// Adds quadric of the plane (given by unit normal and point) to quadric.
+// Elements of symmetric 4x4 matrix are stored by rows of upper triangle
+
+void lods_helpers::AddPlane(
+  Quadric& q, cVector& normal, cVector& point, float weight)
+{
+  double a = normal.x;
+  double b = normal.y;
+  double c = normal.z;
+  double d = -vector::DotProduct(normal, point);
+  double w = weight;
+  q[0] += w * a * a;  q[1] += w * a * b;  q[2] += w * a * c;  q[3] += w * a * d;
+  q[4] += w * b * b;  q[5] += w * b * c;  q[6] += w * b * d;
+  q[7] += w * c * c;  q[8] += w * c * d;
+  q[9] += w * d * d;
+}
+
+// Returns error of point by sum of two quadrics, i.e. v^t * (q1 + q2) * v
+
+double lods_helpers::ComputeError(
+  const Quadric& q1, const Quadric& q2, cVector& v)
+{
+  Quadric q {};
+  for (std::size_t i = 0; i < q.size(); ++i)
+    q[i] = q1[i] + q2[i];
+
+  double x = v.x;
+  double y = v.y;
+  double z = v.z;
+  return q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z +
+         2.0 * q[3] * x + q[4] * y * y + 2.0 * q[5] * y * z +
+         2.0 * q[6] * y + q[7] * z * z + 2.0 * q[8] * z + q[9];
+}
+
+} // namespace anshub
@@ -0,0 +1,108 @@
+// *************************************************************
+// File:    gl_lods.h
+// Descr:   levels of detail of objects
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef GC_GL_LODS_H
+#define GC_GL_LODS_H
+
+#include <vector>
+#include <array>
+#include <queue>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "lib/render/gl_aliases.h"
+#include "lib/render/gl_face.h"
+#include "lib/render/gl_object.h"
+#include "lib/render/gl_clusters.h"
+#include "lib/render/cameras/gl_camera.h"
+
+#include "lib/math/vector.h"
+
+namespace anshub {
+
+//****************************************************************************
+// Helper functions to make levels of detail of object and to choose level
+// by projected size of object (see note #1)
+//****************************************************************************
+
+namespace lods {
+
+  constexpr int   kLevels {4};          // full mesh and 3 simplified levels
+  constexpr float kFullSize {256.0f};   // min projected size of full mesh
+  constexpr float kHysteresis {0.15f};  // part of size to keep current level
+
+  void  Make(GlObject&, int levels = kLevels);
+  bool  Load(GlObject&, const std::string& fname);
+  bool  Save(const GlObject&, const std::string& fname);
+  void  Set(GlObject&, int level);
+  int   Select(const GlCamera&, cVector& pos, float rad, int curr, int levels);
+
+} // namespace lods
+
+namespace lods_helpers {
+
+  using Quadric = std::array<double, 10>;
+
+  constexpr float kBorderWeight {10.0f};  // weight of border edges planes
+  constexpr float kMinCos {0.2f};         // max turn of face while collapse
+
+  VV_Face Simplify(V_Vertex&, cV_Face&, int levels);
+  Face    MakeFace(V_Vertex&, int f1, int f2, int f3);
+  MeshLod MakeLevel(V_Vertex&, V_Face&& faces);
+  std::uint64_t ComputeHash(cV_Vertex&, cV_Face&);
+  void    AddPlane(Quadric&, cVector& normal, cVector& point, float weight);
+  double  ComputeError(const Quadric&, const Quadric&, cVector&);
+  int     LevelBySize(float size, int levels);
+
+} // namespace lods_helpers
+
+//****************************************************************************
+// Inline implementation
+//****************************************************************************
+
+// Makes face as load_helpers::MakeFaces() does
+
+inline Face lods_helpers::MakeFace(V_Vertex& vxs, int f1, int f2, int f3)
+{
+  Face face {vxs, f1, f2, f3};
+  face.color_ = vxs[f1].color_;
+  return face;
+}
+
+// Returns level of detail for object with given projected size (in pixels)
+
+inline int lods_helpers::LevelBySize(float size, int levels)
+{
+  int level {0};
+  float limit {lods::kFullSize};
+  while (level + 1 < levels && size < limit)
+  {
+    ++level;
+    limit *= 0.5f;
+  }
+  return level;
+}
+
+}  // namespace anshub
+
+#endif  // GC_GL_LODS_H
+
+// Note #1 : levels are made once by Make() (or loaded by Load() from the
+//  cache file made by Save()). Simplified meshes are made by collapses of
+//  edges with the least quadric error, where one vertex of edge is moved
+//  into another one. Thus levels are only lists of faces which refer to the
+//  same vertices of object (textures coordinates and colors are kept), and
+//  Set() switches level by swap of faces (and data computed by them) between
+//  object and lods_. Level 0 is the original mesh, each next level has about
+//  half of faces of previous. Select() chooses level by projected size of
+//  bounding sphere, and keeps current level while size is near the limit.
+//  Cache file keeps hash of positions of vertices and of faces of level 0,
+//  thus the cache is made again if source mesh was changed
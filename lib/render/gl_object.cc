@@ -13,6 +13,11 @@ GlObject::GlObject()
   , vxs_trans_{}
   , current_vxs_{Coords::LOCAL}
   , faces_{}
+  , normals_local_{}
+  , clusters_{}
+  , edges_{}
+  , lods_{}
+  , lod_{0}
   , textures_{}
   , mipmaps_squares_{}
   , active_{true}
@@ -24,6 +29,9 @@ GlObject::GlObject()
   , v_orient_z_{0.0f, 0.0f, 1.0f}
   , sphere_rad_{0.0f}  
   , aux_flags_{AuxFlags::NONE}
+  , reflection_{nullptr}
+  , streams_local_{}
+  , streams_trans_{}
 { }
 
 GlObject::GlObject(const std::string& ply_fname, cVector& world_pos)
@@ -31,6 +39,11 @@ GlObject::GlObject(const std::string& ply_fname, cVector& world_pos)
   , vxs_trans_{}
   , current_vxs_{Coords::LOCAL}  
   , faces_{}
+  , normals_local_{}
+  , clusters_{}
+  , edges_{}
+  , lods_{}
+  , lod_{0}
   , textures_{}
   , mipmaps_squares_{}  
   , active_{true}
@@ -42,6 +55,9 @@ GlObject::GlObject(const std::string& ply_fname, cVector& world_pos)
   , v_orient_z_{0.0f, 0.0f, 1.0f}
   , sphere_rad_{0.0f}
   , aux_flags_{AuxFlags::NONE}
+  , reflection_{nullptr}
+  , streams_local_{}
+  , streams_trans_{}
 {
   // Load data from file and fill object
 
@@ -54,6 +70,7 @@ GlObject::GlObject(const std::string& ply_fname, cVector& world_pos)
   
   vxs_local_ = load_helpers::MakeVertices(coords, colors);
   faces_ = load_helpers::MakeFaces(vxs_local_, faces);
+  edges_ = object::ComputeEdges(faces_);
 
   // Load textures
 
@@ -72,9 +89,8 @@ GlObject::GlObject(const std::string& ply_fname, cVector& world_pos)
 
   vxs_trans_ = vxs_local_;
   shading_ = attrs.shading_;
-  sphere_rad_ = object::FindFarthestCoordinate(vxs_local_);
+  sphere_rad_ = object::ComputeBoundingRadius(vxs_local_);
 
-  // todo: sphere_rad_ = object::ComputeBoundingSphereRadius(vxs_local_, Axis::XYZ);
   // todo: + bounding_box
 }
 
@@ -83,9 +99,32 @@ GlObject::GlObject(const std::string& ply_fname, cVector& world_pos)
 void GlObject::CopyCoords(Coords src, Coords dest)
 {
   if (src == Coords::LOCAL && dest == Coords::TRANS)
-    vxs_trans_ = vxs_local_;
+  {
+    if (!IsStreamed())
+    {
+      vxs_trans_ = vxs_local_;
+      return;
+    }
+
+    // Positions and normals are in streams (see note #1 in header)
+
+    streams_trans_ = streams_local_;
+    vxs_trans_.resize(vxs_local_.size());
+    for (std::size_t i = 0; i < vxs_local_.size(); ++i)
+    {
+      vxs_trans_[i].color_ = vxs_local_[i].color_;
+      vxs_trans_[i].texture_ = vxs_local_[i].texture_;
+    }
+  }
   else if (src == Coords::TRANS && dest == Coords::LOCAL)
+  {
     vxs_local_ = vxs_trans_;
+    if (IsStreamed())
+    {
+      streams_local_ = streams_trans_;
+      streams::Scatter(streams_local_, vxs_local_);
+    }
+  }
 }
 
 // Loads ply file and returns Loader struct
@@ -402,6 +441,20 @@ void object::ResetAttributes(GlObject& obj)
   obj.aux_flags_ = AuxFlags::NONE;
 }
 
+// Clears data computed by local vertices (normals and clusters of faces of
+// all levels of detail). Should be called when local vertices are changed
+
+void object::ResetLocalData(GlObject& obj)
+{
+  obj.normals_local_.clear();
+  obj.clusters_.clear();
+  for (auto& lod : obj.lods_)
+  {
+    lod.normals_local_.clear();
+    lod.clusters_.clear();
+  }
+}
+
 // Refresh face normals (for lighting purposes we should call this function
 // in world coordinates). Normals are not normalized
 
@@ -445,6 +498,89 @@ void object::ComputeFaceNormalsInv(GlObject& obj, bool normalize)
   }
 }
 
+// Computes normalized faces normals in local coords (see note #3 in header)
+
+void object::ComputeLocalNormals(GlObject& obj)
+{
+  auto& vxs = obj.vxs_local_;
+  obj.normals_local_.resize(obj.faces_.size());
+
+  for (std::size_t i = 0; i < obj.faces_.size(); ++i)
+  {
+    auto& face = obj.faces_[i];
+    Vector u {vxs[face[0]].pos_, vxs[face[1]].pos_};
+    Vector v {vxs[face[0]].pos_, vxs[face[2]].pos_};
+    obj.normals_local_[i] = vector::CrossProduct(u, v);
+    if (!obj.normals_local_[i].IsZero())
+      obj.normals_local_[i].Normalize();
+  }
+}
+
+// Recomputes local normals only of faces which use marked vertices (i.e.
+// after some local vertices are moved)
+
+void object::ComputeLocalNormals(GlObject& obj, const V_Uchar& marks)
+{
+  if (obj.normals_local_.size() != obj.faces_.size())
+  {
+    object::ComputeLocalNormals(obj);
+    return;
+  }
+
+  auto& vxs = obj.vxs_local_;
+  for (std::size_t i = 0; i < obj.faces_.size(); ++i)
+  {
+    auto& face = obj.faces_[i];
+    if (!marks[face[0]] && !marks[face[1]] && !marks[face[2]])
+      continue;
+    Vector u {vxs[face[0]].pos_, vxs[face[1]].pos_};
+    Vector v {vxs[face[0]].pos_, vxs[face[2]].pos_};
+    obj.normals_local_[i] = vector::CrossProduct(u, v);
+    if (!obj.normals_local_[i].IsZero())
+      obj.normals_local_[i].Normalize();
+  }
+}
+
+// Sets normals of active faces from local normals, which are computed only
+// if they are absent. Object should be moved to the world only by its world
+// position
+
+void object::RefreshFaceNormals(GlObject& obj)
+{
+  if (!obj.active_) return;
+
+  if (obj.normals_local_.size() != obj.faces_.size())
+    object::ComputeLocalNormals(obj);
+
+  for (std::size_t i = 0; i < obj.faces_.size(); ++i)
+  {
+    auto& face = obj.faces_[i];
+    if (face.active_)
+      face.normal_ = obj.normals_local_[i];
+  }
+}
+
+// The same as above, but object is rotated too. Rotation is given by the
+// orientation vectors (images of local x, y and z axes)
+
+void object::RefreshFaceNormals(
+  GlObject& obj, cVector& ox, cVector& oy, cVector& oz)
+{
+  if (!obj.active_) return;
+
+  if (obj.normals_local_.size() != obj.faces_.size())
+    object::ComputeLocalNormals(obj);
+
+  for (std::size_t i = 0; i < obj.faces_.size(); ++i)
+  {
+    auto& face = obj.faces_[i];
+    if (!face.active_)
+      continue;
+    cVector& n = obj.normals_local_[i];
+    face.normal_ = ox * n.x + oy * n.y + oz * n.z;
+  }
+}
+
 // Compute vertexes normals, using quick method (sometimes innacurate, since
 // doesn`t respects to similar faces, like in the case with cube). Computing
 // process: compute non-normalized face normals, lenghts of this normals would
@@ -568,10 +704,9 @@ bool object::Cull(GlObject& obj, const GlCamera& cam, const MatrixCamera& mx)
     obj.active_ = false;  
 
   // Cull y planes (project point on the view plane and check)
-  //  todo : here I forgot to use ar
 
-  float y_dhs = (cam.dov_ * (obj_pos.y + obj.sphere_rad_) / obj_pos.z);
-  float y_uhs = (cam.dov_ * (obj_pos.y - obj.sphere_rad_) / obj_pos.z);
+  float y_dhs = (cam.dov_ * cam.ar_ * (obj_pos.y + obj.sphere_rad_) / obj_pos.z);
+  float y_uhs = (cam.dov_ * cam.ar_ * (obj_pos.y - obj.sphere_rad_) / obj_pos.z);
 
   if (y_dhs < -(cam.wov_ / 2))
     obj.active_ = false;  
@@ -614,10 +749,9 @@ bool object::Cull(GlObject& obj, const GlCamera& cam, cTrigTable& trig)
     obj.active_ = false;  
 
   // Cull y planes (project point on the view plane and check)
-  //  todo : need to use ar here (missed occidentialy)
 
-  float y_dhs = (cam.dov_ * (obj_pos.y + obj.sphere_rad_) / obj_pos.z);
-  float y_uhs = (cam.dov_ * (obj_pos.y - obj.sphere_rad_) / obj_pos.z);
+  float y_dhs = (cam.dov_ * cam.ar_ * (obj_pos.y + obj.sphere_rad_) / obj_pos.z);
+  float y_uhs = (cam.dov_ * cam.ar_ * (obj_pos.y - obj.sphere_rad_) / obj_pos.z);
 
   if (y_dhs < -(cam.wov_ / 2))
     obj.active_ = false;
@@ -705,6 +839,17 @@ bool object::CullZ(GlObject& obj, const GlCamera& cam, const TrigTable& trig)
   return !obj.active_;
 }
 
+// Returns true if bounding sphere of object touches near_z plane, i.e.
+// some vertices may be behind the camera (see note #2 in header)
+
+bool object::CrossesNearZ(
+  const GlObject& obj, const GlCamera& cam, const TrigTable& trig)
+{
+  Vector obj_pos {obj.world_pos_};
+  coords::World2Camera(obj_pos, cam.vrp_, cam.dir_, trig);
+  return obj_pos.z - obj.sphere_rad_ <= cam.z_near_;
+}
+
 // Removes hidden surfaces in camera coordinates
 
 // This function may be called between world and camera coordinates,
@@ -726,7 +871,10 @@ int object::RemoveHiddenSurfaces(GlObject& obj, const GlCamera& cam)
   auto& vxs = obj.GetCoords();
 
   for (auto& face : obj.faces_)
-  {    
+  {
+    if (!face.active_)
+      continue;
+
     // Compute face normal if it is absent
 
     if (face.normal_.IsZero())
@@ -756,10 +904,73 @@ int object::RemoveHiddenSurfaces(GlObject& obj, const GlCamera& cam)
   return cnt;
 }
 
+// Removes faces which are invisible from the camera position in local coords
+// of object, before vertices are transformed (see note #3 in header). Object
+// should be moved to the world only by its world position
+
+int object::RemoveHiddenSurfacesLocal(GlObject& obj, const GlCamera& cam)
+{
+  return RemoveHiddenSurfacesLocal(obj, cam.vrp_ - obj.world_pos_);
+}
+
+// The same as above, but camera position is given in local coords
+
+int object::RemoveHiddenSurfacesLocal(GlObject& obj, cVector& cam_pos)
+{
+  int cnt {0};
+  if (!obj.active_) return cnt;
+
+  if (obj.normals_local_.size() != obj.faces_.size())
+    object::ComputeLocalNormals(obj);
+
+  auto& vxs = obj.vxs_local_;
+
+  for (std::size_t i = 0; i < obj.faces_.size(); ++i)
+  {
+    auto& face = obj.faces_[i];
+    if (!face.active_)
+      continue;
+    Vector view {vxs[face[0]].pos_, cam_pos};
+    if (vector::DotProduct(view, obj.normals_local_[i]) < 0.0f)
+    {
+      face.active_ = false;
+      ++cnt;
+    }
+  }
+  return cnt;
+}
+
+// Culls faces of object by clusters (see note #4 in header). Object should
+// be moved to the world only by its world position. Returns count of culled
+// faces
+
+int object::CullClusters(GlObject& obj, const GlCamera& cam)
+{
+  if (!obj.active_)
+    return 0;
+  if (obj.clusters_.empty())
+    object::MakeClusters(obj);
+  return clusters::Cull(obj.clusters_, obj.faces_, cam, obj.world_pos_);
+}
+
+// Sorts faces of current level of detail to make clusters compact and makes
+// clusters. Edges and local normals refer to faces numbers, thus edges are
+// recomputed and normals are cleared (see note #4 in header)
+
+void object::MakeClusters(GlObject& obj)
+{
+  clusters::SortFaces(obj.vxs_local_, obj.faces_);
+  obj.edges_ = object::ComputeEdges(obj.faces_);
+  obj.normals_local_.clear();
+  obj.clusters_ = clusters::Make(obj.vxs_local_, obj.faces_);
+}
+
 // Apply matrix to object
 
 void object::ApplyMatrix(const Matrix<4,4>& mx, GlObject& obj)
 {
+  if (obj.current_vxs_ == Coords::LOCAL)
+    object::ResetLocalData(obj);
   auto& vxs = obj.GetCoords();
   for (auto& vx : vxs)
     vx.pos_ = matrix::Multiplie(vx.pos_, mx);
@@ -769,27 +980,91 @@ void object::ApplyMatrix(const Matrix<4,4>& mx, GlObject& obj)
 
 void object::World2Camera(GlObject& obj, const GlCamera& cam, cTrigTable& trig)
 {
+  if (obj.IsStreamed())
+  {
+    streams::World2Camera(obj.GetStreams(), cam.vrp_, cam.dir_, trig);
+    return;
+  }
+
   auto& vxs = obj.GetCoords();
   coords::World2Camera(vxs, cam.vrp_, cam.dir_, trig);
 }
 
 void object::Camera2Persp(GlObject& obj, const GlCamera& cam)
 {
+  if (obj.IsStreamed())
+  {
+    streams::Camera2Persp(obj.GetStreams(), cam.dov_, cam.ar_);
+    return;
+  }
+
   auto& vxs = obj.GetCoords();
   coords::Camera2Persp(vxs, cam.dov_, cam.ar_);
 }
 
 void object::Persp2Screen(GlObject& obj, const GlCamera& cam)
 {
+  if (obj.IsStreamed())
+  {
+    streams::Persp2Screen(obj.GetStreams(), cam.wov_, cam.scr_w_, cam.scr_h_);
+    return;
+  }
+
   auto& vxs = obj.GetCoords();
   coords::Persp2Screen(vxs, cam.wov_, cam.scr_w_, cam.scr_h_);
 }
 
+// Composes model, camera, perspective and screen matrices to transform
+// vertices by one matrix (see note #2 in header)
+
+Matrix<4,4> object::MakeMvpMatrix(
+  const Matrix<4,4>& model, const GlCamera& cam, cTrigTable& trig)
+{
+  MatrixCamera      mx_cam {
+    coords::World2CameraMatrix(cam.vrp_, cam.dir_, trig)};
+  MatrixPerspective mx_per {cam.dov_, cam.ar_};
+  MatrixScreen      mx_scr {cam.wov_, cam.scr_w_, cam.scr_h_};
+
+  Matrix<4,4> mx {};
+  mx = matrix::Multiplie(model, mx_cam);
+  mx = matrix::Multiplie(mx, mx_per);
+  mx = matrix::Multiplie(mx, mx_scr);
+  return mx;
+}
+
+// Transforms vertices of object by composed matrix and makes perspective
+// divide in one pass. Object should be in front of near_z plane
+
+void object::Project(GlObject& obj, const Matrix<4,4>& mx)
+{
+  if (obj.IsStreamed())
+  {
+    streams::Project(obj.GetStreams(), mx, obj.GetCoords());
+    return;
+  }
+
+  auto& vxs = obj.GetCoords();
+  for (auto& vx : vxs)
+  {
+    cVector p {vx.pos_};
+    float w = p.x * mx(0,3) + p.y * mx(1,3) + p.z * mx(2,3) + mx(3,3);
+    vx.pos_.x = (p.x * mx(0,0) + p.y * mx(1,0) + p.z * mx(2,0) + mx(3,0)) / w;
+    vx.pos_.y = (p.x * mx(0,1) + p.y * mx(1,1) + p.z * mx(2,1) + mx(3,1)) / w;
+    vx.pos_.z = p.x * mx(0,2) + p.y * mx(1,2) + p.z * mx(2,2) + mx(3,2);
+  }
+}
+
 // Convert vertices normals to camera coordinates
 
 void object::VerticesNormals2Camera(
   GlObject& obj, const GlCamera& cam, cTrigTable& trig)
 {
+  if (obj.IsStreamed())
+  {
+    streams::Normals2Camera(obj.GetStreams(), cam.dir_, trig);
+    return;
+  }
+
   auto& vxs = obj.GetCoords();
 
   for (auto& vx : vxs) {
@@ -800,10 +1075,29 @@ void object::VerticesNormals2Camera(
   }
 }
 
+// Makes streams of object from its local vertices. Should be called again
+// if local vertices are changed not by object:: transforms
+
+void object::MakeStreams(GlObject& obj)
+{
+  streams::Gather(obj.vxs_local_, obj.streams_local_);
+  obj.streams_trans_ = obj.streams_local_;
+}
+
+// Copies positions and normals from streams to vertices of current coords
+
+void object::SyncStreams(GlObject& obj)
+{
+  if (obj.IsStreamed())
+    streams::Scatter(obj.GetStreams(), obj.GetCoords());
+}
+
 // Scale object and recalc bounding radius
 
 void object::Scale(GlObject& obj, const Vector& scale)
 {
+  if (obj.current_vxs_ == Coords::LOCAL)
+    object::ResetLocalData(obj);
   auto& vxs = obj.GetCoords();
   for (auto& vx : vxs)
   {
@@ -811,7 +1105,7 @@ void object::Scale(GlObject& obj, const Vector& scale)
     vx.pos_.y *= scale.y;
     vx.pos_.z *= scale.z;
   }
-  obj.sphere_rad_ = object::FindFarthestCoordinate(obj);
+  obj.sphere_rad_ = object::ComputeBoundingRadius(vxs);
 }
 
 // Set world position of center of object
@@ -825,16 +1119,57 @@ void object::Move(GlObject& obj, const Vector& pos)
 
 void object::Translate(GlObject& obj, const Vector& pos)
 {
+  if (obj.IsStreamed())
+  {
+    streams::Translate(obj.GetStreams(), pos);
+    return;
+  }
+
   auto& vxs = obj.GetCoords();
   for (auto& vx : vxs)
     vx.pos_ += pos;
 }
 
+// Copies local vertices of active faces to transformed coords and moves
+// them by world position of object. Other transformed vertices are out of
+// date. Marks is scratch array of vertices flags
+
+void object::TranslateVisible(GlObject& obj, V_Uchar& marks)
+{
+  obj.SetCoords(Coords::TRANS);
+  if (obj.IsStreamed())
+  {
+    obj.CopyCoords(Coords::LOCAL, Coords::TRANS);
+    object::Translate(obj, obj.world_pos_);
+    return;
+  }
+
+  auto& src = obj.vxs_local_;
+  auto& dst = obj.vxs_trans_;
+  dst.resize(src.size());
+  marks.assign(src.size(), 0);
+  for (const auto& face : obj.faces_)
+  {
+    if (face.active_)
+      marks[face[0]] = marks[face[1]] = marks[face[2]] = 1;
+  }
+
+  for (std::size_t i = 0; i < src.size(); ++i)
+  {
+    if (!marks[i])
+      continue;
+    dst[i] = src[i];
+    dst[i].pos_ += obj.world_pos_;
+  }
+}
+
 // Rotate object in YXZ sequence by rotating each vector relative to
 // the origin
 
 void object::Rotate(GlObject& obj, const Vector& v, const TrigTable& t)
 {
+  if (obj.current_vxs_ == Coords::LOCAL)
+    object::ResetLocalData(obj);
   auto& vxs = obj.GetCoords();
   if (math::FNotZero(v.y))
   {
@@ -894,6 +1229,17 @@ float object::FindFarthestCoordinate(cV_Vertex& vxs)
   return rad;
 }
 
+// Returns radius of bounding sphere with the center in the origin of local
+// coordinates (the greatest distance to vertex)
+
+float object::ComputeBoundingRadius(cV_Vertex& vxs)
+{
+  float rad {};
+  for (const auto& vx : vxs)
+    rad = std::max(rad, vx.pos_.SquareLength());
+  return std::sqrt(rad);
+}
+
 // Refresh object orientation when rotates. This should be used near
 // the apply rotate matrix to all vertexes (or in hand mode)
 
@@ -997,6 +1343,54 @@ float object::ComputeBoundingSphereRadius(V_Vertex& vxs, Axis axis)
   return res;
 }
 
+// Makes list of unique edges of faces, where each shared edge is stored
+// once with both faces
+
+V_MeshEdge object::ComputeEdges(cV_Face& faces)
+{
+  V_MeshEdge edges {};
+  std::map<std::pair<int,int>, int> found {};
+
+  for (std::size_t i = 0; i < faces.size(); ++i)
+  {
+    for (int k = 0; k < 3; ++k)
+    {
+      int v1 = faces[i][k];
+      int v2 = faces[i][(k + 1) % 3];
+      auto key = std::make_pair(std::min(v1, v2), std::max(v1, v2));
+      auto it = found.find(key);
+      if (it == found.end())
+      {
+        found.emplace(key, edges.size());
+        edges.push_back(MeshEdge{v1, v2, static_cast<int>(i), -1});
+      }
+      else if (edges[it->second].face_2_ < 0)
+        edges[it->second].face_2_ = i;
+    }
+  }
+  return edges;
+}
+
+// Returns quad half of the face if its pair is active too, otherwise returns
+// Quad::NONE (thus the pair of triangle made from the face is always its
+// neighbour in triangles array)
+
+Quad object::ActiveQuadHalf(cV_Face& faces, int face_num)
+{
+  auto& face = faces[face_num];
+  if (face.quad_ == Quad::FIRST)
+  {
+    if (face_num + 1 < (int)faces.size() && faces[face_num + 1].active_)
+      return Quad::FIRST;
+  }
+  else if (face.quad_ == Quad::SECOND)
+  {
+    if (face_num > 0 && faces[face_num - 1].active_)
+      return Quad::SECOND;
+  }
+  return Quad::NONE;
+}
+
 // Computes drawable vertexes normals in world coordinates relative to vertex
 // of object
 
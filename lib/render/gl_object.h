@@ -9,6 +9,7 @@
 
 #include <vector>
 #include <array>
+#include <map>
 #include <fstream>
 #include <memory>
 
@@ -18,6 +19,9 @@
 #include "fx_colors.h"
 #include "gl_coords.h"
 #include "gl_face.h"
+#include "gl_clusters.h"
+#include "gl_scr_buffer.h"
+#include "gl_vx_streams.h"
 #include "cameras/gl_camera.h"
 
 #include "lib/data/ply_loader.h"
@@ -32,6 +36,8 @@
 #include "lib/math/matrix.h"
 #include "lib/math/matrices/mx_rotate_eul.h"
 #include "lib/math/matrices/mx_camera.h"
+#include "lib/math/matrices/mx_perspective.h"
+#include "lib/math/matrices/mx_screen.h"
 
 namespace anshub {
 
@@ -45,6 +51,11 @@ struct GlObject
   V_Vertex  vxs_trans_;       // transformed vertices
   Coords    current_vxs_;     // chooser between coords type
   V_Face    faces_;           // faces based on coords above
+  V_Vector  normals_local_;   // faces normals in local coords (see note #3)
+  V_MeshCluster clusters_;    // clusters of faces in local coords (note #4)
+  V_MeshEdge edges_;          // unique edges of faces (for wired mode)
+  V_MeshLod lods_;            // levels of detail (see gl_lods.h)
+  int       lod_;             // current level of detail
   V_Bitmap  textures_;
   V_Uint    mipmaps_squares_;
 
@@ -57,6 +68,9 @@ struct GlObject
   Vector    v_orient_z_;      //
   float     sphere_rad_;      // bounding sphere radius
   AuxFlags  aux_flags_;       // auxilary flags  
+  const ScrBuffer* reflection_; // mirror image sampled in screen space
+  VxStreams streams_local_;   // positions and normals in soa layout, used
+  VxStreams streams_trans_;   // by transforms if not empty (see note #1)
 
   GlObject();
   GlObject(const std::string& fname, cVector& world_pos_);
@@ -70,6 +84,8 @@ struct GlObject
   virtual void CopyCoords(Coords src, Coords dest);
   auto& GetCoords();
   auto& GetCoords() const;
+  auto& GetStreams();
+  bool  IsStreamed() const { return !streams_local_.Empty(); }
 
 }; // struct Object
 
@@ -105,6 +121,10 @@ struct ObjAttrs
     return (current_vxs_ == Coords::LOCAL) ? vxs_local_ : vxs_trans_;
   }
 
+  inline auto& GlObject::GetStreams() {
+    return (current_vxs_ == Coords::LOCAL) ? streams_local_ : streams_trans_;
+  }
+
 //***********************************************************************
 // Helper functions to load object
 //***********************************************************************
@@ -150,10 +170,20 @@ namespace object {
   bool  CullX(GlObject&, const GlCamera&, const TrigTable&);  
   bool  CullY(GlObject&, const GlCamera&, const TrigTable&);  
   bool  CullZ(GlObject&, const GlCamera&, const TrigTable&);  
+  bool  CrossesNearZ(const GlObject&, const GlCamera&, const TrigTable&);
   int   RemoveHiddenSurfaces(GlObject&, const GlCamera&);
+  int   RemoveHiddenSurfacesLocal(GlObject&, const GlCamera&);
+  int   RemoveHiddenSurfacesLocal(GlObject&, cVector& cam_pos);
+  int   CullClusters(GlObject&, const GlCamera&);
+  void  MakeClusters(GlObject&);
   void  ResetAttributes(GlObject&);
+  void  ResetLocalData(GlObject&);
   void  ComputeFaceNormals(GlObject&, bool normalize = true);
   void  ComputeFaceNormalsInv(GlObject&, bool normalize = true);
+  void  ComputeLocalNormals(GlObject&);
+  void  ComputeLocalNormals(GlObject&, const V_Uchar& marks);
+  void  RefreshFaceNormals(GlObject&);
+  void  RefreshFaceNormals(GlObject&, cVector& ox, cVector& oy, cVector& oz);
   void  ComputeVertexNormalsV1(GlObject&);
   void  ComputeVertexNormalsV2(GlObject&);
   bool  GetAuxFlag(GlObject&, AuxFlags);
@@ -164,6 +194,7 @@ namespace object {
   void  Scale(GlObject&, const Vector&);
   void  Move(GlObject&, const Vector&);
   void  Translate(GlObject&, const Vector&);
+  void  TranslateVisible(GlObject&, V_Uchar& marks);
   void  Rotate(GlObject&, const Vector&, const TrigTable&);
   void  ApplyMatrix(const Matrix<4,4>&, GlObject&);
 
@@ -174,14 +205,25 @@ namespace object {
   void  Persp2Screen(GlObject&, const GlCamera&);
   void  Homogenous2Normal(GlObject&);
   void  VerticesNormals2Camera(GlObject&, const GlCamera&, cTrigTable&);
+  Matrix<4,4> MakeMvpMatrix(
+    const Matrix<4,4>& model, const GlCamera&, cTrigTable&);
+  void  Project(GlObject&, const Matrix<4,4>& mvp);
+
+  // Structure of arrays layout of positions and normals
+
+  void  MakeStreams(GlObject&);
+  void  SyncStreams(GlObject&);
 
   // Object helpers
 
   float FindFarthestCoordinate(const GlObject&);
   float FindFarthestCoordinate(cV_Vertex&);
+  float ComputeBoundingRadius(cV_Vertex&);
   void  RefreshOrientation(GlObject&, const MatrixRotateEul&);
   void  RefreshOrientationXYZ(GlObject&, const Vector& dir, TrigTable&);
   float ComputeBoundingSphereRadius(V_Vertex& vxs, Axis);
+  V_MeshEdge ComputeEdges(cV_Face&);
+  Quad  ActiveQuadHalf(cV_Face&, int face_num);
 
   // Debug purposes
 
@@ -254,4 +296,38 @@ inline void objects::Homogenous2Normal(V_GlObject& arr)
 
 } // namespace anshub
 
-#endif  // GC_GL_OBJECT_H
\ No newline at end of file
+#endif  // GC_GL_OBJECT_H
+
+// Note #1 : if object has streams (object::MakeStreams()), then positions and
+//  normals are transformed in streams by Translate(), World2Camera(),
+//  Camera2Persp(), Persp2Screen() and VerticesNormals2Camera(), and
+//  CopyCoords() copies streams and other attributes of vertices. Vertices
+//  positions and normals are out of date until object::SyncStreams() call
+
+// Note #2 : Project() transforms vertices from model to screen coordinates
+//  by one matrix and by one pass (model, camera, perspective and screen
+//  matrices are multiplied once per object by MakeMvpMatrix()). Screen z is
+//  the camera z (as after Camera2Persp()). Perspective divide is valid only
+//  for vertices in front of the camera, thus objects crossed by near_z plane
+//  (see CrossesNearZ()) should take usual way to be clipped
+
+// Note #3 : RemoveHiddenSurfaces() is called after vertices are moved to the
+//  world, thus vertices of back faces are transformed too. Since objects are
+//  only translated by world position (rotation and scale are applied to
+//  local vertices at load), camera position is moved to local coords instead,
+//  and faces are tested by normals computed once in local coords. Then
+//  TranslateVisible() transforms only vertices of the remaining faces.
+//  Normals are recomputed after Scale(), Rotate() or ApplyMatrix() of local
+//  coords (or if normals_local_ is cleared by hand). If only some vertices
+//  are moved, normals of faces which use them are recomputed by marks. Since
+//  normals are normalized, RefreshFaceNormals() gives world normals of
+//  active faces by copy (or by rotation for objects rotated every frame)
+//  instead of computing them by vertices
+
+// Note #4 : clusters are made in local coords on demand by CullClusters()
+//  (or by MeshCache for instanced meshes), and are cleared by the same
+//  functions as normals_local_. Faces are sorted to make clusters compact
+//  only there (see MakeClusters()), thus objects without clusters keep
+//  order of faces from the file. CullClusters() should be called after
+//  ResetAttributes() and before other culling functions, since they skip
+//  inactive faces
@@ -0,0 +1,262 @@
+// *************************************************************
+// File:    gl_occlusion.cc
+// Descr:   software occlusion culling by low resolution depth buffer
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#include "gl_occlusion.h"
+
+namespace anshub {
+
+// Clears buffer and takes camera of the current frame. Height of buffer is
+// chosen to keep pixels square
+
+void occlusion::Clear(OcclusionBuffer& buf, const GlCamera& cam)
+{
+  buf.height_ = std::max(1, buf.width_ * cam.scr_h_ / cam.scr_w_);
+  buf.depth_.assign(buf.width_ * buf.height_, 0.0f);
+
+  coords::World2CameraMatrix(cam.dir_, cam.trig_, buf.mx_);
+  buf.cam_pos_ = cam.vrp_;
+  buf.near_z_ = cam.z_near_;
+  buf.fx_ = cam.dov_ * buf.width_ / cam.wov_;
+  buf.fy_ = cam.dov_ * cam.ar_ * buf.height_ / cam.wov_;
+}
+
+// Rasterizes active faces into the buffer. Vertices should be in world
+// coordinates, and edges should be made from the faces (see note #1 in
+// header)
+
+void occlusion::AddOccluder(
+  OcclusionBuffer& buf, cV_Vertex& vxs, cV_Face& faces, const V_MeshEdge& edges)
+{
+  // Project vertices to the buffer (z is reciprocal of camera z or negative
+  // if vertex is behind near_z plane)
+
+  float half_w = buf.width_ / 2.0f;
+  float half_h = buf.height_ / 2.0f;
+  buf.proj_.resize(vxs.size());
+  for (std::size_t i = 0; i < vxs.size(); ++i)
+  {
+    Vector c = occlusion_helpers::World2Camera(buf, vxs[i].pos_);
+    auto& p = buf.proj_[i];
+    if (c.z < buf.near_z_)
+    {
+      p.z = -1.0f;
+      continue;
+    }
+    p.z = 1.0f / c.z;
+    p.x = half_w + c.x * p.z * buf.fx_;
+    p.y = half_h + c.y * p.z * buf.fy_;
+  }
+
+  // Mark edges of faces (bit k is edge from vertex k) shared by two active
+  // faces
+
+  buf.inner_.assign(faces.size(), 0);
+  for (const auto& edge : edges)
+  {
+    if (edge.face_2_ < 0 ||
+        !faces[edge.face_1_].active_ || !faces[edge.face_2_].active_)
+      continue;
+    for (int f : {edge.face_1_, edge.face_2_})
+    {
+      for (int k = 0; k < 3; ++k)
+      {
+        int v1 = faces[f][k];
+        int v2 = faces[f][(k + 1) % 3];
+        if ((v1 == edge.v1_ && v2 == edge.v2_) ||
+            (v1 == edge.v2_ && v2 == edge.v1_))
+          buf.inner_[f] |= 1 << k;
+      }
+    }
+  }
+
+  for (std::size_t i = 0; i < faces.size(); ++i)
+  {
+    const auto& face = faces[i];
+    if (!face.active_)
+      continue;
+
+    cVector& p1 = buf.proj_[face[0]];
+    cVector& p2 = buf.proj_[face[1]];
+    cVector& p3 = buf.proj_[face[2]];
+    if (p1.z > 0.0f && p2.z > 0.0f && p3.z > 0.0f)
+      occlusion_helpers::DrawTriangle(buf, p1, p2, p3, buf.inner_[i]);
+  }
+}
+
+// Returns true if bounding sphere (in world coordinates) is hidden by
+// occluders (see note #1 in header)
+
+bool occlusion::IsOccluded(
+  const OcclusionBuffer& buf, cVector& center, float rad)
+{
+  Vector c = occlusion_helpers::World2Camera(buf, center);
+  float nearest = c.z - rad;
+  if (nearest <= buf.near_z_)
+    return false;
+
+  // Each point of sphere differs from the center by (dx, dz), where length
+  // is not greater than rad, thus |x/z - cx/cz| is not greater than
+  // rad * sqrt(cx^2 + cz^2) / (cz * (cz - rad)) (the same for y)
+
+  float k = rad / (c.z * nearest);
+  float hx = k * std::sqrt(c.x * c.x + c.z * c.z) * buf.fx_;
+  float hy = k * std::sqrt(c.y * c.y + c.z * c.z) * buf.fy_;
+  float sx = buf.width_ / 2.0f + c.x / c.z * buf.fx_;
+  float sy = buf.height_ / 2.0f + c.y / c.z * buf.fy_;
+
+  int x1 = std::max(0, static_cast<int>(std::floor(sx - hx)));
+  int x2 = std::min(buf.width_ - 1, static_cast<int>(std::floor(sx + hx)));
+  int y1 = std::max(0, static_cast<int>(std::floor(sy - hy)));
+  int y2 = std::min(buf.height_ - 1, static_cast<int>(std::floor(sy + hy)));
+  if (x1 > x2 || y1 > y2)
+    return false;
+
+  // Object is visible if some pixel has no occluder nearer than the nearest
+  // point of sphere
+
+  __m128 limit = _mm_set1_ps(1.0f / nearest);
+  x1 &= ~3;
+  for (int y = y1; y <= y2; ++y)
+  {
+    const float* row = &buf.depth_[y * buf.width_];
+    for (int x = x1; x <= x2; x += 4)
+    {
+      if (_mm_movemask_ps(_mm_cmple_ps(_mm_load_ps(row + x), limit)))
+        return false;
+    }
+  }
+  return true;
+}
+
+// Marks visible spheres, which are hidden by occluders, as invisible (then
+// result may be applied to objects by spheres::Apply()). Returns count of
+// occluded spheres
+
+int occlusion::Cull(const OcclusionBuffer& buf, BoundingSpheres& s)
+{
+  int cnt {0};
+  for (int i = 0; i < s.size_; ++i)
+  {
+    if (!s.visible_[i])
+      continue;
+    if (IsOccluded(buf, Vector{s.x_[i], s.y_[i], s.z_[i]}, s.rad_[i]))
+    {
+      s.visible_[i] = 0;
+      ++cnt;
+    }
+  }
+  return cnt;
+}
+
+// Rasterizes triangle (x and y are in pixels, z is reciprocal of camera z)
+// by 4 pixels per step. Bits of inner mark edges shared with other faces,
+// the rest edges are moved inside to cover only pixels which are inside
+// entirely. Pixel gets the least z of the plane of triangle in it, since
+// reciprocal of z is linear in screen space (see note #1 in header)
+
+void occlusion_helpers::DrawTriangle(
+  OcclusionBuffer& buf, cVector& p1, cVector& p2, cVector& p3, uchar inner)
+{
+  float area = (p2.x - p1.x) * (p3.y - p1.y) - (p3.x - p1.x) * (p2.y - p1.y);
+  if (std::abs(area) < 1e-6f)
+    return;
+
+  // Bounds of pixels which centers are inside of bounding box of triangle
+
+  float min_x = std::min({p1.x, p2.x, p3.x});
+  float max_x = std::max({p1.x, p2.x, p3.x});
+  float min_y = std::min({p1.y, p2.y, p3.y});
+  float max_y = std::max({p1.y, p2.y, p3.y});
+  int x1 = std::max(0, static_cast<int>(std::ceil(min_x - 0.5f)));
+  int y1 = std::max(0, static_cast<int>(std::ceil(min_y - 0.5f)));
+  int x2 = static_cast<int>(std::floor(max_x - 0.5f));
+  int y2 = static_cast<int>(std::floor(max_y - 0.5f));
+  x2 = std::min(buf.width_ - 1, x2);
+  y2 = std::min(buf.height_ - 1, y2);
+  if (x1 > x2 || y1 > y2)
+    return;
+
+  // Edge functions a * x + b * y + c are not negative inside of triangle
+  // (for both windings). Outline edges are moved inside by the half of
+  // pixel, thus the function is not negative in the center of pixel only if
+  // it is not negative in all corners of it
+
+  float sign = area > 0.0f ? 1.0f : -1.0f;
+  cVector* vxs[3] {&p1, &p2, &p3};
+  float a[3], b[3], c[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    cVector& v1 = *vxs[i];
+    cVector& v2 = *vxs[(i + 1) % 3];
+    a[i] = (v1.y - v2.y) * sign;
+    b[i] = (v2.x - v1.x) * sign;
+    c[i] = -(a[i] * v1.x + b[i] * v1.y);
+    if (!(inner & (1 << i)))
+      c[i] -= 0.5f * (std::abs(a[i]) + std::abs(b[i]));
+  }
+
+  // Plane of z: z = dx * x + dy * y + dc, where dc is lowered to give the
+  // least z in the pixel by its center
+
+  float dz2 = p2.z - p1.z;
+  float dz3 = p3.z - p1.z;
+  float dx = (dz2 * (p3.y - p1.y) - dz3 * (p2.y - p1.y)) / area;
+  float dy = (dz3 * (p2.x - p1.x) - dz2 * (p3.x - p1.x)) / area;
+  float dc = p1.z - dx * p1.x - dy * p1.y;
+  dc -= 0.5f * (std::abs(dx) + std::abs(dy));
+
+  __m128 ea[3], eb[3], ec[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    ea[i] = _mm_set1_ps(a[i]);
+    eb[i] = _mm_set1_ps(b[i]);
+    ec[i] = _mm_set1_ps(c[i]);
+  }
+  __m128 zdx = _mm_set1_ps(dx);
+  __m128 zdy = _mm_set1_ps(dy);
+  __m128 zdc = _mm_set1_ps(dc);
+  __m128 four = _mm_set1_ps(4.0f);
+  __m128 zero = _mm_setzero_ps();
+
+  // Rows are started from aligned pixel, pixels out of bounds are out of
+  // the triangle too
+
+  x1 &= ~3;
+  __m128 xs0 = _mm_add_ps(
+    _mm_set1_ps(static_cast<float>(x1)), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+
+  for (int y = y1; y <= y2; ++y)
+  {
+    __m128 yc = _mm_set1_ps(y + 0.5f);
+    __m128 xs = xs0;
+    __m128 r0 = _mm_add_ps(_mm_mul_ps(eb[0], yc), ec[0]);
+    __m128 r1 = _mm_add_ps(_mm_mul_ps(eb[1], yc), ec[1]);
+    __m128 r2 = _mm_add_ps(_mm_mul_ps(eb[2], yc), ec[2]);
+    __m128 rz = _mm_add_ps(_mm_mul_ps(zdy, yc), zdc);
+    float* row = &buf.depth_[y * buf.width_];
+
+    for (int x = x1; x <= x2; x += 4)
+    {
+      __m128 e0 = _mm_add_ps(_mm_mul_ps(ea[0], xs), r0);
+      __m128 e1 = _mm_add_ps(_mm_mul_ps(ea[1], xs), r1);
+      __m128 e2 = _mm_add_ps(_mm_mul_ps(ea[2], xs), r2);
+      __m128 inside = _mm_and_ps(_mm_cmpge_ps(e0, zero),
+        _mm_and_ps(_mm_cmpge_ps(e1, zero), _mm_cmpge_ps(e2, zero)));
+
+      if (_mm_movemask_ps(inside))
+      {
+        __m128 z = _mm_add_ps(_mm_mul_ps(zdx, xs), rz);
+        __m128 old = _mm_load_ps(row + x);
+        __m128 res = _mm_or_ps(_mm_and_ps(inside, _mm_max_ps(old, z)),
+                               _mm_andnot_ps(inside, old));
+        _mm_store_ps(row + x, res);
+      }
+      xs = _mm_add_ps(xs, four);
+    }
+  }
+}
+
+} // namespace anshub
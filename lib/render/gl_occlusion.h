@@ -0,0 +1,117 @@
+// *************************************************************
+// File:    gl_occlusion.h
+// Descr:   software occlusion culling by low resolution depth buffer
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef GC_GL_OCCLUSION_H
+#define GC_GL_OCCLUSION_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <xmmintrin.h>
+
+#include "lib/render/gl_aliases.h"
+#include "lib/render/gl_vertex.h"
+#include "lib/render/gl_face.h"
+#include "lib/render/gl_coords.h"
+#include "lib/render/gl_spheres.h"
+#include "lib/render/gl_vx_streams.h"
+#include "lib/render/cameras/gl_camera.h"
+
+#include "lib/math/vector.h"
+
+namespace anshub {
+
+//****************************************************************************
+// Depth buffer of occluders in low resolution. Only reciprocal of camera z
+// of the nearest occluder is stored in each pixel (0 means empty pixel), and
+// bounding spheres of objects are tested against it (see note #1)
+//****************************************************************************
+
+struct OcclusionBuffer
+{
+  static constexpr int kWidth {256};    // multiple of 4 (see DrawTriangle())
+
+  OcclusionBuffer();
+
+  int       width_;
+  int       height_;            // computed by aspect ratio of camera
+  V_AFloat  depth_;
+  float     mx_[9];             // rotation of camera of the current frame
+  Vector    cam_pos_;
+  float     near_z_;
+  float     fx_;                // pixels per unit of x/z and y/z
+  float     fy_;
+  V_Vector  proj_;              // scratch for projected vertices
+  V_Uchar   inner_;             // scratch for inner edges of faces
+
+}; // struct OcclusionBuffer
+
+namespace occlusion {
+
+  void  Clear(OcclusionBuffer&, const GlCamera&);
+  void  AddOccluder(
+    OcclusionBuffer&, cV_Vertex&, cV_Face&, const V_MeshEdge&);
+  bool  IsOccluded(const OcclusionBuffer&, cVector& center, float rad);
+  int   Cull(const OcclusionBuffer&, BoundingSpheres&);
+
+} // namespace occlusion
+
+namespace occlusion_helpers {
+
+  Vector  World2Camera(const OcclusionBuffer&, cVector&);
+  void    DrawTriangle(
+    OcclusionBuffer&, cVector&, cVector&, cVector&, uchar inner);
+
+} // namespace occlusion_helpers
+
+//****************************************************************************
+// Inline implementation
+//****************************************************************************
+
+inline OcclusionBuffer::OcclusionBuffer()
+  : width_{kWidth}
+  , height_{0}
+  , depth_{}
+  , mx_{}
+  , cam_pos_{}
+  , near_z_{0.0f}
+  , fx_{0.0f}
+  , fy_{0.0f}
+  , proj_{}
+  , inner_{}
+{ }
+
+// Converts point from world to camera coordinates of the current frame
+
+inline Vector occlusion_helpers::World2Camera(
+  const OcclusionBuffer& buf, cVector& p)
+{
+  Vector v {p - buf.cam_pos_};
+  const float* m = buf.mx_;
+  return Vector{
+    m[0] * v.x + m[1] * v.y + m[2] * v.z,
+    m[3] * v.x + m[4] * v.y + m[5] * v.z,
+    m[6] * v.x + m[7] * v.y + m[8] * v.z
+  };
+}
+
+}  // namespace anshub
+
+#endif  // GC_GL_OCCLUSION_H
+
+// Note #1 : occluders (i.e. large objects as terrain) are rasterized by
+//  AddOccluder() into the small buffer by 4 pixels per sse instruction.
+//  Then bounding sphere of each object is projected to the rectangle which
+//  encloses it, and the object is occluded if each pixel in the rectangle
+//  has occluder nearer than the nearest point of the sphere. Triangles of
+//  occluders crossed by near_z plane are skipped, and objects crossed by it
+//  are never occluded. Occluders are rasterized conservatively: pixel is
+//  covered only if active faces of the occluder cover it entirely. Edges
+//  shared by two active faces are rasterized by centers of pixels (thus
+//  the pixel on such edge is covered by one of faces), while the rest
+//  (outline) edges are moved inside by the half of pixel. Covered pixel
+//  gets the least depth of the plane of face in it, thus the object seen
+//  through the gap in occluders (even thinner than a pixel) is never culled
@@ -0,0 +1,175 @@
+// *************************************************************
+// File:    gl_occlusion_queries.cc
+// Descr:   temporal occlusion queries by depth pyramid of z-buffer
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#include "gl_occlusion_queries.h"
+
+namespace anshub {
+
+// Builds pyramid of max depth from z-buffer drawn by the camera
+
+void occlusion_queries::BuildPyramid(
+  DepthPyramid& p, const ZBuffer& zbuf, const GlCamera& cam)
+{
+  coords::World2CameraMatrix(cam.dir_, cam.trig_, p.mx_);
+  p.cam_pos_ = cam.vrp_;
+  p.near_z_ = cam.z_near_;
+  p.fx_ = cam.dov_ * cam.scr_w_ / cam.wov_;
+  p.fy_ = cam.dov_ * cam.ar_ * cam.scr_h_ / cam.wov_;
+  p.scr_w_ = zbuf.Width();
+  p.scr_h_ = zbuf.Height();
+
+  // Level 0 is made from pixels (odd sizes give cells with 1 pixel width)
+
+  p.levels_.resize(1);
+  p.widths_.assign(1, (p.scr_w_ + 1) / 2);
+  p.heights_.assign(1, (p.scr_h_ + 1) / 2);
+  auto& base = p.levels_.front();
+  base.assign(p.widths_[0] * p.heights_[0], 0.0f);
+
+  for (int y = 0; y < p.heights_[0]; ++y)
+  {
+    int y2 = std::min(y * 2 + 1, p.scr_h_ - 1);
+    for (int x = 0; x < p.widths_[0]; ++x)
+    {
+      int x2 = std::min(x * 2 + 1, p.scr_w_ - 1);
+      base[y * p.widths_[0] + x] = std::min(
+        std::min(zbuf(x * 2, y * 2), zbuf(x2, y * 2)),
+        std::min(zbuf(x * 2, y2), zbuf(x2, y2)));
+    }
+  }
+
+  // Next levels until the only cell
+
+  while (p.widths_.back() > 1 || p.heights_.back() > 1)
+  {
+    int prev_w = p.widths_.back();
+    int prev_h = p.heights_.back();
+    int w = (prev_w + 1) / 2;
+    int h = (prev_h + 1) / 2;
+    V_Float level (w * h, 0.0f);
+    const auto& prev = p.levels_.back();
+
+    for (int y = 0; y < h; ++y)
+    {
+      int py1 = y * 2;
+      int py2 = std::min(py1 + 1, prev_h - 1);
+      for (int x = 0; x < w; ++x)
+      {
+        int px1 = x * 2;
+        int px2 = std::min(px1 + 1, prev_w - 1);
+        level[y * w + x] = std::min(
+          std::min(prev[py1 * prev_w + px1], prev[py1 * prev_w + px2]),
+          std::min(prev[py2 * prev_w + px1], prev[py2 * prev_w + px2]));
+      }
+    }
+    p.levels_.push_back(std::move(level));
+    p.widths_.push_back(w);
+    p.heights_.push_back(h);
+  }
+}
+
+// Returns true if bounding sphere (in world coordinates) is hidden in the
+// z-buffer of the pyramid
+
+bool occlusion_queries::IsOccluded(
+  const DepthPyramid& p, cVector& center, float rad)
+{
+  if (p.levels_.empty())
+    return false;
+
+  Vector c = occlusion_queries_helpers::World2Camera(p, center);
+  float nearest = c.z - rad;
+  if (nearest <= p.near_z_)
+    return false;
+
+  // Each point of sphere differs from the center by (dx, dz), where length
+  // is not greater than rad, thus |x/z - cx/cz| is not greater than
+  // rad * sqrt(cx^2 + cz^2) / (cz * (cz - rad)) (the same for y)
+
+  float k = rad / (c.z * nearest);
+  float hx = k * std::sqrt(c.x * c.x + c.z * c.z) * p.fx_;
+  float hy = k * std::sqrt(c.y * c.y + c.z * c.z) * p.fy_;
+  float sx = p.scr_w_ / 2.0f + c.x / c.z * p.fx_;
+  float sy = p.scr_h_ / 2.0f + c.y / c.z * p.fy_;
+
+  return occlusion_queries_helpers::IsRectOccluded(
+    p, sx - hx, sy - hy, sx + hx, sy + hy, 1.0f / nearest);
+}
+
+// Returns true if bounding box (in world coordinates) is hidden in the
+// z-buffer of the pyramid
+
+bool occlusion_queries::IsBoxOccluded(
+  const DepthPyramid& p, cVector& min, cVector& max)
+{
+  if (p.levels_.empty())
+    return false;
+
+  float nearest {0.0f};
+  float x1 {0.0f}, y1 {0.0f}, x2 {0.0f}, y2 {0.0f};
+  for (int i = 0; i < 8; ++i)
+  {
+    Vector corner {
+      i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z};
+    Vector c = occlusion_queries_helpers::World2Camera(p, corner);
+    if (c.z <= p.near_z_)
+      return false;
+
+    float sx = p.scr_w_ / 2.0f + c.x / c.z * p.fx_;
+    float sy = p.scr_h_ / 2.0f + c.y / c.z * p.fy_;
+    if (i == 0)
+    {
+      nearest = c.z;
+      x1 = x2 = sx;
+      y1 = y2 = sy;
+      continue;
+    }
+    nearest = std::min(nearest, c.z);
+    x1 = std::min(x1, sx);
+    x2 = std::max(x2, sx);
+    y1 = std::min(y1, sy);
+    y2 = std::max(y2, sy);
+  }
+  return occlusion_queries_helpers::IsRectOccluded(
+    p, x1, y1, x2, y2, 1.0f / nearest);
+}
+
+// Returns true if all pixels in the screen rectangle have 1/z greater than
+// given. The rectangle is extended by one pixel (since rasterizers round
+// coordinates of vertices), and cells of the level, where the rectangle
+// covers not more than 2x2 cells, are tested
+
+bool occlusion_queries_helpers::IsRectOccluded(
+  const DepthPyramid& p, float x1, float y1, float x2, float y2, float inv_z)
+{
+  int px1 = std::max(0, static_cast<int>(std::floor(x1)) - 1);
+  int py1 = std::max(0, static_cast<int>(std::floor(y1)) - 1);
+  int px2 = std::min(p.scr_w_ - 1, static_cast<int>(std::floor(x2)) + 1);
+  int py2 = std::min(p.scr_h_ - 1, static_cast<int>(std::floor(y2)) + 1);
+  if (px1 > px2 || py1 > py2)
+    return false;
+
+  int level {0};
+  int last = p.levels_.size() - 1;
+  while (level < last &&
+        ((px2 >> (level + 1)) - (px1 >> (level + 1)) > 1 ||
+         (py2 >> (level + 1)) - (py1 >> (level + 1)) > 1))
+    ++level;
+
+  const auto& cells = p.levels_[level];
+  int w = p.widths_[level];
+  for (int y = py1 >> (level + 1); y <= py2 >> (level + 1); ++y)
+  {
+    for (int x = px1 >> (level + 1); x <= px2 >> (level + 1); ++x)
+    {
+      if (cells[y * w + x] <= inv_z)
+        return false;
+    }
+  }
+  return true;
+}
+
+} // namespace anshub
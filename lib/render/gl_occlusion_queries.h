@@ -0,0 +1,195 @@
+// *************************************************************
+// File:    gl_occlusion_queries.h
+// Descr:   temporal occlusion queries by depth pyramid of z-buffer
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef GC_GL_OCCLUSION_QUERIES_H
+#define GC_GL_OCCLUSION_QUERIES_H
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cmath>
+
+#include "lib/render/gl_aliases.h"
+#include "lib/render/gl_z_buffer.h"
+#include "lib/render/gl_coords.h"
+#include "lib/render/cameras/gl_camera.h"
+
+#include "lib/math/vector.h"
+
+namespace anshub {
+
+//****************************************************************************
+// Pyramid of max depth of z-buffer. Since z-buffer holds 1/z, each cell
+// holds the least 1/z of 2x2 cells of previous level (level 0 is made from
+// 2x2 pixels of z-buffer). Camera is the one z-buffer was drawn by
+//****************************************************************************
+
+struct DepthPyramid
+{
+  DepthPyramid();
+
+  std::vector<V_Float> levels_;
+  std::vector<int> widths_;
+  std::vector<int> heights_;
+  float     mx_[9];             // rotation of camera
+  Vector    cam_pos_;
+  float     near_z_;
+  float     fx_;                // pixels per unit of x/z and y/z
+  float     fy_;
+  int       scr_w_;
+  int       scr_h_;
+
+}; // struct DepthPyramid
+
+//****************************************************************************
+// Temporal occlusion queries of objects. Objects hidden in the previous
+// frame are skipped in the current one, and all objects are queried again
+// after the frame is drawn (see note #1)
+//****************************************************************************
+
+struct OcclusionQueries
+{
+  OcclusionQueries();
+  float FalseRate() const;
+
+  DepthPyramid pyramid_;
+  V_Uchar   hidden_;            // results of the last queries
+  V_Uchar   skipped_;           // objects skipped in the current frame
+  int       queries_;           // counters of the last frame
+  int       culled_;
+  int       false_culled_;      // skipped objects which were visible
+
+}; // struct OcclusionQueries
+
+namespace occlusion_queries {
+
+  void  BuildPyramid(DepthPyramid&, const ZBuffer&, const GlCamera&);
+  bool  IsOccluded(const DepthPyramid&, cVector& center, float rad);
+  bool  IsBoxOccluded(const DepthPyramid&, cVector& min, cVector& max);
+
+  template<class Container>
+  int   Skip(OcclusionQueries&, Container& objs);
+  template<class Container>
+  void  Query(OcclusionQueries&, const ZBuffer&, const GlCamera&,
+              const Container& objs);
+
+} // namespace occlusion_queries
+
+namespace occlusion_queries_helpers {
+
+  Vector  World2Camera(const DepthPyramid&, cVector&);
+  bool    IsRectOccluded(
+    const DepthPyramid&, float x1, float y1, float x2, float y2, float inv_z);
+
+} // namespace occlusion_queries_helpers
+
+//****************************************************************************
+// Inline implementation
+//****************************************************************************
+
+inline DepthPyramid::DepthPyramid()
+  : levels_{}
+  , widths_{}
+  , heights_{}
+  , mx_{}
+  , cam_pos_{}
+  , near_z_{0.0f}
+  , fx_{0.0f}
+  , fy_{0.0f}
+  , scr_w_{0}
+  , scr_h_{0}
+{ }
+
+inline OcclusionQueries::OcclusionQueries()
+  : pyramid_{}
+  , hidden_{}
+  , skipped_{}
+  , queries_{0}
+  , culled_{0}
+  , false_culled_{0}
+{ }
+
+// Returns part of skipped objects which were visible in the last frame
+
+inline float OcclusionQueries::FalseRate() const
+{
+  return culled_ ? static_cast<float>(false_culled_) / culled_ : 0.0f;
+}
+
+// Deactivates active objects which were hidden by the last queries and
+// returns count of them. Should be called after objects are activated in
+// the frame (i.e. after ResetAttributes() and frustum culling)
+
+template<class Container>
+int occlusion_queries::Skip(OcclusionQueries& q, Container& objs)
+{
+  q.skipped_.assign(objs.size(), 0);
+  q.culled_ = 0;
+  if (q.hidden_.size() != objs.size())
+    return 0;
+
+  for (std::size_t i = 0; i < objs.size(); ++i)
+  {
+    if (objs[i].active_ && q.hidden_[i])
+    {
+      objs[i].active_ = false;
+      q.skipped_[i] = 1;
+      ++q.culled_;
+    }
+  }
+  return q.culled_;
+}
+
+// Queries all objects by bounding spheres (sphere_rad_ is the greatest
+// distance to vertex) against z-buffer drawn in this frame by given camera.
+// Results are used by Skip() in the next frame
+
+template<class Container>
+void occlusion_queries::Query(OcclusionQueries& q, const ZBuffer& zbuf,
+  const GlCamera& cam, const Container& objs)
+{
+  BuildPyramid(q.pyramid_, zbuf, cam);
+
+  q.hidden_.assign(objs.size(), 0);
+  q.skipped_.resize(objs.size(), 0);
+  q.queries_ = objs.size();
+  q.false_culled_ = 0;
+
+  for (std::size_t i = 0; i < objs.size(); ++i)
+  {
+    q.hidden_[i] = IsOccluded(
+      q.pyramid_, objs[i].world_pos_, objs[i].sphere_rad_);
+    if (q.skipped_[i] && !q.hidden_[i])
+      ++q.false_culled_;
+  }
+}
+
+// Converts point from world to camera coordinates of the pyramid
+
+inline Vector occlusion_queries_helpers::World2Camera(
+  const DepthPyramid& p, cVector& v)
+{
+  Vector d {v - p.cam_pos_};
+  const float* m = p.mx_;
+  return Vector{
+    m[0] * d.x + m[1] * d.y + m[2] * d.z,
+    m[3] * d.x + m[4] * d.y + m[5] * d.z,
+    m[6] * d.x + m[7] * d.y + m[8] * d.z
+  };
+}
+
+}  // namespace anshub
+
+#endif  // GC_GL_OCCLUSION_QUERIES_H
+
+// Note #1 : Query() is called after the frame is drawn, thus z-buffer and
+//  camera are consistent and results are exact for this frame (objects
+//  can`t hide themselves, since the nearest points of bounding volumes are
+//  in front of their faces). In the next frame Skip() deactivates hidden
+//  objects, and if some of them became visible, it is drawn one frame later
+//  (such objects are counted as false culled). Z-buffer should contain only
+//  opaque triangles. Each query reads at most 2x2 cells of pyramid level,
+//  where cells are not less than the screen rectangle of bounding volume
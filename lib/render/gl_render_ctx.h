@@ -9,6 +9,9 @@
 
 #include "gl_scr_buffer.h"
 #include "gl_z_buffer.h"
+#include "fx_postprocess.h"
+#include "fx_text.h"
+#include "fx_sky.h"
 #include "cameras/gl_camera.h"
 
 namespace anshub {
@@ -27,14 +30,21 @@ struct RenderContext
   bool    is_zbuf_;
   bool    is_bifiltering_;
   bool    is_mipmapping_;
+  bool    is_tiled_;        // store sbuf and zbuf as 8x8 tiles
   float   clarity_;
   float   mipmap_dist_;
+  float   affine_ratio_;    // max far/near z of tri to use affine (0 - off)
+  float   tiny_tri_size_;   // max bbox side of tris drawn by fast path (px)
   int     pixels_drawn_;
   int     triangles_drawn_;
 
   GlCamera* cam_;
+  PostContext* post_;       // post processing chain (nullptr - off)
+  SoftText* text_;          // text drawn over the frame (nullptr - off)
+  SkyCube*  sky_;           // sky behind the scene, needs cam_ (nullptr - off)
   ScrBuffer sbuf_;
   ZBuffer   zbuf_;
+  V_Uchar   wired_marks_;   // work buffer of render::Wired()
 
 }; // struct RenderContext
 
@@ -48,13 +58,20 @@ inline RenderContext::RenderContext(int w, int h, int color)
   , is_zbuf_{true}
   , is_bifiltering_{false}
   , is_mipmapping_{false}
+  , is_tiled_{false}
   , clarity_{1.0f}
   , mipmap_dist_{1.0f}
+  , affine_ratio_{0.0f}
+  , tiny_tri_size_{2.0f}
   , pixels_drawn_{}
   , triangles_drawn_{}
   , cam_{nullptr}
+  , post_{nullptr}
+  , text_{nullptr}
+  , sky_{nullptr}
   , sbuf_{w, h, color}
   , zbuf_{w, h}
+  , wired_marks_{}
 { }
 
 }  // namespace anshub
@@ -4,6 +4,8 @@
 // Author:  Novoselov Anton @ 2017
 // *************************************************************
 
+#include <emmintrin.h>
+
 #include "gl_scr_buffer.h"
 
 namespace anshub {
@@ -14,7 +16,9 @@ ScrBuffer::ScrBuffer(int w, int h, int color)
   , clear_color_{color}
   , format_{GL_BGRA}                // see note #3
   , type_{GL_UNSIGNED_INT_8_8_8_8}  //   after code
-  , ptr_(w_ * h_, clear_color_)
+  , layout_{w_, h_, false}
+  , ptr_(layout_.Size(), clear_color_)
+  , linear_{}
 {
   // Prepare OpenGl states before using SendDataToFB()
 
@@ -36,7 +40,51 @@ ScrBuffer::ScrBuffer(int w, int h, int color)
 void ScrBuffer::SendDataToFB()
 {
   glWindowPos2i(0, 0);  // to prevent text clipping
-  glDrawPixels(w_, h_, format_, type_, (GLvoid*)ptr_.data());
+  
+  if (!layout_.IsTiled())
+  {
+    glDrawPixels(w_, h_, format_, type_, (GLvoid*)ptr_.data());
+    return;
+  }
+
+  // Detile into linear staging buffer. Each tile row is 8 pixels (32 bytes),
+  // thus it is copied by two 128-bit loads and stores (see note #4)
+
+  const int kTile = BufLayout::kTileSize;
+  const int pw = layout_.PaddedWidth();
+  const uint* src = ptr_.data();
+  uint* dst = linear_.data();
+
+  for (int y = 0; y < h_; ++y)
+  {
+    const uint* row = src + layout_.Row(y);
+    uint* out = dst + y * pw;
+    for (int x = 0; x < pw; x += kTile)
+    {
+      const __m128i* s = reinterpret_cast<const __m128i*>(row + layout_.Col(x));
+      __m128i* d = reinterpret_cast<__m128i*>(out + x);
+      _mm_storeu_si128(d, _mm_loadu_si128(s));
+      _mm_storeu_si128(d + 1, _mm_loadu_si128(s + 1));
+    }
+  }
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, pw);
+  glDrawPixels(w_, h_, format_, type_, (GLvoid*)linear_.data());
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+// Switches memory layout of the buffer between linear and 8x8 tiles. Content
+// of the buffer is not preserved
+
+void ScrBuffer::SetTiled(bool tiled)
+{
+  if (tiled == layout_.IsTiled())
+    return;
+  layout_ = BufLayout(w_, h_, tiled);
+  ptr_.assign(layout_.Size(), clear_color_);
+  if (tiled)
+    linear_.assign(layout_.PaddedWidth() * h_, clear_color_);
+  else
+    V_Uint().swap(linear_);
 }
 
 } // namespace anshub
@@ -67,4 +115,8 @@ void ScrBuffer::SendDataToFB()
 // Url_3: https://en.wikipedia.org/wiki/RGBA_color_space
 // Url_4: http://www.laurenscorijn.com/articles/colormath-basics
 
-// Todo: make format changing with extension ARB_internal_format_query
\ No newline at end of file
+// Todo: make format changing with extension ARB_internal_format_query
+
+// Note #4 : in tiled layout the triangle touches fewer cache lines and pages
+// per scanline, but the framebuffer expects linear rows, thus we pay for one
+// detile pass per frame. Sse2 is the baseline of x86-64, so no extra flags
\ No newline at end of file
@@ -17,6 +17,7 @@
 #include <GL/glext.h>
 
 #include "lib/render/gl_aliases.h"
+#include "lib/render/gl_buf_layout.h"
 
 namespace anshub {
 
@@ -30,12 +31,18 @@ struct ScrBuffer
 
   void  Clear();
   void  SendDataToFB();
+  void  SetTiled(bool);
   
   uint* GetPointer() { return ptr_.data(); }
+  const uint* GetPointer() const { return ptr_.data(); }
   int   Width() const { return w_; }
   int   Height() const { return h_; }
+  bool  IsTiled() const { return layout_.IsTiled(); }
+  const BufLayout& Layout() const { return layout_; }
   uint& operator[](std::size_t i) { return ptr_[i]; }
   const uint& operator[](std::size_t i) const { return ptr_[i]; }
+  uint& operator()(int x, int y) { return ptr_[layout_.Index(x, y)]; }
+  const uint& operator()(int x, int y) const { return ptr_[layout_.Index(x, y)]; }
 
 private:  
   int w_;           // buffer width
@@ -43,7 +50,9 @@ private:
   int clear_color_;
   GLenum format_;   // https://goo.gl/2A58hH
   GLenum type_;     // the same as above
-  V_Uint ptr_;      // 32 bit color buffer
+  BufLayout layout_;
+  V_Uint ptr_;      // 32 bit color buffer (in layout_ order)
+  V_Uint linear_;   // staging buffer used to detile before sending to fb
 
 }; // class ScrBuffer
 
@@ -53,7 +62,7 @@ private:
 
 inline void ScrBuffer::Clear()
 {
-  memset(ptr_.data(), 0, w_*h_*sizeof(*ptr_.data()));  
+  memset(ptr_.data(), 0, ptr_.size()*sizeof(*ptr_.data()));  
   // forced to use memset instead std::fill after profiling
 }
 
@@ -61,4 +70,7 @@ inline void ScrBuffer::Clear()
 
 #endif  // GL_SCR_BUFFER_H
 
-// Important note : 0,0 is the left-bottom corner
\ No newline at end of file
+// Important note : 0,0 is the left-bottom corner
+
+// Note #1 : operator[] accesses raw storage, while operator()(x,y) respects
+// current layout. Use the latter if buffer may be tiled
\ No newline at end of file
@@ -0,0 +1,56 @@
+// *************************************************************
+// File:    gl_spheres.cc
+// Descr:   bounding spheres of objects culled by frustum in batches
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#include "gl_spheres.h"
+
+namespace anshub {
+
+// Tests spheres against frustum planes of camera and stores results into
+// visible_ array. Sphere is invisible if it is entirely behind one of the
+// planes. Returns count of invisible spheres
+
+int spheres::Cull(BoundingSpheres& s, const GlCamera& cam)
+{
+  __m128 pa[6], pb[6], pc[6], pd[6];
+  for (int i = 0; i < 6; ++i)
+  {
+    pa[i] = _mm_set1_ps(cam.frustum_[i].a_);
+    pb[i] = _mm_set1_ps(cam.frustum_[i].b_);
+    pc[i] = _mm_set1_ps(cam.frustum_[i].c_);
+    pd[i] = _mm_set1_ps(cam.frustum_[i].d_);
+  }
+
+  int padded = s.x_.size();
+  int total {};
+
+  for (int i = 0; i < padded; i += 4)
+  {
+    __m128 x = _mm_load_ps(&s.x_[i]);
+    __m128 y = _mm_load_ps(&s.y_[i]);
+    __m128 z = _mm_load_ps(&s.z_[i]);
+    __m128 neg_rad = _mm_sub_ps(_mm_setzero_ps(), _mm_load_ps(&s.rad_[i]));
+    __m128 inside = _mm_cmpeq_ps(x, x);     // all bits are set
+
+    for (int k = 0; k < 6; ++k)
+    {
+      __m128 dist = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(x, pa[k]), _mm_mul_ps(y, pb[k])),
+        _mm_add_ps(_mm_mul_ps(z, pc[k]), pd[k]));
+      inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, neg_rad));
+    }
+
+    int mask = _mm_movemask_ps(inside);
+    for (int k = 0; k < 4; ++k)
+    {
+      s.visible_[i + k] = (mask >> k) & 1;
+      if (!s.visible_[i + k] && i + k < s.size_)
+        ++total;
+    }
+  }
+  return total;
+}
+
+} // namespace anshub
@@ -0,0 +1,100 @@
+// *************************************************************
+// File:    gl_spheres.h
+// Descr:   bounding spheres of objects culled by frustum in batches
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef GC_GL_SPHERES_H
+#define GC_GL_SPHERES_H
+
+#include <xmmintrin.h>
+
+#include "lib/render/gl_aliases.h"
+#include "lib/render/gl_vx_streams.h"
+#include "lib/render/cameras/gl_camera.h"
+
+#include "lib/math/plane3d.h"
+
+namespace anshub {
+
+//****************************************************************************
+// Bounding spheres of array of objects in structure of arrays layout. Since
+// spheres are tested without touching of objects, many objects are culled
+// by frustum planes of camera (see GlCamera::UpdateFrustum()) 4 per sse
+// instruction (see note #1). Size of arrays is padded as in VxStreams
+//****************************************************************************
+
+struct BoundingSpheres
+{
+  V_AFloat  x_, y_, z_;         // centers in world coordinates
+  V_AFloat  rad_;
+  V_Uchar   visible_;           // result of the last culling
+  int       size_ {0};          // real count of spheres
+
+}; // struct BoundingSpheres
+
+namespace spheres {
+
+  template<class Container>
+  void  Gather(const Container& objs, BoundingSpheres&);
+  template<class Container>
+  int   Apply(const BoundingSpheres&, Container& objs);
+
+  int   Cull(BoundingSpheres&, const GlCamera&);
+
+} // namespace spheres
+
+//****************************************************************************
+// Inline implementation
+//****************************************************************************
+
+// Copies world positions and bounding sphere radiuses of objects to spheres
+// (padding spheres have zero radius)
+
+template<class Container>
+void spheres::Gather(const Container& objs, BoundingSpheres& s)
+{
+  int size = objs.size();
+  int padded = (size + VxStreams::kPad - 1) / VxStreams::kPad * VxStreams::kPad;
+
+  s.size_ = size;
+  for (auto* arr : {&s.x_, &s.y_, &s.z_, &s.rad_})
+    arr->assign(padded, 0.0f);
+  s.visible_.assign(padded, 0);
+
+  for (int i = 0; i < size; ++i)
+  {
+    s.x_[i] = objs[i].world_pos_.x;
+    s.y_[i] = objs[i].world_pos_.y;
+    s.z_[i] = objs[i].world_pos_.z;
+    s.rad_[i] = objs[i].sphere_rad_;
+  }
+}
+
+// Sets active flag of objects by result of the last culling and returns
+// count of culled objects (objects should be in the same order as when
+// spheres were gathered)
+
+template<class Container>
+int spheres::Apply(const BoundingSpheres& s, Container& objs)
+{
+  int size = std::min(s.size_, static_cast<int>(objs.size()));
+  int total {};
+
+  for (int i = 0; i < size; ++i)
+  {
+    objs[i].active_ = s.visible_[i];
+    if (!objs[i].active_)
+      ++total;
+  }
+  return total;
+}
+
+}  // namespace anshub
+
+#endif  // GC_GL_SPHERES_H
+
+// Note #1 : object::CullX(), CullY() and CullZ() convert world position of
+//  each object to camera coordinates by three rotations, and read two fields
+//  of large GlObject struct. Here sphere is tested against 6 planes in world
+//  coordinates by dot products, and arrays are read sequentially
@@ -15,6 +15,8 @@ Triangle::Triangle()
   , normal_{}
   , color_{}
   , textures_{nullptr}
+  , quad_{Quad::NONE}
+  , reflection_{nullptr}
 { }
 
 Triangle::Triangle(
@@ -28,6 +30,8 @@ Triangle::Triangle(
   , normal_{f.normal_}
   , color_{f.color_}
   , textures_{&tex}
+  , quad_{f.quad_}
+  , reflection_{nullptr}
 { }
 
 // Makes container of Triangles with supposed capacity. If we would use
@@ -70,10 +74,16 @@ void triangles::AddFromObject(GlObject& obj, V_Triangle& triangles)
     return;
 
   auto& vxs = obj.GetCoords();
+  auto& faces = obj.faces_;
  
-  for (auto& face : obj.faces_)
-    if (face.active_)
-      triangles.emplace_back(vxs, obj.shading_, face, obj.textures_);
+  for (std::size_t i = 0; i < faces.size(); ++i)
+  {
+    if (!faces[i].active_)
+      continue;
+    triangles.emplace_back(vxs, obj.shading_, faces[i], obj.textures_);
+    triangles.back().quad_ = object::ActiveQuadHalf(faces, i);
+    triangles.back().reflection_ = obj.reflection_;
+  }
 }
 
 // Add references to triangles from objects to triangles container
@@ -86,10 +96,16 @@ void triangles::AddFromObjects(V_GlObject& arr, V_Triangle& triangles)
       continue;
 
     auto& vxs = obj.GetCoords();
+    auto& faces = obj.faces_;
   
-    for (auto& face : obj.faces_)
-      if (face.active_)
-        triangles.emplace_back(vxs, obj.shading_, face, obj.textures_);
+    for (std::size_t i = 0; i < faces.size(); ++i)
+    {
+      if (!faces[i].active_)
+        continue;
+      triangles.emplace_back(vxs, obj.shading_, faces[i], obj.textures_);
+      triangles.back().quad_ = object::ActiveQuadHalf(faces, i);
+      triangles.back().reflection_ = obj.reflection_;
+    }
   }
 }
 
@@ -98,260 +114,312 @@ void triangles::AddFromTriangles(cV_Triangle& from, V_Triangle& to)
   std::copy(from.begin(), from.end(), std::back_inserter(to));
 }
 
-// Cull triangles by 6 frustum planes and clip by near_z plane. Function works
-// in camera coordinates. In perfomance reasons we should call it before lighting,
-// but after removing backfaces
-// Culling procedure:
-// 1) tests triangles to intersect of 5 planes except near_z. If triangle is
-//  out of the one plane, the we cull it. If it inside all 5 planes or
-//  intersects one of them, then we don`t cull it (cutting will be in triangles
-//  rasterization function)
-// 2) test triangles to intersect of near_z plane. If intersects, then clip
-
-// todo: lighting after clipping near_z is not correct, since something
-// goes wrong in vertices exchanging while clipping
-
-int triangles::CullAndClip(V_Triangle& arr, const GlCamera& cam)
+// Makes triangles from object which vertices are in camera coordinates and
+// are lighted already (post-transform path, see note #2 after code). Each
+// vertex is projected once, and triangles get screen coordinates:
+//  - faces crossed by near_z plane are added to `near` in camera coords and
+//    should be passed through CullAndClip(), Camera2Persp(), Persp2Screen()
+//  - faces out of screen or behind far_z plane are culled
+//  - other faces are added to `screen`
+// Returns count of culled faces. Culled and near faces are deactivated
+
+int triangles::AddFromObjectIndexed(
+  GlObject& obj, const GlCamera& cam, V_Triangle& near, V_Triangle& screen)
 {
-  // Prepare container for new triangles if we would divide old
-  
-  V_Triangle new_tris {};
-  
-  // Test planes
+  if (!obj.active_)
+    return 0;
 
+  auto& vxs = obj.GetCoords();
+  auto& faces = obj.faces_;
   int total {};
-  for (auto& tri : arr)
-  {
-    // 1. Start culling triangle by L and R planes
 
-    // Compute x-axis projection of point, which lies on L and R plane
-    // when z = 1. Attent, that cam.wov_/2 - is proj_x when z = cam.dov_
+  // Take faces crossed by near_z plane to usual pipeline
 
-    if (!tri.active_) 
+  for (auto& face : faces)
+  {
+    if (!face.active_)
       continue;
 
-    int out_of_l {0};
-    int out_of_r {0};
-    float proj_x = cam.wov_ * 0.5f / cam.dov_;  // todo: move out of loop
-
-    // Test left and right plane for all 3 vertexes in triangle
+    int behind_nz {0};
+    for (int i = 0; i < 3; ++i)
+      if (vxs[face[i]].pos_.z <= cam.z_near_)
+        ++behind_nz;
 
-    float max_x = proj_x * tri[0].pos_.z;       // max x when z == pos_.z
-    if (tri[0].pos_.x < -max_x) ++out_of_l;
-    if (tri[0].pos_.x >  max_x) ++out_of_r;
-    
-    max_x = proj_x * tri[1].pos_.z;
-    if (tri[1].pos_.x < -max_x) ++out_of_l;
-    if (tri[1].pos_.x >  max_x) ++out_of_r;
+    if (behind_nz == 0)
+      continue;
+    if (behind_nz == 3)
+      ++total;
+    else {
+      near.emplace_back(vxs, obj.shading_, face, obj.textures_);
+      near.back().reflection_ = obj.reflection_;
+    }
+    face.active_ = false;
+  }
 
-    max_x = proj_x * tri[2].pos_.z;     
-    if (tri[2].pos_.x < -max_x) ++out_of_l;
-    if (tri[2].pos_.x >  max_x) ++out_of_r;
+  // Project vertices in front of near_z plane (as Camera2Persp() and
+  // Persp2Screen() do for triangles)
 
-    // End culling triangle after testing L and R planes
+  float half_wov = cam.wov_ * 0.5f;
+  float kx = cam.scr_w_ / cam.wov_;
+  float ky = cam.scr_h_ / cam.wov_;
 
-    if (out_of_l == 3 || out_of_r == 3) {
-      tri.active_ = false;
-      ++total;
-    }      
+  for (auto& vx : vxs)
+  {
+    if (vx.pos_.z <= cam.z_near_)
+      continue;
+    float k = cam.dov_ / vx.pos_.z;
+    vx.pos_.x = (vx.pos_.x * k + half_wov) * kx;
+    vx.pos_.y = (vx.pos_.y * k * cam.ar_ + half_wov) * ky;
+  }
 
-    // 2. Start culling triangle by U and D planes
+  return total + triangles::AddFromObjectProjected(obj, cam, screen);
+}
 
-    if (!tri.active_)
-      continue;
+// Adds faces of object in screen coordinates (i.e. after object::Project())
+// to the array. Faces which are out of the same screen side or far_z plane
+// are culled. Returns culled faces count
 
-    int out_of_u {0};
-    int out_of_d {0};
-    float proj_y = cam.wov_ * 0.5 / cam.dov_;
+int triangles::AddFromObjectProjected(
+  GlObject& obj, const GlCamera& cam, V_Triangle& screen)
+{
+  if (!obj.active_)
+    return 0;
 
-    // Test left and right plane for all 3 vertexes in triangle
+  auto& vxs = obj.GetCoords();
+  auto& faces = obj.faces_;
+  int total {};
 
-    float max_y = proj_y * tri[0].pos_.z / cam.ar_;       // max y when z == pos_.z
-    if (tri[0].pos_.y < -max_y) ++out_of_d;
-    if (tri[0].pos_.y >  max_y) ++out_of_u;
-    
-    max_y = proj_y * tri[1].pos_.z / cam.ar_;
-    if (tri[1].pos_.y < -max_y) ++out_of_d;
-    if (tri[1].pos_.y >  max_y) ++out_of_u;
-    
-    max_y = proj_y * tri[2].pos_.z / cam.ar_;
-    if (tri[2].pos_.y < -max_y) ++out_of_d;
-    if (tri[2].pos_.y >  max_y) ++out_of_u;
+  for (auto& face : faces)
+  {
+    if (!face.active_)
+      continue;
 
-    // End culling triangle after testing U and D planes
+    cVector& p1 = vxs[face[0]].pos_;
+    cVector& p2 = vxs[face[1]].pos_;
+    cVector& p3 = vxs[face[2]].pos_;
 
-    if (out_of_u == 3 || out_of_d == 3) {
-      tri.active_ = false;
+    if ((p1.x < 0.0f && p2.x < 0.0f && p3.x < 0.0f) ||
+        (p1.y < 0.0f && p2.y < 0.0f && p3.y < 0.0f) ||
+        (p1.x > cam.scr_w_ && p2.x > cam.scr_w_ && p3.x > cam.scr_w_) ||
+        (p1.y > cam.scr_h_ && p2.y > cam.scr_h_ && p3.y > cam.scr_h_) ||
+        (p1.z > cam.z_far_ && p2.z > cam.z_far_ && p3.z > cam.z_far_))
+    {
+      face.active_ = false;
       ++total;
     }
+  }
 
-    // 3. Start culling triangle by Near_Z and Far_Z planes
+  // Add survived faces (quad halves are known after culling)
 
-    if (!tri.active_)
+  for (std::size_t i = 0; i < faces.size(); ++i)
+  {
+    if (!faces[i].active_)
       continue;
+    screen.emplace_back(vxs, obj.shading_, faces[i], obj.textures_);
+    screen.back().quad_ = object::ActiveQuadHalf(faces, i);
+    screen.back().reflection_ = obj.reflection_;
+  }
+  return total;
+}
 
-    int out_of_fz {0};
-    std::vector<int> behind_nz {};
-    behind_nz.reserve(3);
-    behind_nz.resize(0);
-
-    // Test near_z and far_z for all 3 vertexes in triangle
+// Cull triangles by 6 frustum planes and clip by near_z and guard band
+// planes. Function works in camera coordinates. In perfomance reasons we
+// should call it before lighting, but after removing backfaces
+// Culling procedure:
+// 1) tests triangles to be out of one of 6 frustum planes. If so, then we
+//  cull it
+// 2) clips triangles crossed by near_z plane or by side planes widened by
+//  cam.guard_band_ (see note #3 after code). Triangles partially behind
+//  far_z plane are not clipped. Clipped triangle takes the first part of
+//  polygon, and the rest parts are added to the end of array (which should
+//  be reserved to not allocate memory, see MakeBaseContainer())
 
-    if (tri[0].pos_.z >  cam.z_far_)  ++out_of_fz;
-    if (tri[0].pos_.z <= cam.z_near_)
-      behind_nz.push_back(0);
+int triangles::CullAndClip(V_Triangle& arr, const GlCamera& cam)
+{
+  // Compute x and y of side planes when z == 1
 
-    if (tri[1].pos_.z >  cam.z_far_)  ++out_of_fz;
-    if (tri[1].pos_.z <= cam.z_near_)
-      behind_nz.push_back(1);
+  float proj_x = cam.wov_ * 0.5f / cam.dov_;
+  float proj_y = proj_x / cam.ar_;
+  float band_x = proj_x * cam.guard_band_;
+  float band_y = proj_y * cam.guard_band_;
 
-    if (tri[2].pos_.z >  cam.z_far_)  ++out_of_fz;
-    if (tri[2].pos_.z <= cam.z_near_)
-      behind_nz.push_back(2);
+  const std::array<Plane3d, 5> planes {{
+    {0.0f,  0.0f,  1.0f,   -cam.z_near_},   // near_z
+    {1.0f,  0.0f,  band_x, 0.0f},           // left
+    {-1.0f, 0.0f,  band_x, 0.0f},           // right
+    {0.0f,  1.0f,  band_y, 0.0f},           // down
+    {0.0f,  -1.0f, band_y, 0.0f}            // up
+  }};
 
-    // End culling triangle after testing Near_Z Far_Z planes
+  std::array<Vertex, triangle::kMaxClipVertices> poly_a {};
+  std::array<Vertex, triangle::kMaxClipVertices> poly_b {};
 
-    if (out_of_fz == 3 || behind_nz.size() == 3) {
-      tri.active_ = false;
-      ++total;
-    }
+  int total {};
+  std::size_t count = arr.size();
 
-    // 4. Start clipping triangle by Near_Z plane
-    
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    auto& tri = arr[i];
     if (!tri.active_)
       continue;
 
-    // Light case (search intersect of 2 lines with Near_Z and make new triangle)
+    // Test vertices by frustum and guard band planes
+
+    int out_of_l {0};
+    int out_of_r {0};
+    int out_of_d {0};
+    int out_of_u {0};
+    int out_of_fz {0};
+    int behind_nz {0};
+    int clip_by {0};      // bit mask of planes to clip by
 
-    if (behind_nz.size() == 2)
+    for (int k = 0; k < 3; ++k)
     {
-      // Define points before near_z and point after near_z
-      
-      int pb1 = behind_nz[0];
-      int pb2 = behind_nz[1];
-      int pa {0};
-      if (pb1+pb2 == 1) 
-        pa = 2;
-      else if (pb1+pb2 == 2)
-        pa = 1;
-
-      if (tri[pb1].pos_.x > tri[pb2].pos_.x)
-        std::swap(pb1, pb2);
- 
-      // Compute intersection
-
-      Parmline3d line_1  {tri[pa].pos_, tri[pb1].pos_};
-      Parmline3d line_2  {tri[pa].pos_, tri[pb2].pos_};
-      Plane3d    plane_z {0.0f, 0.0f, 1.0f, -cam.z_near_};
-      Vector q1 = parmline3d::Intersects(line_1, plane_z);
-      Vector q2 = parmline3d::Intersects(line_2, plane_z);
-
-      // Compute color and texture coords for new vertices
-
-      tri.normal_ = 
-        vector::CrossProduct(tri[1].pos_-tri[0].pos_, tri[2].pos_-tri[0].pos_);
-
-      float t1 = parmline3d::FindIntersectsT(line_1, plane_z);
-      float t2 = parmline3d::FindIntersectsT(line_2, plane_z);
-
-      tri[pb1].pos_ = q1;
-      tri[pb2].pos_ = q2;
-
-      FColor dx_cl = tri[pb1].color_ - tri[pa].color_;
-      FColor dx_cr = tri[pb2].color_ - tri[pa].color_;
-      tri[pb1].color_ = tri[pa].color_ + (dx_cl * t1);
-      tri[pb2].color_ = tri[pa].color_ + (dx_cr * t2);
-      
-      Vector dx_nl = tri[pb1].normal_ - tri[pa].normal_;
-      Vector dx_nr = tri[pb2].normal_ - tri[pa].normal_;
-      tri[pb1].normal_ = tri[pa].normal_ + (dx_nl * t1);
-      tri[pb2].normal_ = tri[pa].normal_ + (dx_nr * t2);
-
-      tri[pb1].texture_ = 
-        tri[pa].texture_ + (tri[pb1].texture_ - tri[pa].texture_) * t1;
-      tri[pb2].texture_ = 
-        tri[pa].texture_ + (tri[pb2].texture_ - tri[pa].texture_) * t2;
+      cVector& p = tri[k].pos_;
+      if (p.x < -proj_x * p.z) ++out_of_l;
+      if (p.x >  proj_x * p.z) ++out_of_r;
+      if (p.y < -proj_y * p.z) ++out_of_d;
+      if (p.y >  proj_y * p.z) ++out_of_u;
+      if (p.z >  cam.z_far_)   ++out_of_fz;
+      if (p.z <= cam.z_near_)  ++behind_nz;
+
+      for (std::size_t n = 0; n < planes.size(); ++n)
+        if (triangle::PlaneDistance(planes[n], p) < 0.0f)
+          clip_by |= 1 << n;
     }
-    
-    // Difficult case
 
-    else if (behind_nz.size() == 1)
+    if (out_of_l == 3 || out_of_r == 3 || out_of_d == 3 || out_of_u == 3 ||
+        out_of_fz == 3 || behind_nz == 3)
     {
-      // Define points before near_z and point after near_z
-      
-      int pb = behind_nz[0];
-      int pa1 {0};
-      int pa2 {0};
-      if (pb == 0) {
-        pa1 = 1;
-        pa2 = 2;
-      }
-      else if (pb == 1) {
-        pa1 = 0;
-        pa2 = 2;
-      }
-      else {
-        pa1 = 0;
-        pa2 = 1;
-      }
+      tri.active_ = false;
+      ++total;
+      continue;
+    }
+    if (!clip_by)
+      continue;
 
-      // Make pa1 the most left index
+    // Clip triangle as polygon by each crossed plane
 
-      if (tri[pa1].pos_.x > tri[pa2].pos_.x)
-        std::swap(pa1, pa2);
-      
-      // Compute intersection
+    Vertex* src = poly_a.data();
+    Vertex* dst = poly_b.data();
+    std::copy(tri.vxs_.begin(), tri.vxs_.end(), src);
+    int size {3};
 
-      Parmline3d line_1  {tri[pa1].pos_, tri[pb].pos_};
-      Parmline3d line_2  {tri[pa2].pos_, tri[pb].pos_};
-      Plane3d    plane_z {0.0f, 0.0f, 1.0f, -cam.z_near_};
-      Vector q1 = parmline3d::Intersects(line_1, plane_z);
-      Vector q2 = parmline3d::Intersects(line_2, plane_z);
+    for (std::size_t n = 0; n < planes.size() && size >= 3; ++n)
+    {
+      if (clip_by & (1 << n))
+      {
+        size = triangle::ClipByPlane(src, size, planes[n], dst);
+        std::swap(src, dst);
+      }
+    }
 
-      // Compute new vertices for both triangles (new and old) 
+    if (size < 3)
+    {
+      tri.active_ = false;
+      ++total;
+      continue;
+    }
 
-      Vertex v1 {tri[pa2]};
-      Vertex v2 {q2};
-      Vertex v3 {q1};
+    // Clipped triangle (and its new parts) is not a half of grid quad anymore.
+    // Polygon is splitted by fan, and new parts are copies of triangle with
+    // other vertices (thus they keep colors, textures and reflection)
 
-      // Compute color and texture coords for new vertices
+    tri.quad_ = Quad::NONE;
+    tri.vxs_ = {src[0], src[1], src[2]};
 
-      float t1 = parmline3d::FindIntersectsT(line_1, plane_z);
-      float t2 = parmline3d::FindIntersectsT(line_2, plane_z);
+    if (size > 3)
+    {
+      Triangle part {tri};
+      for (int k = 3; k < size; ++k)
+      {
+        part.vxs_ = {src[0], src[k - 1], src[k]};
+        arr.push_back(part);          // tri may be invalidated here
+      }
+    }
+  }
+  return total;
+}
 
-      FColor dx_cl = tri[pb].color_ - tri[pa1].color_;
-      FColor dx_cr = tri[pb].color_ - tri[pa2].color_;
-      v3.color_ = tri[pa1].color_ + (dx_cl * t1);
-      v2.color_ = tri[pa2].color_ + (dx_cr * t2);
+// Splits triangles in camera coordinates (after CullAndClip and before
+// Camera2Persp) while their edges have depth ratio greater than ratio or
+// screen length greater than length (in px). Each edge is bisected, and
+// triangle is replaced by 2, 3 or 4 pieces by count of splitted edges.
+// Returns count of new triangles (see note #1 after code)
 
-      Vector dx_nl = tri[pb].normal_ - tri[pa1].normal_;
-      Vector dx_nr = tri[pb].normal_ - tri[pa2].normal_;
-      v3.normal_ = tri[pa1].normal_ + (dx_nl * t1);
-      v3.normal_ = tri[pa2].normal_ + (dx_nr * t2);
+int triangles::Subdivide(
+  V_Triangle& arr, const GlCamera& cam, float ratio, float length)
+{
+  int total {};
 
-      v3.texture_ = 
-        tri[pa1].texture_ + (tri[pb].texture_ - tri[pa1].texture_) * t1;
-      v2.texture_ = 
-        tri[pa2].texture_ + (tri[pb].texture_ - tri[pa2].texture_) * t2;
+  for (std::size_t i = 0; i < arr.size(); ++i)
+  {
+    if (!arr[i].active_)
+      continue;
 
-      // Make new triangle
+    Triangle tri {arr[i]};            // arr[i] may be invalidated below
+    bool split[3];
+    int cnt {0};
+    for (int k = 0; k < 3; ++k)
+    {
+      split[k] = triangle::NeedsSplit(tri[k], tri[(k + 1) % 3], cam, ratio,
+                                      length);
+      cnt += split[k];
+    }
+    if (!cnt)
+      continue;
 
-      Triangle new_tri {tri};
-      new_tri.vxs_ = {v1, v2, v3};
-      new_tri.color_ = tri.color_;
-      new_tri.normal_ = 
-        vector::CrossProduct(v2.pos_-v1.pos_, v3.pos_-v1.pos_);
-      new_tris.push_back(new_tri);
+    // Rotate vertices to make the first edge splitted (one edge) or the
+    // first edge not splitted (two edges), winding is kept
 
-      // Change old triangle
+    int a {0};
+    for (int k = 0; k < 3; ++k)
+    {
+      if ((cnt == 1 && split[k]) || (cnt == 2 && !split[k]))
+        a = k;
+    }
+    cVertex& va = tri[a];
+    cVertex& vb = tri[(a + 1) % 3];
+    cVertex& vc = tri[(a + 2) % 3];
 
-      tri.vxs_[pb] = v3;
+    Triangle piece {tri};
+    piece.quad_ = Quad::NONE;
+    auto add = [&](cVertex& v1, cVertex& v2, cVertex& v3, bool first)
+    {
+      piece.vxs_ = {v1, v2, v3};
+      if (first)
+        arr[i] = piece;
+      else
+        arr.push_back(piece);
+    };
+
+    if (cnt == 1)
+    {
+      Vertex mab = triangle::MidVertex(va, vb);
+      add(va, mab, vc, true);
+      add(mab, vb, vc, false);
     }
+    else if (cnt == 2)
+    {
+      Vertex mbc = triangle::MidVertex(vb, vc);
+      Vertex mca = triangle::MidVertex(vc, va);
+      add(mca, mbc, vc, true);
+      add(va, vb, mbc, false);
+      add(va, mbc, mca, false);
+    }
+    else
+    {
+      Vertex mab = triangle::MidVertex(va, vb);
+      Vertex mbc = triangle::MidVertex(vb, vc);
+      Vertex mca = triangle::MidVertex(vc, va);
+      add(mab, mbc, mca, true);
+      add(va, mab, mca, false);
+      add(mab, vb, mbc, false);
+      add(mca, mbc, vc, false);
+    }
+    total += cnt;
+    --i;                              // pieces may need splitting too
   }
-  
-  // Insert back new triangles which was prepared when we divide them above
-
-  std::copy(new_tris.begin(), new_tris.end(), std::back_inserter(arr));
   return total;
 }
 
@@ -421,6 +489,26 @@ void triangles::ComputeNormals(V_Triangle& arr, bool normalize)
   }
 }
 
+// Computes normalized normals only of triangles which have no normals. Other
+// triangles keep normals of faces of objects (i.e. set from local normals by
+// object::RefreshFaceNormals() and rotated by World2Camera() with normals)
+
+void triangles::ComputeNormalsAbsent(V_Triangle& arr)
+{
+  for (auto& tri : arr)
+  {
+    if (!tri.active_ || !tri.normal_.IsZero())
+      continue;
+
+    Vector u {tri[0].pos_, tri[1].pos_};
+    Vector v {tri[0].pos_, tri[2].pos_};
+    tri.normal_ = vector::CrossProduct(u, v);
+
+    if (!tri.normal_.IsZero())
+      tri.normal_.Normalize();
+  }
+}
+
 // Apply matrix to all triangles in array
 
 void triangles::ApplyMatrix(const Matrix<4,4>& mx, V_Triangle& arr)
@@ -436,8 +524,12 @@ void triangles::ApplyMatrix(const Matrix<4,4>& mx, V_Triangle& arr)
   }
 }
 
+// Converts triangles from world to camera coordinates. If normals is true,
+// normals of faces which are given are rotated too (see
+// ComputeNormalsAbsent()), otherwise they should be computed after
+
 void triangles::World2Camera(
-  V_Triangle& arr, const GlCamera& cam, cTrigTable& trig)
+  V_Triangle& arr, const GlCamera& cam, cTrigTable& trig, bool normals)
 {
   auto& cam_dir = cam.dir_;
   auto& cam_pos = cam.vrp_;
@@ -486,6 +578,22 @@ void triangles::World2Camera(
         vx.pos_.y = (vx.pos_.y * zcos) + (vx_old * zsin);
       }
     }
+
+    // Rotate normal of face if it is given
+
+    if (normals && !tri.normal_.IsZero())
+    {
+      auto& n = tri.normal_;
+      float nx_old {n.x};
+      n.x = (n.x * ycos) + (n.z * ysin);
+      n.z = (n.z * ycos) - (nx_old * ysin);
+      float ny_old {n.y};
+      n.y = (n.y * xcos) - (n.z * xsin);
+      n.z = (n.z * xcos) + (ny_old * xsin);
+      nx_old = n.x;
+      n.x = (n.x * zcos) - (n.y * zsin);
+      n.y = (n.y * zcos) + (nx_old * zsin);
+    }
   }
 }
 
@@ -652,4 +760,103 @@ void triangles::SortZAvgCounting(V_TrianglePtr& v, float far_z)
   v = res;
 }
 
-} // namespace anshub
\ No newline at end of file
+// Clips convex polygon by plane, keeping the positive side. Attributes of
+// new vertices are interpolated linearly (as triangle is in camera coords).
+// Out should have room for count + 1 vertices. Returns count of vertices
+// of clipped polygon
+
+int triangle::ClipByPlane(
+  const Vertex* in, int count, const Plane3d& plane, Vertex* out)
+{
+  int res {0};
+  for (int i = 0; i < count; ++i)
+  {
+    cVertex& v1 = in[i];
+    cVertex& v2 = in[(i + 1) % count];
+    float d1 = triangle::PlaneDistance(plane, v1.pos_);
+    float d2 = triangle::PlaneDistance(plane, v2.pos_);
+
+    if (d1 >= 0.0f)
+      out[res++] = v1;
+    if ((d1 >= 0.0f) == (d2 >= 0.0f))
+      continue;
+
+    float t = d1 / (d1 - d2);
+    Vertex& vx = out[res++];
+    vx.pos_ = v1.pos_ + (v2.pos_ - v1.pos_) * t;
+    vx.normal_ = v1.normal_ + (v2.normal_ - v1.normal_) * t;
+    vx.color_ = v1.color_ + (v2.color_ - v1.color_) * t;
+    vx.texture_ = v1.texture_ + (v2.texture_ - v1.texture_) * t;
+  }
+  return res;
+}
+
+// Returns ratio of the farthest vertex z to the nearest vertex z (triangle
+// should be in camera coordinates and clipped by near z)
+
+float triangle::DepthRatio(const Triangle& tri)
+{
+  auto z = std::minmax({tri[0].pos_.z, tri[1].pos_.z, tri[2].pos_.z});
+  return z.second / z.first;
+}
+
+// Returns true if edge of triangle in camera coordinates (clipped by near z)
+// should be splitted by Subdivide(). Result depends only on the edge, thus
+// it is the same for both triangles which share the edge. Edges shorter than
+// kMinSplitLength on the screen are never splitted
+
+bool triangle::NeedsSplit(
+  cVertex& v1, cVertex& v2, const GlCamera& cam, float ratio, float length)
+{
+  float kx = cam.dov_ * cam.scr_w_ / cam.wov_;
+  float ky = cam.dov_ * cam.ar_ * cam.scr_h_ / cam.wov_;
+  float dx = (v1.pos_.x / v1.pos_.z - v2.pos_.x / v2.pos_.z) * kx;
+  float dy = (v1.pos_.y / v1.pos_.z - v2.pos_.y / v2.pos_.z) * ky;
+  float len = std::sqrt(dx * dx + dy * dy);
+  if (len < kMinSplitLength)
+    return false;
+
+  auto z = std::minmax(v1.pos_.z, v2.pos_.z);
+  return len > length || z.second > z.first * ratio;
+}
+
+// Returns vertex in the middle of the edge. All vertex attributes are
+// interpolated in camera space, which is exact, and the result doesn`t
+// depend on order of vertices
+
+Vertex triangle::MidVertex(cVertex& v1, cVertex& v2)
+{
+  Vertex mid {v1};
+  mid.pos_ = (v1.pos_ + v2.pos_) * 0.5f;
+  mid.normal_ = (v1.normal_ + v2.normal_) * 0.5f;
+  mid.color_ = (v1.color_ + v2.color_) * 0.5f;
+  mid.texture_ = (v1.texture_ + v2.texture_) * 0.5f;
+  return mid;
+}
+
+} // namespace anshub
+
+// Note #1 : the aim of subdivision is to keep near triangles small, thus
+// affine texturing of each piece has small error, and RenderContext may use
+// affine kernels for them (see RenderContext::affine_ratio_). Whether an
+// edge is splitted depends only on its vertices, and the middle vertex is
+// the same for both orders of them, thus triangles sharing the edge split
+// it equally and t-junctions (cracks) don`t appear. Since short edges are
+// never splitted, count of pieces is limited by the screen area
+
+// Note #2 : AddFromObject() copies vertices into triangles before transform,
+// and each vertex shared by n faces is transformed, lighted and projected
+// n times (6 times for regular grids). In post-transform path the object`s
+// vertex buffer is transformed (object::World2Camera()) and lighted
+// (light::Object()) once per vertex, and triangles take already projected
+// vertices. Only faces crossed by near_z plane take usual way since they are
+// clipped in camera coordinates. Objects which aren`t crossed by near_z
+// plane may be projected by one matrix (object::Project()) and taken by
+// AddFromObjectProjected()
+
+// Note #3 : triangles which are out of screen, but inside of guard band,
+//  aren`t clipped, since rasterizers clamp spans to the screen anyway and
+//  it is cheaper than to make new triangles. The guard band only limits
+//  screen coordinates of vertices (to keep precision and to not overflow
+//  when coordinates are converted to int). Far_z plane is not clipped by
+//  the same reasons
@@ -11,6 +11,7 @@
 #include "lib/render/gl_aliases.h"
 #include "lib/render/fx_colors.h"
 #include "lib/render/gl_face.h"
+#include "lib/render/gl_scr_buffer.h"
 #include "lib/render/gl_vertex.h"
 #include "lib/render/gl_object.h"
 
@@ -42,6 +43,8 @@ struct Triangle
   Vector    normal_;
   FColor    color_;
   V_Bitmap* textures_;
+  Quad      quad_;      // half of grid quad, pair is the neighbour in array
+  const ScrBuffer* reflection_; // see GlObject::reflection_
 
 }; // struct Triangle
 
@@ -66,13 +69,18 @@ namespace triangles {
   void AddFromObject(GlObject&, V_Triangle&);
   void AddFromObjects(V_GlObject&, V_Triangle&);
   void AddFromTriangles(cV_Triangle&, V_Triangle&);
+  int  AddFromObjectIndexed(
+    GlObject&, const GlCamera&, V_Triangle& near, V_Triangle& screen);
+  int  AddFromObjectProjected(GlObject&, const GlCamera&, V_Triangle&);
 
   // Triangles array attributes manipilation
   
   int  CullAndClip(V_Triangle&, const GlCamera&);
+  int  Subdivide(V_Triangle&, const GlCamera&, float ratio, float length);
   int  RemoveHiddenSurfaces(V_Triangle&, const GlCamera&);
   void ResetAttributes(V_Triangle&);
   void ComputeNormals(V_Triangle&, bool normalize = true);
+  void ComputeNormalsAbsent(V_Triangle&);
   
   // Triangles array transformation
 
@@ -80,7 +88,8 @@ namespace triangles {
 
   // Triangles coords helpers
 
-  void World2Camera(V_Triangle&, const GlCamera&, const TrigTable&);
+  void World2Camera(V_Triangle&, const GlCamera&, const TrigTable&,
+                    bool normals = false);
   void Camera2Persp(V_Triangle&, const GlCamera&);
   void Persp2Screen(V_Triangle&, const GlCamera&);
   void Homogenous2Normal(V_Triangle&);
@@ -96,6 +105,35 @@ namespace triangles {
 
 } // namespace triangles
 
+//***********************************************************************
+// Helper functions for SINGLE TRIANGLE
+//***********************************************************************
+
+namespace triangle {
+
+  constexpr int kMaxClipVertices {9};   // triangle clipped by 6 planes
+  constexpr float kMinSplitLength {32.0f};  // px (see Subdivide())
+
+  float DepthRatio(const Triangle&);
+  bool  NeedsSplit(cVertex&, cVertex&, const GlCamera&, float ratio,
+                   float length);
+  Vertex MidVertex(cVertex&, cVertex&);
+  float PlaneDistance(const Plane3d&, cVector&);
+  int   ClipByPlane(const Vertex* in, int count, const Plane3d&, Vertex* out);
+
+} // namespace triangle
+
+//***********************************************************************
+// Inline implementation
+//***********************************************************************
+
+// Returns signed distance from plane to point (not normalized)
+
+inline float triangle::PlaneDistance(const Plane3d& p, cVector& v)
+{
+  return p.a_ * v.x + p.b_ * v.y + p.c_ * v.z + p.d_;
+}
+
 } // namespace anshub
 
 #endif  // GC_GL_TRIANGLE_H
\ No newline at end of file
@@ -0,0 +1,218 @@
+// *************************************************************
+// File:    gl_vx_streams.cc
+// Descr:   structure of arrays layout of vertices positions and normals
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#include "gl_vx_streams.h"
+
+namespace anshub {
+
+// Copies positions and normals of vertices to streams (padding elements
+// are zero, and padding z is 1)
+
+void streams::Gather(const V_Vertex& vxs, VxStreams& s)
+{
+  int size = vxs.size();
+  int padded = (size + VxStreams::kPad - 1) / VxStreams::kPad * VxStreams::kPad;
+
+  s.size_ = size;
+  for (auto* arr : {&s.x_, &s.y_, &s.z_, &s.nx_, &s.ny_, &s.nz_})
+    arr->assign(padded, 0.0f);
+  std::fill(s.z_.begin() + size, s.z_.end(), 1.0f);
+
+  for (int i = 0; i < size; ++i)
+  {
+    s.x_[i] = vxs[i].pos_.x;
+    s.y_[i] = vxs[i].pos_.y;
+    s.z_[i] = vxs[i].pos_.z;
+    s.nx_[i] = vxs[i].normal_.x;
+    s.ny_[i] = vxs[i].normal_.y;
+    s.nz_[i] = vxs[i].normal_.z;
+  }
+}
+
+// Copies positions and normals from streams back to vertices
+
+void streams::Scatter(const VxStreams& s, V_Vertex& vxs)
+{
+  int size = std::min(s.size_, static_cast<int>(vxs.size()));
+  for (int i = 0; i < size; ++i)
+  {
+    vxs[i].pos_.x = s.x_[i];
+    vxs[i].pos_.y = s.y_[i];
+    vxs[i].pos_.z = s.z_[i];
+    vxs[i].normal_.x = s.nx_[i];
+    vxs[i].normal_.y = s.ny_[i];
+    vxs[i].normal_.z = s.nz_[i];
+  }
+}
+
+// Moves positions by vector
+
+void streams::Translate(VxStreams& s, cVector& move)
+{
+  __m128 mx = _mm_set1_ps(move.x);
+  __m128 my = _mm_set1_ps(move.y);
+  __m128 mz = _mm_set1_ps(move.z);
+  int size = s.x_.size();
+
+  for (int i = 0; i < size; i += 4)
+  {
+    _mm_store_ps(&s.x_[i], _mm_add_ps(_mm_load_ps(&s.x_[i]), mx));
+    _mm_store_ps(&s.y_[i], _mm_add_ps(_mm_load_ps(&s.y_[i]), my));
+    _mm_store_ps(&s.z_[i], _mm_add_ps(_mm_load_ps(&s.z_[i]), mz));
+  }
+}
+
+// Translates positions from world to camera coordinates. Camera rotations
+// are composed into one matrix (see coords::World2CameraMatrix())
+
+void streams::World2Camera(
+  VxStreams& s, cVector& cam_pos, cVector& cam_dir, const TrigTable& trig)
+{
+  float m[9];
+  coords::World2CameraMatrix(cam_dir, trig, m);
+  __m128 r[9];
+  for (int i = 0; i < 9; ++i)
+    r[i] = _mm_set1_ps(m[i]);
+
+  __m128 px = _mm_set1_ps(cam_pos.x);
+  __m128 py = _mm_set1_ps(cam_pos.y);
+  __m128 pz = _mm_set1_ps(cam_pos.z);
+  int size = s.x_.size();
+
+  for (int i = 0; i < size; i += 4)
+  {
+    __m128 x = _mm_sub_ps(_mm_load_ps(&s.x_[i]), px);
+    __m128 y = _mm_sub_ps(_mm_load_ps(&s.y_[i]), py);
+    __m128 z = _mm_sub_ps(_mm_load_ps(&s.z_[i]), pz);
+
+    __m128 cx = _mm_add_ps(_mm_add_ps(
+      _mm_mul_ps(r[0], x), _mm_mul_ps(r[1], y)), _mm_mul_ps(r[2], z));
+    __m128 cy = _mm_add_ps(_mm_add_ps(
+      _mm_mul_ps(r[3], x), _mm_mul_ps(r[4], y)), _mm_mul_ps(r[5], z));
+    __m128 cz = _mm_add_ps(_mm_add_ps(
+      _mm_mul_ps(r[6], x), _mm_mul_ps(r[7], y)), _mm_mul_ps(r[8], z));
+
+    _mm_store_ps(&s.x_[i], cx);
+    _mm_store_ps(&s.y_[i], cy);
+    _mm_store_ps(&s.z_[i], cz);
+  }
+}
+
+// Rotates normals from world to camera coordinates (as
+// object::VerticesNormals2Camera() does)
+
+void streams::Normals2Camera(
+  VxStreams& s, cVector& cam_dir, const TrigTable& trig)
+{
+  float m[9];
+  coords::World2CameraMatrix(cam_dir, trig, m);
+  __m128 r[9];
+  for (int i = 0; i < 9; ++i)
+    r[i] = _mm_set1_ps(m[i]);
+
+  int size = s.nx_.size();
+
+  for (int i = 0; i < size; i += 4)
+  {
+    __m128 x = _mm_load_ps(&s.nx_[i]);
+    __m128 y = _mm_load_ps(&s.ny_[i]);
+    __m128 z = _mm_load_ps(&s.nz_[i]);
+
+    _mm_store_ps(&s.nx_[i], _mm_add_ps(_mm_add_ps(
+      _mm_mul_ps(r[0], x), _mm_mul_ps(r[1], y)), _mm_mul_ps(r[2], z)));
+    _mm_store_ps(&s.ny_[i], _mm_add_ps(_mm_add_ps(
+      _mm_mul_ps(r[3], x), _mm_mul_ps(r[4], y)), _mm_mul_ps(r[5], z)));
+    _mm_store_ps(&s.nz_[i], _mm_add_ps(_mm_add_ps(
+      _mm_mul_ps(r[6], x), _mm_mul_ps(r[7], y)), _mm_mul_ps(r[8], z)));
+  }
+}
+
+// Translates positions from camera to perspective coordinates
+
+void streams::Camera2Persp(VxStreams& s, float dov, float ar)
+{
+  __m128 kx = _mm_set1_ps(dov);
+  __m128 ky = _mm_set1_ps(dov * ar);
+  int size = s.x_.size();
+
+  for (int i = 0; i < size; i += 4)
+  {
+    __m128 z = _mm_load_ps(&s.z_[i]);
+    _mm_store_ps(&s.x_[i], _mm_div_ps(_mm_mul_ps(_mm_load_ps(&s.x_[i]), kx), z));
+    _mm_store_ps(&s.y_[i], _mm_div_ps(_mm_mul_ps(_mm_load_ps(&s.y_[i]), ky), z));
+  }
+}
+
+// Translates positions from perspective to screen coordinates
+
+void streams::Persp2Screen(VxStreams& s, float wov, int scr_w, int scr_h)
+{
+  __m128 half_wov = _mm_set1_ps(wov / 2);
+  __m128 kx = _mm_set1_ps(scr_w / wov);
+  __m128 ky = _mm_set1_ps(scr_h / wov);
+  int size = s.x_.size();
+
+  for (int i = 0; i < size; i += 4)
+  {
+    __m128 x = _mm_add_ps(_mm_load_ps(&s.x_[i]), half_wov);
+    __m128 y = _mm_add_ps(_mm_load_ps(&s.y_[i]), half_wov);
+    _mm_store_ps(&s.x_[i], _mm_mul_ps(x, kx));
+    _mm_store_ps(&s.y_[i], _mm_mul_ps(y, ky));
+  }
+}
+
+// Transforms positions by composed model-view-projection matrix, divides
+// x and y by w and writes results to vertices (see note #2 in header)
+
+void streams::Project(
+  const VxStreams& s, const Matrix<4,4>& mx, V_Vertex& vxs)
+{
+  __m128 m[16];
+  for (int i = 0; i < 4; ++i)
+  {
+    for (int k = 0; k < 4; ++k)
+      m[i * 4 + k] = _mm_set1_ps(mx(i,k));
+  }
+
+  alignas(16) float rx[4];
+  alignas(16) float ry[4];
+  alignas(16) float rz[4];
+  int size = std::min(s.size_, static_cast<int>(vxs.size()));
+
+  for (int i = 0; i < size; i += 4)
+  {
+    __m128 x = _mm_load_ps(&s.x_[i]);
+    __m128 y = _mm_load_ps(&s.y_[i]);
+    __m128 z = _mm_load_ps(&s.z_[i]);
+
+    __m128 hx = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(x, m[0]), _mm_mul_ps(y, m[4])),
+      _mm_add_ps(_mm_mul_ps(z, m[8]), m[12]));
+    __m128 hy = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(x, m[1]), _mm_mul_ps(y, m[5])),
+      _mm_add_ps(_mm_mul_ps(z, m[9]), m[13]));
+    __m128 hz = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(x, m[2]), _mm_mul_ps(y, m[6])),
+      _mm_add_ps(_mm_mul_ps(z, m[10]), m[14]));
+    __m128 hw = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(x, m[3]), _mm_mul_ps(y, m[7])),
+      _mm_add_ps(_mm_mul_ps(z, m[11]), m[15]));
+
+    _mm_store_ps(rx, _mm_div_ps(hx, hw));
+    _mm_store_ps(ry, _mm_div_ps(hy, hw));
+    _mm_store_ps(rz, hz);
+
+    int last = std::min(4, size - i);
+    for (int k = 0; k < last; ++k)
+    {
+      vxs[i + k].pos_.x = rx[k];
+      vxs[i + k].pos_.y = ry[k];
+      vxs[i + k].pos_.z = rz[k];
+    }
+  }
+}
+
+} // namespace anshub
@@ -0,0 +1,120 @@
+// *************************************************************
+// File:    gl_vx_streams.h
+// Descr:   structure of arrays layout of vertices positions and normals
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef GC_GL_VX_STREAMS_H
+#define GC_GL_VX_STREAMS_H
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <xmmintrin.h>
+
+#include "lib/render/gl_aliases.h"
+#include "lib/render/gl_vertex.h"
+#include "lib/render/gl_coords.h"
+
+#include "lib/math/trig.h"
+#include "lib/math/vector.h"
+#include "lib/math/matrix.h"
+
+namespace anshub {
+
+//****************************************************************************
+// Allocator of memory aligned by Align bytes (to use aligned simd loads)
+//****************************************************************************
+
+template<class T, std::size_t Align>
+struct AlignedAllocator
+{
+  using value_type = T;
+  template<class U> struct rebind { using other = AlignedAllocator<U, Align>; };
+
+  AlignedAllocator() noexcept { }
+  template<class U>
+  AlignedAllocator(const AlignedAllocator<U, Align>&) noexcept { }
+
+  T* allocate(std::size_t n);
+  void deallocate(T* p, std::size_t) noexcept { _mm_free(p); }
+
+}; // struct AlignedAllocator
+
+template<class T, class U, std::size_t Align>
+bool operator==(const AlignedAllocator<T, Align>&, const AlignedAllocator<U, Align>&)
+{
+  return true;
+}
+
+template<class T, class U, std::size_t Align>
+bool operator!=(const AlignedAllocator<T, Align>&, const AlignedAllocator<U, Align>&)
+{
+  return false;
+}
+
+using V_AFloat = std::vector<float, AlignedAllocator<float, 32>>;
+
+//****************************************************************************
+// Positions and normals of vertices stored as separate x, y, z arrays. Size
+// of arrays is padded to kPad elements, thus transforms process them by
+// whole simd registers without tails (see note #1)
+//****************************************************************************
+
+struct VxStreams
+{
+  static constexpr int kPad {8};
+
+  V_AFloat  x_, y_, z_;         // positions
+  V_AFloat  nx_, ny_, nz_;      // normals
+  int       size_ {0};          // real count of vertices
+
+  bool  Empty() const { return size_ == 0; }
+
+}; // struct VxStreams
+
+namespace streams {
+
+  // Conversion between layouts
+
+  void  Gather(const V_Vertex&, VxStreams&);
+  void  Scatter(const VxStreams&, V_Vertex&);
+
+  // Coordinates converting (the same as in coords:: namespace)
+
+  void  Translate(VxStreams&, cVector& move);
+  void  World2Camera(VxStreams&, cVector& pos, cVector& dir, const TrigTable&);
+  void  Normals2Camera(VxStreams&, cVector& dir, const TrigTable&);
+  void  Camera2Persp(VxStreams&, float dov, float ar);
+  void  Persp2Screen(VxStreams&, float wov, int scr_w, int scr_h);
+  void  Project(const VxStreams&, const Matrix<4,4>& mvp, V_Vertex&);
+
+} // namespace streams
+
+//****************************************************************************
+// Inline implementation
+//****************************************************************************
+
+template<class T, std::size_t Align>
+inline T* AlignedAllocator<T, Align>::allocate(std::size_t n)
+{
+  void* p = _mm_malloc(n * sizeof(T), Align);
+  if (!p)
+    throw std::bad_alloc();
+  return static_cast<T*>(p);
+}
+
+} // namespace anshub
+
+#endif  // GC_GL_VX_STREAMS_H
+
+// Note #1 : coords:: transforms walk arrays of Vertex structs (64 bytes each)
+//  while use only 12 bytes of position, and rotate each vertex by three
+//  branchy rotations. Streams are transformed by 3x3 matrix, 4 vertices per
+//  sse instruction, and read only the arrays which are changed. Padding
+//  elements have z = 1, thus perspective divide of them is harmless
+
+// Note #2 : Project() replaces World2Camera(), Camera2Persp(),
+//  Persp2Screen() and Scatter() by one pass. It reads streams and writes
+//  positions of vertices, thus streams keep untransformed coordinates
@@ -0,0 +1,120 @@
+// *************************************************************
+// File:    gl_workers.cc
+// Descr:   persistent pool of worker threads
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#include "gl_workers.h"
+
+namespace anshub {
+
+// Returns pool shared by render modules, which has thread for each hardware
+// core (including the caller thread)
+
+Workers& Workers::Shared()
+{
+  static Workers workers (std::thread::hardware_concurrency());
+  return workers;
+}
+
+// Starts threads - 1 workers (the caller is counted as thread too)
+
+Workers::Workers(int threads)
+  : threads_{}
+  , run_{}
+  , mutex_{}
+  , wake_{}
+  , done_{}
+  , job_{nullptr}
+  , func_{nullptr}
+  , parts_{0}
+  , size_{0}
+  , busy_{0}
+  , generation_{0}
+  , stop_{false}
+{
+  for (int i = 1; i < threads; ++i)
+    threads_.emplace_back(&Workers::Loop, this, i);
+}
+
+Workers::~Workers()
+{
+  {
+    std::lock_guard<std::mutex> lock {mutex_};
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto& thread : threads_)
+    thread.join();
+}
+
+// Processes parts of the job by all threads (see note #1 in header)
+
+void Workers::Run(int parts, int size, Job job, void* func)
+{
+  parts = std::max(1, parts);
+  if (parts == 1 || threads_.empty())
+  {
+    Execute(0, job, func, parts, size);
+    return;
+  }
+
+  std::lock_guard<std::mutex> run {run_};
+  {
+    std::lock_guard<std::mutex> lock {mutex_};
+    job_ = job;
+    func_ = func;
+    parts_ = parts;
+    size_ = size;
+    busy_ = threads_.size();
+    ++generation_;
+  }
+  wake_.notify_all();
+
+  Execute(0, job, func, parts, size);
+
+  std::unique_lock<std::mutex> lock {mutex_};
+  done_.wait(lock, [this]{ return busy_ == 0; });
+}
+
+// Waits for jobs and processes parts of them given to the thread num
+
+void Workers::Loop(int num)
+{
+  unsigned seen {0};
+  for (;;)
+  {
+    std::unique_lock<std::mutex> lock {mutex_};
+    wake_.wait(lock, [&]{ return stop_ || generation_ != seen; });
+    if (stop_)
+      return;
+    seen = generation_;
+    auto job = job_;
+    auto func = func_;
+    int parts = parts_;
+    int size = size_;
+    lock.unlock();
+
+    Execute(num, job, func, parts, size);
+
+    lock.lock();
+    if (--busy_ == 0)
+      done_.notify_one();
+  }
+}
+
+// Calls job for parts num, num + Count(), ... of range [0; size)
+
+void Workers::Execute(
+  int num, Job job, void* func, int parts, int size) const
+{
+  int chunk = (size + parts - 1) / parts;
+  for (int part = num; part < parts; part += Count())
+  {
+    int begin = std::min(size, part * chunk);
+    int end = std::min(size, begin + chunk);
+    job(func, part, begin, end);
+  }
+}
+
+} // namespace anshub
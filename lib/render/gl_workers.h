@@ -0,0 +1,90 @@
+// *************************************************************
+// File:    gl_workers.h
+// Descr:   persistent pool of worker threads
+// Author:  Novoselov Anton @ 2017
+// *************************************************************
+
+#ifndef GC_GL_WORKERS_H
+#define GC_GL_WORKERS_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <type_traits>
+#include <algorithm>
+
+namespace anshub {
+
+//****************************************************************************
+// Pool of worker threads which are created once and sleep between calls.
+// Work is given as count of parts of range [0; size), and each part is
+// processed by one thread (the caller takes its share too). The shared pool
+// is used by all render modules which process data in parallel (see note #1)
+//****************************************************************************
+
+class Workers
+{
+public:
+  using Job = void (*)(void* func, int part, int begin, int end);
+
+  static Workers& Shared();
+
+  explicit Workers(int threads);
+  ~Workers();
+  Workers(const Workers&) =delete;
+  Workers& operator=(const Workers&) =delete;
+
+  int   Count() const { return threads_.size() + 1; }
+  void  Run(int parts, int size, Job, void* func);
+
+  template<class Func>
+  void  ForRanges(int parts, int size, Func&& func);
+
+private:
+  std::vector<std::thread> threads_;
+  std::mutex  run_;             // serializes callers of Run()
+  std::mutex  mutex_;           // guards fields below
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  Job         job_;
+  void*       func_;
+  int         parts_;
+  int         size_;
+  int         busy_;            // workers which haven`t finished the job
+  unsigned    generation_;      // number of the current job
+  bool        stop_;
+
+  void  Loop(int num);
+  void  Execute(int num, Job, void* func, int parts, int size) const;
+
+}; // class Workers
+
+//****************************************************************************
+// Inline implementation
+//****************************************************************************
+
+// Splits [0; size) into parts equal ranges and calls func(part, begin, end)
+// for each range. Returns when all ranges are processed
+
+template<class Func>
+inline void Workers::ForRanges(int parts, int size, Func&& func)
+{
+  using F = typename std::remove_reference<Func>::type;
+
+  Run(parts, size, [](void* f, int part, int begin, int end)
+  {
+    (*static_cast<F*>(f))(part, begin, end);
+  }, const_cast<void*>(static_cast<const void*>(&func)));
+}
+
+}  // namespace anshub
+
+#endif  // GC_GL_WORKERS_H
+
+// Note #1 : creating threads for each pass costs some tens of microseconds,
+//  and a frame has a dozen of such passes. Here threads are woken by
+//  condition variable instead. Part k is processed by thread k % Count(),
+//  and the caller waits until all workers have seen the job, thus a slow
+//  worker never takes part of the next job. Run() shouldn`t be called from
+//  inside of the job
@@ -9,8 +9,10 @@
 
 #include <vector>
 #include <algorithm>
+#include <cstring>
 
 #include "gl_aliases.h"
+#include "gl_buf_layout.h"
 
 namespace anshub {
 
@@ -24,23 +26,28 @@ struct ZBuffer
   : w_{w}
   , h_{h}
   , writed_{0}
-  , data_(w_ * h_, 0.0f) { }
+  , layout_{w_, h_, false}
+  , data_(layout_.Size(), 0.0f) { }
 
   void    Clear();
+  void    SetTiled(bool);
   void    Writed() { ++writed_; }
   int     GetWrited() const { return writed_; }
   int     Width() const { return w_; }
   int     Height() const { return h_; }
+  bool    IsTiled() const { return layout_.IsTiled(); }
   float*  GetPointer() { return data_.data(); }
+  const BufLayout& Layout() const { return layout_; }
   
-  float&  operator()(int x, int y) { return data_[y * w_ + x]; }
-  const float& operator()(int x, int y) const { return data_[y * w_ + x]; }
+  float&  operator()(int x, int y) { return data_[layout_.Index(x, y)]; }
+  const float& operator()(int x, int y) const { return data_[layout_.Index(x, y)]; }
 
 private:
   int w_;
   int h_;
   int writed_;    // debug info how much pixels was writed during frame
-  V_Float data_;
+  BufLayout layout_;
+  V_Float data_;  // 1/z values (in layout_ order)
 
 }; // struct ZBuffer
 
@@ -53,10 +60,21 @@ private:
 inline void ZBuffer::Clear()
 {
   writed_ = 0;
-  memset(data_.data(), 0.0f, w_*h_*sizeof(*data_.data()));
+  memset(data_.data(), 0.0f, data_.size()*sizeof(*data_.data()));
   // forced to use memset instead std::fill after profiling
 }
 
+// Switches memory layout between linear and 8x8 tiles (content is dropped).
+// Rasterizers expect the same layout in zbuffer and screen buffer
+
+inline void ZBuffer::SetTiled(bool tiled)
+{
+  if (tiled == layout_.IsTiled())
+    return;
+  layout_ = BufLayout(w_, h_, tiled);
+  data_.assign(layout_.Size(), 0.0f);
+}
+
 }  // namespace anshub
 
 #endif  // GL_Z_BUFFER_H
\ No newline at end of file
@@ -56,6 +56,22 @@ void LightPoint::World2Camera(const GlCamera& cam, const TrigTable& trig)
   coords::RotateRoll(position_, -cam.dir_.z, trig);
 }
 
+// Inverse of World2Camera(), used when light is given in camera coordinates
+// (i.e. attached to the camera), but objects are lighted in world coords
+
+void LightPoint::Camera2World(const GlCamera& cam, const TrigTable& trig)
+{
+  coords::RotateRoll(direction_, cam.dir_.z, trig);
+  coords::RotatePitch(direction_, cam.dir_.x, trig);
+  coords::RotateYaw(direction_, cam.dir_.y, trig);
+  direction_.Normalize();
+
+  coords::RotateRoll(position_, cam.dir_.z, trig);
+  coords::RotatePitch(position_, cam.dir_.x, trig);
+  coords::RotateYaw(position_, cam.dir_.y, trig);
+  position_ += cam.vrp_;
+}
+
 FColor LightPoint::Illuminate() const
 {
   auto dir = direction_ * (-1);
@@ -40,6 +40,7 @@ struct LightPoint : public LightSource<PointArgs>
   
   void   Reset() override;
   void   World2Camera(const GlCamera&, const TrigTable&) override;
+  void   Camera2World(const GlCamera&, const TrigTable&);
   FColor Illuminate() const override;
   
   auto   GetPosition() const { return position_; }